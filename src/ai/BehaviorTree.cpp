@@ -1 +1,342 @@
-﻿
\ No newline at end of file
+﻿#include "BehaviorTree.h"
+#include "../ecs/Components.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace Nightfall {
+
+// ========== BlackboardArena ==========
+
+std::uint32_t BlackboardArena::allocate(std::uint16_t size) {
+    m_used += size;
+
+    auto it = m_freeBlocks.find(size);
+    if (it != m_freeBlocks.end() && !it->second.empty()) {
+        const std::uint32_t offset = it->second.back();
+        it->second.pop_back();
+        std::fill_n(m_slots.begin() + offset, size, 0.f);
+        return offset;
+    }
+
+    const auto offset = static_cast<std::uint32_t>(m_slots.size());
+    m_slots.resize(m_slots.size() + size, 0.f);
+    return offset;
+}
+
+void BlackboardArena::release(std::uint32_t offset, std::uint16_t size) {
+    if (size == 0) return;
+    m_used -= size;
+    m_freeBlocks[size].push_back(offset);
+}
+
+// ========== BehaviorTreeEngine ==========
+
+BehaviorTreeEngine::BehaviorTreeEngine() {
+    // 内置叶子
+    registerLeaf("succeed", [](BehaviorBatch& batch) {
+        std::fill_n(batch.results, batch.count, BehaviorStatus::Success);
+    });
+
+    registerLeaf("fail", [](BehaviorBatch& batch) {
+        std::fill_n(batch.results, batch.count, BehaviorStatus::Failure);
+    });
+
+    // 等待 value 秒（计时放在黑板的 slot 里）
+    registerLeaf("wait", [](BehaviorBatch& batch) {
+        const int slot = batch.node.slot;
+        for (size_t i = 0; i < batch.count; ++i) {
+            float& timer = batch.blackboards[i][slot];
+            timer += batch.deltaTime;
+            if (timer >= batch.node.value) {
+                timer = 0.f;
+                batch.results[i] = BehaviorStatus::Success;
+            } else {
+                batch.results[i] = BehaviorStatus::Running;
+            }
+        }
+    }, true);
+}
+
+void BehaviorTreeEngine::init(Registry& registry) {
+    registry.raw().on_destroy<BehaviorAgent>().connect<&BehaviorTreeEngine::onAgentDestroyed>(*this);
+}
+
+void BehaviorTreeEngine::registerLeaf(const std::string& name, BehaviorLeaf leaf, bool usesSlot) {
+    auto it = m_leafIds.find(name);
+    if (it != m_leafIds.end()) {
+        m_leaves[it->second] = std::move(leaf);
+        m_leafUsesSlot[it->second] = usesSlot;
+        return;
+    }
+
+    m_leafIds.emplace(name, static_cast<std::uint16_t>(m_leaves.size()));
+    m_leaves.push_back(std::move(leaf));
+    m_leafUsesSlot.push_back(usesSlot);
+}
+
+bool BehaviorTreeEngine::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        NF_WARN("Behavior tree file not found: {}", path);
+        return false;
+    }
+
+    try {
+        nlohmann::json data;
+        file >> data;
+        return load(data);
+    } catch (const std::exception& e) {
+        NF_ERROR("Failed to parse behavior trees ({}): {}", path, e.what());
+        return false;
+    }
+}
+
+bool BehaviorTreeEngine::load(const nlohmann::json& data) {
+    bool ok = true;
+
+    if (data.contains("trees")) {
+        for (const auto& [name, definition] : data["trees"].items()) {
+            BehaviorTree tree;
+            if (!build(name, definition, tree)) {
+                ok = false;
+                continue;
+            }
+
+            auto it = m_treeIds.find(name);
+            if (it != m_treeIds.end()) {
+                m_trees[it->second] = std::move(tree);
+            } else {
+                m_treeIds.emplace(name, static_cast<int>(m_trees.size()));
+                m_trees.push_back(std::move(tree));
+            }
+        }
+    }
+
+    if (data.contains("archetypes")) {
+        for (const auto& [archetype, treeName] : data["archetypes"].items()) {
+            auto it = m_treeIds.find(treeName.get<std::string>());
+            if (it == m_treeIds.end()) {
+                NF_ERROR("Archetype '{}' refers to unknown behavior tree '{}'", archetype, treeName.get<std::string>());
+                ok = false;
+                continue;
+            }
+            m_archetypes[archetype] = it->second;
+        }
+    }
+
+    NF_INFO("Behavior trees loaded: {} trees, {} archetypes", m_trees.size(), m_archetypes.size());
+    return ok;
+}
+
+int BehaviorTreeEngine::countLeaves(const nlohmann::json& node) {
+    const std::string type = node.value("type", "leaf");
+    if (type == "leaf") return 1;
+
+    int count = 0;
+    if (node.contains("children")) {
+        for (const auto& child : node["children"]) {
+            count += countLeaves(child);
+        }
+    }
+    if (node.contains("child")) {
+        count += countLeaves(node["child"]);
+    }
+    return count;
+}
+
+bool BehaviorTreeEngine::build(const std::string& name, const nlohmann::json& definition, BehaviorTree& tree) {
+    tree.name = name;
+    tree.slotNames = definition.value("blackboard", std::vector<std::string>{});
+    if (!definition.contains("root")) {
+        NF_ERROR("Behavior tree '{}' has no root", name);
+        return false;
+    }
+
+    const int leafCount = countLeaves(definition["root"]);
+    if (leafCount == 0 || leafCount > 0xFFFF) {
+        NF_ERROR("Behavior tree '{}' has an invalid leaf count ({})", name, leafCount);
+        return false;
+    }
+
+    tree.nodes.assign(static_cast<size_t>(leafCount), BehaviorNode{});
+    return compile(definition["root"], tree, 0, -1, -1);
+}
+
+bool BehaviorTreeEngine::compile(const nlohmann::json& node, BehaviorTree& tree, int first, std::int32_t onSuccess,
+                                 std::int32_t onFailure) {
+    const std::string type = node.value("type", "leaf");
+
+    if (type == "leaf") {
+        const std::string leafName = node.value("name", "");
+        auto leaf = m_leafIds.find(leafName);
+        if (leaf == m_leafIds.end()) {
+            NF_ERROR("Behavior tree '{}': unknown leaf '{}'", tree.name, leafName);
+            return false;
+        }
+
+        BehaviorNode& compiled = tree.nodes[first];
+        compiled.leaf = leaf->second;
+        compiled.value = node.value("value", 0.f);
+        compiled.onSuccess = onSuccess;
+        compiled.onFailure = onFailure;
+
+        if (node.contains("slot")) {
+            const std::string slotName = node["slot"].get<std::string>();
+            auto slot = std::find(tree.slotNames.begin(), tree.slotNames.end(), slotName);
+            if (slot == tree.slotNames.end()) {
+                NF_ERROR("Behavior tree '{}': unknown blackboard slot '{}'", tree.name, slotName);
+                return false;
+            }
+            compiled.slot = static_cast<std::int16_t>(slot - tree.slotNames.begin());
+        }
+
+        // 叶子函数直接按槽位下标读写黑板，这里保证下标有效
+        if (m_leafUsesSlot[leaf->second] &&
+            (compiled.slot < 0 || compiled.slot >= static_cast<int>(tree.slotNames.size()))) {
+            NF_ERROR("Behavior tree '{}': leaf '{}' requires a blackboard slot", tree.name, leafName);
+            return false;
+        }
+        return true;
+    }
+
+    // 装饰节点：只改写子树的跳转目标
+    if (type == "inverter" || type == "succeeder") {
+        if (!node.contains("child")) {
+            NF_ERROR("Behavior tree '{}': {} without child", tree.name, type);
+            return false;
+        }
+        return type == "inverter"
+            ? compile(node["child"], tree, first, onFailure, onSuccess)
+            : compile(node["child"], tree, first, onSuccess, onSuccess);
+    }
+
+    if (type != "sequence" && type != "selector") {
+        NF_ERROR("Behavior tree '{}': unknown node type '{}'", tree.name, type);
+        return false;
+    }
+
+    // sequence：子节点成功则继续下一个，失败则整个失败；selector 相反
+    const auto& children = node["children"];
+    int childFirst = first;
+    for (size_t i = 0; i < children.size(); ++i) {
+        const int childLeaves = countLeaves(children[i]);
+        const bool last = (i + 1 == children.size());
+        const std::int32_t next = last ? -1 : childFirst + childLeaves;
+
+        const bool ok = type == "sequence"
+            ? compile(children[i], tree, childFirst, last ? onSuccess : next, onFailure)
+            : compile(children[i], tree, childFirst, onSuccess, last ? onFailure : next);
+        if (!ok) return false;
+
+        childFirst += childLeaves;
+    }
+    return true;
+}
+
+int BehaviorTreeEngine::findArchetype(const std::string& archetype) const {
+    auto it = m_archetypes.find(archetype);
+    if (it == m_archetypes.end()) {
+        it = m_archetypes.find("default");
+    }
+    return it != m_archetypes.end() ? it->second : -1;
+}
+
+const BehaviorTree* BehaviorTreeEngine::getTree(int tree) const {
+    return tree >= 0 && tree < static_cast<int>(m_trees.size()) ? &m_trees[tree] : nullptr;
+}
+
+void BehaviorTreeEngine::attach(Registry& registry, entt::entity entity, int tree) {
+    const BehaviorTree* definition = getTree(tree);
+    if (!definition) return;
+
+    // 旧黑板由 on_destroy 信号（onAgentDestroyed）回收
+    if (registry.hasComponent<BehaviorAgent>(entity)) {
+        registry.removeComponent<BehaviorAgent>(entity);
+    }
+
+    BehaviorAgent agent;
+    agent.tree = static_cast<std::uint16_t>(tree);
+    agent.node = 0;
+    agent.blackboardSize = static_cast<std::uint16_t>(definition->slotNames.size());
+    agent.blackboard = m_arena.allocate(agent.blackboardSize);
+    registry.addComponent<BehaviorAgent>(entity, agent);
+}
+
+void BehaviorTreeEngine::onAgentDestroyed(entt::registry& registry, entt::entity entity) {
+    const auto& agent = registry.get<BehaviorAgent>(entity);
+    m_arena.release(agent.blackboard, agent.blackboardSize);
+}
+
+void BehaviorTreeEngine::tick(Registry& registry, float deltaTime) {
+    const auto tickStart = std::chrono::steady_clock::now();
+    m_stats = BehaviorTreeStats{};
+    if (m_trees.empty()) return;
+
+    // 按当前叶子分桶
+    m_buckets.resize(m_trees.size());
+    for (size_t t = 0; t < m_trees.size(); ++t) {
+        m_buckets[t].resize(m_trees[t].nodes.size());
+        for (auto& bucket : m_buckets[t]) {
+            bucket.clear();
+        }
+    }
+
+    auto view = registry.view<BehaviorAgent>();
+    for (auto entity : view) {
+        auto& agent = view.get<BehaviorAgent>(entity);
+        if (agent.tree >= m_trees.size()) continue;
+        if (agent.node >= m_trees[agent.tree].nodes.size()) agent.node = 0;
+
+        m_buckets[agent.tree][agent.node].push_back(entity);
+        ++m_stats.agents;
+    }
+
+    // 按叶子顺序扫描：跳转目标总在后面，完成的实体在本次扫描中继续执行后续叶子
+    for (size_t t = 0; t < m_trees.size(); ++t) {
+        const BehaviorTree& tree = m_trees[t];
+        auto& buckets = m_buckets[t];
+
+        for (size_t i = 0; i < tree.nodes.size(); ++i) {
+            auto& bucket = buckets[i];
+            if (bucket.empty()) continue;
+
+            const BehaviorNode& node = tree.nodes[i];
+            const size_t count = bucket.size();
+            m_batchBlackboards.resize(count);
+            m_batchResults.assign(count, BehaviorStatus::Failure);
+            for (size_t k = 0; k < count; ++k) {
+                m_batchBlackboards[k] = m_arena.get(view.get<BehaviorAgent>(bucket[k]).blackboard);
+            }
+
+            BehaviorBatch batch{registry, deltaTime, node, bucket.data(), m_batchBlackboards.data(),
+                                m_batchResults.data(), count};
+            m_leaves[node.leaf](batch);
+            ++m_stats.batches;
+            m_stats.leafRuns += count;
+
+            for (size_t k = 0; k < count; ++k) {
+                auto& agent = view.get<BehaviorAgent>(bucket[k]);
+                const BehaviorStatus status = m_batchResults[k];
+                if (status == BehaviorStatus::Running) {
+                    agent.node = static_cast<std::uint16_t>(i);
+                    continue;
+                }
+
+                // 整棵树结束时下一次从入口重新开始
+                const std::int32_t next = status == BehaviorStatus::Success ? node.onSuccess : node.onFailure;
+                if (next < 0) {
+                    agent.node = 0;
+                } else {
+                    agent.node = static_cast<std::uint16_t>(next);
+                    buckets[next].push_back(bucket[k]);
+                }
+            }
+        }
+    }
+
+    m_stats.tickMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tickStart).count();
+}
+
+} // namespace Nightfall
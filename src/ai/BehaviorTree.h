@@ -1 +1,180 @@
-﻿
\ No newline at end of file
+﻿#pragma once
+
+#include "../ecs/Registry.h"
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nightfall {
+
+/// 叶子节点的执行结果
+enum class BehaviorStatus : std::uint8_t {
+    Success,
+    Failure,
+    Running
+};
+
+/// 行为树统计（每次 tick 更新）
+struct BehaviorTreeStats {
+    size_t agents{0};        // 挂着行为树的实体数
+    size_t batches{0};       // 本次 tick 调用叶子函数的批次数
+    size_t leafRuns{0};      // 本次 tick 执行的叶子次数（所有实体合计）
+    float tickMs{0.f};
+};
+
+/**
+ * @brief 展开后的叶子节点
+ *
+ * 组合节点（sequence / selector）和装饰节点（inverter / succeeder）在构建时消解为跳转目标：
+ * 每个叶子记录成功、失败后下一个要执行的叶子。叶子按前序排列，跳转目标总在当前叶子之后。
+ */
+struct BehaviorNode {
+    std::uint16_t leaf{0};      // 叶子函数编号
+    std::int16_t slot{-1};      // 使用的黑板槽位（-1 表示不用）
+    float value{0.f};           // 参数（距离、时长、阈值等）
+    std::int32_t onSuccess{-1}; // 成功后跳转的叶子（< 0 表示整棵树结束）
+    std::int32_t onFailure{-1}; // 失败后跳转的叶子
+};
+
+/// 一棵构建好的行为树（每个原型一棵，所有实体共享）
+struct BehaviorTree {
+    std::string name;
+    std::vector<BehaviorNode> nodes;          // 连续的叶子数组，0 为入口
+    std::vector<std::string> slotNames;       // 黑板槽位名（每个实体一份 float）
+};
+
+/**
+ * @brief 一批处于同一叶子的实体
+ *
+ * 叶子函数一次处理整批：读 entities / blackboards，把结果写进 results（与 entities 一一对应）。
+ */
+struct BehaviorBatch {
+    Registry& registry;
+    float deltaTime;
+    const BehaviorNode& node;
+    const entt::entity* entities;
+    float* const* blackboards;    // 每个实体的黑板（node.slot 为槽位下标）
+    BehaviorStatus* results;
+    size_t count;
+};
+
+using BehaviorLeaf = std::function<void(BehaviorBatch&)>;
+
+/**
+ * @brief 黑板内存池 - 所有实体的黑板放在一块连续的 float 数组里
+ *
+ * 按大小分类回收，释放的块由同样大小的黑板复用；不为单个实体做堆分配。
+ * 分配可能使已取得的指针失效，tick 期间不分配。
+ */
+class BlackboardArena {
+public:
+    /// 分配 size 个槽位（初始化为 0），返回偏移
+    std::uint32_t allocate(std::uint16_t size);
+
+    /// 归还 allocate 返回的块
+    void release(std::uint32_t offset, std::uint16_t size);
+
+    float* get(std::uint32_t offset) { return m_slots.data() + offset; }
+
+    /// 已占用的槽位数（不含空闲块）
+    size_t getUsedSlots() const { return m_used; }
+
+private:
+    std::vector<float> m_slots;
+    std::unordered_map<std::uint16_t, std::vector<std::uint32_t>> m_freeBlocks;   // 大小 -> 空闲偏移
+    size_t m_used{0};
+};
+
+/**
+ * @brief 行为树引擎 - 面向数据的行为树
+ *
+ * - 树从 JSON 构建一次，展开为连续的叶子数组（见 BehaviorNode），原型按名字映射到树
+ * - 每个实体只有一个 BehaviorAgent 组件（树、当前叶子、黑板偏移），黑板在 BlackboardArena 里
+ * - tick 按叶子批处理：先把实体按当前叶子分桶，再按叶子顺序扫描一遍，同一叶子上的实体一起执行，
+ *   完成的实体直接落入后面叶子的桶里，同一次 tick 内继续执行；Running 的实体下次从原叶子继续
+ * - 叶子函数可以读写组件，但不能创建、销毁实体或增删 BehaviorAgent
+ *
+ * JSON 格式：
+ * @code
+ * {
+ *   "trees": {
+ *     "villager": {
+ *       "blackboard": ["timer"],
+ *       "root": {"type": "selector", "children": [
+ *         {"type": "sequence", "children": [
+ *           {"type": "leaf", "name": "is_player_far", "value": 250},
+ *           {"type": "leaf", "name": "follow_player", "value": 120}
+ *         ]},
+ *         {"type": "leaf", "name": "wait", "value": 1.5, "slot": "timer"}
+ *       ]}
+ *     }
+ *   },
+ *   "archetypes": {"default": "villager"}
+ * }
+ * @endcode
+ * 节点类型：sequence、selector、inverter、succeeder（各一个子节点）、leaf。
+ */
+class BehaviorTreeEngine {
+public:
+    BehaviorTreeEngine();
+
+    /// 监听 BehaviorAgent 的销毁以回收黑板（只能绑定一个 Registry）
+    void init(Registry& registry);
+
+    /// 注册叶子函数（必须在加载树之前）；usesSlot 为 true 时树里的该叶子必须指定黑板槽位
+    void registerLeaf(const std::string& name, BehaviorLeaf leaf, bool usesSlot = false);
+
+    /// 从 JSON 文件加载树和原型映射，失败时返回 false
+    bool loadFromFile(const std::string& path);
+
+    /// 从 JSON 对象加载（已有同名的树会被替换）
+    bool load(const nlohmann::json& data);
+
+    /// 原型对应的树（找不到时退回 "default" 原型，仍没有则返回 -1）
+    int findArchetype(const std::string& archetype) const;
+
+    /// 给实体挂上树（已有则替换），黑板清零，从入口叶子开始
+    void attach(Registry& registry, entt::entity entity, int tree);
+
+    /// 执行所有实体的行为树
+    void tick(Registry& registry, float deltaTime);
+
+    const BehaviorTree* getTree(int tree) const;
+    size_t getTreeCount() const { return m_trees.size(); }
+    const BehaviorTreeStats& getStats() const { return m_stats; }
+
+private:
+    /// 子树中的叶子数
+    static int countLeaves(const nlohmann::json& node);
+
+    /**
+     * @brief 展开子树：叶子从 first 开始按前序编号
+     * @param onSuccess / onFailure 子树成功、失败后跳转的叶子
+     */
+    bool compile(const nlohmann::json& node, BehaviorTree& tree, int first, std::int32_t onSuccess,
+                 std::int32_t onFailure);
+
+    bool build(const std::string& name, const nlohmann::json& definition, BehaviorTree& tree);
+
+    void onAgentDestroyed(entt::registry& registry, entt::entity entity);
+
+    std::vector<BehaviorLeaf> m_leaves;
+    std::vector<bool> m_leafUsesSlot;
+    std::unordered_map<std::string, std::uint16_t> m_leafIds;
+    std::vector<BehaviorTree> m_trees;
+    std::unordered_map<std::string, int> m_treeIds;
+    std::unordered_map<std::string, int> m_archetypes;
+
+    BlackboardArena m_arena;
+
+    // tick 用的缓冲：m_buckets[树][叶子] 为当前位于该叶子的实体
+    std::vector<std::vector<std::vector<entt::entity>>> m_buckets;
+    std::vector<float*> m_batchBlackboards;
+    std::vector<BehaviorStatus> m_batchResults;
+    BehaviorTreeStats m_stats;
+};
+
+} // namespace Nightfall
@@ -1 +1,325 @@
-﻿
\ No newline at end of file
+﻿#include "NPCController.h"
+#include "../ecs/Components.h"
+#include "../systems/ResourceSystem.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Nightfall {
+
+namespace {
+
+/// 职业默认的优先级面板（修理、采集、补料）
+void setDefaultPriorities(Worker& worker, NPC::Profession profession) {
+    std::uint8_t repair = 1, harvest = 1, refill = 1;
+    switch (profession) {
+        case NPC::Profession::Builder:  repair = 3; break;
+        case NPC::Profession::Farmer:   harvest = 3; break;
+        case NPC::Profession::Engineer: refill = 3; repair = 2; break;
+        case NPC::Profession::Soldier:  repair = harvest = refill = 0; break;   // 士兵只负责守卫
+        default: break;
+    }
+    worker.priorities[static_cast<size_t>(JobType::Repair)] = repair;
+    worker.priorities[static_cast<size_t>(JobType::Harvest)] = harvest;
+    worker.priorities[static_cast<size_t>(JobType::Refill)] = refill;
+}
+
+} // namespace
+
+NPCController::NPCController() {
+}
+
+NPCController::~NPCController() {
+    NF_INFO("NPC controller shutdown");
+}
+
+void NPCController::init(Registry& registry) {
+    auto& raw = registry.raw();
+    raw.on_destroy<Worker>().connect<&NPCController::onWorkerDestroyed>(*this);
+    raw.on_destroy<Building>().connect<&NPCController::onTargetDestroyed<JobType::Repair>>(*this);
+    raw.on_destroy<ResourceNode>().connect<&NPCController::onTargetDestroyed<JobType::Harvest>>(*this);
+    raw.on_destroy<Producer>().connect<&NPCController::onTargetDestroyed<JobType::Refill>>(*this);
+
+    NF_INFO("NPC controller initialized");
+}
+
+void NPCController::setSearchSettings(float searchRadius, int candidatesPerType) {
+    m_searchRadius = std::max(1.f, searchRadius);
+    m_candidatesPerType = static_cast<size_t>(std::max(1, candidatesPerType));
+}
+
+void NPCController::setWorkSettings(float workRange, float repairRate, float refillTime, float repairThreshold) {
+    m_workRange = std::max(1.f, workRange);
+    m_repairRate = std::max(0.f, repairRate);
+    m_refillTime = std::max(0.f, refillTime);
+    m_repairThreshold = std::clamp(repairThreshold, 0.f, 1.f);
+}
+
+void NPCController::update(float, Registry& registry) {
+    const auto updateStart = std::chrono::steady_clock::now();
+    m_stats.idleWorkers = 0;
+    m_stats.assignedThisFrame = 0;
+
+    attachWorkers(registry);
+    refreshJobs(registry);
+    assignJobs(registry);
+
+    for (size_t type = 0; type < kJobTypeCount; ++type) {
+        m_stats.openJobs[type] = m_jobs[type].size();
+    }
+    m_stats.claimedJobs = m_claims.size();
+    m_stats.assignMs =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
+}
+
+void NPCController::attachWorkers(Registry& registry) {
+    auto view = registry.view<NPC>(entt::exclude<Worker>);
+    m_newWorkers.assign(view.begin(), view.end());
+    for (auto entity : m_newWorkers) {
+        auto& worker = registry.addComponent<Worker>(entity);
+        setDefaultPriorities(worker, registry.getComponent<NPC>(entity).profession);
+    }
+}
+
+void NPCController::refreshJobs(Registry& registry) {
+    // 修理 / 补料：已完成的建筑
+    auto buildingView = registry.view<Building, Transform>();
+    for (auto entity : buildingView) {
+        const auto& building = buildingView.get<Building>(entity);
+        const sf::Vector2f& position = buildingView.get<Transform>(entity).position;
+        const bool claimed = m_claims.count(entity) != 0;
+
+        const bool damaged = building.isComplete && building.durability < building.maxDurability * m_repairThreshold;
+        setOpen(JobType::Repair, entity, damaged && !claimed, position);
+
+        if (const auto* producer = registry.tryGetComponent<Producer>(entity)) {
+            setOpen(JobType::Refill, entity, building.isComplete && !producer->isActive && !claimed, position);
+        }
+    }
+
+    // 采集：未耗尽的资源点
+    auto nodeView = registry.view<ResourceNode, Transform>();
+    for (auto entity : nodeView) {
+        const auto& node = nodeView.get<ResourceNode>(entity);
+        const bool available = !node.isDepleted && node.resourceAmount > 0;
+        setOpen(JobType::Harvest, entity, available && !m_claims.count(entity), nodeView.get<Transform>(entity).position);
+    }
+}
+
+void NPCController::setOpen(JobType type, entt::entity target, bool open, const sf::Vector2f& position) {
+    if (open) {
+        jobs(type).insertOrUpdate(target, sf::FloatRect(position, {0.f, 0.f}));
+    } else {
+        jobs(type).remove(target);
+    }
+}
+
+void NPCController::assignJobs(Registry& registry) {
+    m_candidates.clear();
+
+    // 行军中的 NPC 放下工作，不参与分配
+    auto marching = registry.view<Worker, SquadMember>();
+    for (auto entity : marching) {
+        release(marching.get<Worker>(entity));
+    }
+
+    // 1. 每个空闲工作者在各类型中取最近的若干个开放工作作为候选
+    auto view = registry.view<Worker, Transform>(entt::exclude<SquadMember>);
+    for (auto entity : view) {
+        auto& worker = view.get<Worker>(entity);
+        if (worker.job != entt::null) {
+            // 目标已销毁或不再需要处理时放弃认领，重新参与分配
+            float urgency = 0.f;
+            if (isJobNeeded(registry, worker.jobType, worker.job, urgency)) continue;
+            release(worker);
+        }
+        ++m_stats.idleWorkers;
+
+        const sf::Vector2f& position = view.get<Transform>(entity).position;
+        for (size_t type = 0; type < kJobTypeCount; ++type) {
+            const std::uint8_t priority = worker.priorities[type];
+            if (priority == 0 || m_jobs[type].size() == 0) continue;
+
+            m_jobs[type].nearestK(position, m_searchRadius, m_candidatesPerType,
+                                  [](entt::entity) { return true; }, m_nearest);
+            for (const auto& [distSq, target] : m_nearest) {
+                float urgency = 0.f;
+                if (!isJobNeeded(registry, static_cast<JobType>(type), target, urgency)) continue;
+
+                // 优先级为主，紧迫度和距离修正
+                const float score = priority * (1.f + urgency) / (1.f + std::sqrt(distSq) / m_searchRadius);
+                m_candidates.push_back({score, entity, target, static_cast<JobType>(type)});
+            }
+        }
+    }
+
+    if (m_candidates.empty()) return;
+
+    // 2. 贪心匹配：分数从高到低，工作者和目标都还空闲时成交
+    std::sort(m_candidates.begin(), m_candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    for (const auto& candidate : m_candidates) {
+        auto& worker = view.get<Worker>(candidate.worker);
+        if (worker.job != entt::null || m_claims.count(candidate.target)) continue;
+
+        worker.job = candidate.target;
+        worker.jobType = candidate.type;
+        worker.progress = 0.f;
+        m_claims.emplace(candidate.target, candidate.worker);
+        jobs(candidate.type).remove(candidate.target);
+        ++m_stats.assignedThisFrame;
+    }
+}
+
+bool NPCController::isJobNeeded(Registry& registry, JobType type, entt::entity target, float& urgency) const {
+    if (!registry.isValid(target)) return false;
+
+    switch (type) {
+        case JobType::Repair: {
+            const auto* building = registry.tryGetComponent<Building>(target);
+            if (!building || !building->isComplete || building->durability >= building->maxDurability) return false;
+            urgency = 1.f - building->durability / building->maxDurability;
+            return true;
+        }
+        case JobType::Harvest: {
+            const auto* node = registry.tryGetComponent<ResourceNode>(target);
+            if (!node || node->isDepleted || node->resourceAmount <= 0) return false;
+            urgency = 0.5f;
+            return true;
+        }
+        case JobType::Refill: {
+            const auto* producer = registry.tryGetComponent<Producer>(target);
+            if (!producer || producer->isActive) return false;
+            urgency = 1.f;   // 停工的生产建筑
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void NPCController::work(BehaviorBatch& batch) {
+    Registry& registry = batch.registry;
+    const float workRangeSq = m_workRange * m_workRange;
+
+    for (size_t i = 0; i < batch.count; ++i) {
+        const entt::entity entity = batch.entities[i];
+        auto* worker = registry.tryGetComponent<Worker>(entity);
+        auto* transform = registry.tryGetComponent<Transform>(entity);
+        auto* velocity = registry.tryGetComponent<Velocity>(entity);
+        if (!worker || worker->job == entt::null || !transform || !velocity) {
+            batch.results[i] = BehaviorStatus::Failure;
+            continue;
+        }
+
+        // 目标被销毁或已不需要处理（如被玩家采空）
+        float urgency = 0.f;
+        if (!isJobNeeded(registry, worker->jobType, worker->job, urgency)) {
+            release(*worker);
+            batch.results[i] = BehaviorStatus::Failure;
+            continue;
+        }
+
+        // 先走到目标旁边
+        const sf::Vector2f offset = registry.getComponent<Transform>(worker->job).position - transform->position;
+        const float distSq = offset.x * offset.x + offset.y * offset.y;
+        if (distSq > workRangeSq) {
+            velocity->velocity = offset / std::sqrt(distSq) * velocity->maxSpeed;
+            batch.results[i] = BehaviorStatus::Running;
+            continue;
+        }
+
+        velocity->velocity = {0.f, 0.f};
+        if (performJob(registry, *worker, batch.deltaTime)) {
+            release(*worker);
+            batch.results[i] = BehaviorStatus::Success;
+        } else {
+            batch.results[i] = BehaviorStatus::Running;
+        }
+    }
+}
+
+void NPCController::eat(BehaviorBatch& batch) {
+    const int portion = std::max(1, static_cast<int>(batch.node.value));
+
+    for (size_t i = 0; i < batch.count; ++i) {
+        auto* hunger = batch.registry.tryGetComponent<Hunger>(batch.entities[i]);
+        if (!hunger || !m_resourceSystem || !m_resourceSystem->hasResource("food", portion)) {
+            batch.results[i] = BehaviorStatus::Failure;
+            continue;
+        }
+
+        m_resourceSystem->removeResource("food", portion);
+        hunger->current = hunger->maximum;
+        batch.results[i] = BehaviorStatus::Success;
+    }
+}
+
+bool NPCController::performJob(Registry& registry, Worker& worker, float deltaTime) {
+    worker.progress += deltaTime;
+
+    switch (worker.jobType) {
+        case JobType::Repair: {
+            auto& building = registry.getComponent<Building>(worker.job);
+            building.durability = std::min(building.maxDurability, building.durability + m_repairRate * deltaTime);
+            return building.durability >= building.maxDurability;
+        }
+        case JobType::Harvest: {
+            auto& node = registry.getComponent<ResourceNode>(worker.job);
+            if (worker.progress < node.harvestTime) return false;
+
+            const int amount = std::min(node.harvestAmount, node.resourceAmount);
+            node.resourceAmount -= amount;
+            if (m_resourceSystem) {
+                m_resourceSystem->addResource(node.resourceType, amount);
+            }
+
+            if (node.resourceAmount <= 0) {
+                node.isDepleted = true;
+                node.regenTimer = 0.f;
+                if (auto* sprite = registry.tryGetComponent<Sprite>(worker.job)) {
+                    sprite->color = sf::Color(100, 100, 100, 180);  // 变暗
+                }
+            }
+            return true;
+        }
+        case JobType::Refill: {
+            if (worker.progress < m_refillTime) return false;
+
+            auto& producer = registry.getComponent<Producer>(worker.job);
+            producer.isActive = true;
+            producer.productionTimer = 0.f;
+            producer.cyclesSinceRefill = 0;
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+void NPCController::release(Worker& worker) {
+    if (worker.job == entt::null) return;
+
+    // 仍需处理的目标在下一次刷新时重新开放
+    m_claims.erase(worker.job);
+    worker.job = entt::null;
+    worker.progress = 0.f;
+}
+
+void NPCController::onWorkerDestroyed(entt::registry& registry, entt::entity entity) {
+    auto& worker = registry.get<Worker>(entity);
+    auto it = m_claims.find(worker.job);
+    if (it != m_claims.end() && it->second == entity) {
+        m_claims.erase(it);
+    }
+}
+
+template<JobType Type>
+void NPCController::onTargetDestroyed(entt::registry&, entt::entity entity) {
+    // 认领关系在下一次分配时释放
+    jobs(Type).remove(entity);
+}
+
+} // namespace Nightfall
@@ -1 +1,128 @@
-﻿
\ No newline at end of file
+﻿#pragma once
+
+#include "BehaviorTree.h"
+#include "../ecs/Registry.h"
+#include "../ecs/SpatialGrid.h"
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace Nightfall {
+
+class ResourceSystem;
+enum class JobType : std::uint8_t;
+struct Worker;
+
+constexpr size_t kJobTypeCount = 3;   // JobType 的工作类型数（修理/采集/补料）
+
+/// 任务板统计（每个逻辑帧更新）
+struct JobBoardStats {
+    size_t openJobs[kJobTypeCount]{};   // 各类型尚未被认领的工作数
+    size_t claimedJobs{0};              // 已被认领的工作
+    size_t idleWorkers{0};              // 本帧参与分配的空闲工作者
+    size_t assignedThisFrame{0};        // 本帧新分配的工作
+    float assignMs{0.f};                // 本帧刷新与分配的耗时
+};
+
+/**
+ * @brief NPC 控制器 - 中央任务板与工作执行
+ *
+ * - 任务板：每种工作类型一个 SpatialGrid，只放尚未完成且未被认领的工作目标（受损建筑、
+ *   可采集的资源点、停工的生产建筑）。耐久、资源量等字段由各系统直接修改，不经过 registry 信号，
+ *   所以每帧扫一遍目标组件同步索引（只扫一次），分配时 NPC 只查附近的索引，不必各自扫描全部目标
+ * - 分配：每个逻辑帧批量进行一次。每个空闲工作者按优先级面板，在各类型的索引里取附近若干个
+ *   未被认领的目标作为候选，全部候选按（优先级、紧迫度、距离）打分后贪心匹配
+ * - 认领：分配即预留目标，一个目标同时只属于一个工作者，完成、失败或工作者销毁时释放
+ * - 执行：由行为树叶子 work_job 调用 work()，走到目标旁边后按工作类型结算
+ * - 进食：行为树叶子 eat 调用 eat()，消耗营地的食物储备
+ */
+class NPCController {
+public:
+    NPCController();
+    ~NPCController();
+
+    /// 监听工作者和工作目标的销毁（只能绑定一个 Registry）
+    void init(Registry& registry);
+
+    /// 刷新任务板并为空闲工作者分配工作（每个逻辑帧在 AI 之前调用一次）
+    void update(float deltaTime, Registry& registry);
+
+    void setResourceSystem(ResourceSystem* resourceSystem) { m_resourceSystem = resourceSystem; }
+
+    /**
+     * @brief 设置分配参数
+     * @param searchRadius 工作者寻找工作的最大半径
+     * @param candidatesPerType 每个工作者在每种类型中参与匹配的最近目标数
+     */
+    void setSearchSettings(float searchRadius, int candidatesPerType);
+
+    /**
+     * @brief 设置工作参数
+     * @param workRange 开始工作的距离
+     * @param repairRate 每秒修复的耐久
+     * @param refillTime 补料所需时间（秒）
+     * @param repairThreshold 耐久低于此比例的建筑才需要修理
+     */
+    void setWorkSettings(float workRange, float repairRate, float refillTime, float repairThreshold);
+
+    /// 行为树叶子：走向并执行认领的工作（没有工作时失败，完成时成功）
+    void work(BehaviorBatch& batch);
+
+    /// 行为树叶子：从营地储备中吃掉 value 份食物，饱食度回满（储备不足时失败）
+    void eat(BehaviorBatch& batch);
+
+    const JobBoardStats& getStats() const { return m_stats; }
+
+private:
+    /// 匹配候选（工作者 -> 目标）
+    struct Candidate {
+        float score;
+        entt::entity worker;
+        entt::entity target;
+        JobType type;
+    };
+
+    /// 给新出现的 NPC 挂上工作者组件（优先级按职业）
+    void attachWorkers(Registry& registry);
+
+    /// 每帧扫描建筑和资源点，按组件状态增删各类型的开放工作
+    void refreshJobs(Registry& registry);
+    void setOpen(JobType type, entt::entity target, bool open, const sf::Vector2f& position);
+
+    void assignJobs(Registry& registry);
+
+    /// 工作是否仍然需要做，以及它的紧迫度（0-1）
+    bool isJobNeeded(Registry& registry, JobType type, entt::entity target, float& urgency) const;
+
+    /// 结算一帧工作，完成时返回 true
+    bool performJob(Registry& registry, Worker& worker, float deltaTime);
+
+    void release(Worker& worker);
+
+    void onWorkerDestroyed(entt::registry& registry, entt::entity entity);
+    template<JobType Type>
+    void onTargetDestroyed(entt::registry& registry, entt::entity entity);
+
+    SpatialGrid& jobs(JobType type) { return m_jobs[static_cast<size_t>(type)]; }
+
+    ResourceSystem* m_resourceSystem{nullptr};
+
+    std::array<SpatialGrid, kJobTypeCount> m_jobs;         // 各类型未被认领的开放工作
+    std::unordered_map<entt::entity, entt::entity> m_claims;   // 目标 -> 认领的工作者
+
+    float m_searchRadius{800.f};
+    size_t m_candidatesPerType{4};
+    float m_workRange{40.f};
+    float m_repairRate{10.f};
+    float m_refillTime{3.f};
+    float m_repairThreshold{0.8f};
+
+    // 分配用的缓冲（每帧复用）
+    std::vector<entt::entity> m_newWorkers;
+    std::vector<Candidate> m_candidates;
+    std::vector<std::pair<float, entt::entity>> m_nearest;
+
+    JobBoardStats m_stats;
+};
+
+} // namespace Nightfall
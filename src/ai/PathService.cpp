@@ -0,0 +1,317 @@
+﻿#include "PathService.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace Nightfall {
+
+namespace {
+
+constexpr size_t kRequestCapacity = 8192;
+constexpr size_t kJobCapacity = 1024;
+constexpr size_t kSharedSearchStarts = 4;      // 同一目标的起点达到这个数量时改为从目标反向整体搜索
+constexpr int kJumpPointRange = 64;            // 起终点相距（格子数）不超过此值时用跳点搜索，否则用 HPA*
+constexpr float kResultLifetimeSeconds = 10.f; // 发布后无人领取的结果保留时间
+constexpr float kLatencySmoothing = 0.1f;
+
+} // namespace
+
+PathService::PathService()
+    : m_requests(kRequestCapacity)
+    , m_jobs(kJobCapacity)
+    , m_results(kJobCapacity) {
+}
+
+PathService::~PathService() {
+    shutdown();
+    NF_INFO("Path service shutdown");
+}
+
+void PathService::init(Pathfinder* pathfinder, int workerCount) {
+    shutdown();
+
+    m_pathfinder = pathfinder;
+    m_running = true;
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&PathService::workerLoop, this);
+    }
+
+    NF_INFO("Path service initialized ({} worker threads, {} jobs per frame)", workerCount, m_maxJobsPerFrame);
+}
+
+void PathService::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running = false;
+    }
+    m_wakeCondition.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    // 队列里只有裸指针，任务本身由 m_pendingJobs / m_inFlight 持有
+    Job* job;
+    while (m_jobs.pop(job)) {}
+    while (m_results.pop(job)) {}
+    Request request;
+    while (m_requests.pop(request)) {}
+
+    m_inFlight.clear();
+    m_pendingJobs.clear();
+    m_pendingByGoal.clear();
+    m_entries.clear();
+    m_released.clear();
+    m_drainedHandles = m_nextHandle.load(std::memory_order_acquire);
+    m_snapshot.reset();
+}
+
+void PathService::setFrameBudget(int maxJobsPerFrame, float maxInlineMs) {
+    m_maxJobsPerFrame = std::max(1, maxJobsPerFrame);
+    m_maxInlineMs = std::max(0.f, maxInlineMs);
+}
+
+PathHandle PathService::request(const sf::Vector2f& from, const sf::Vector2f& to) {
+    PathHandle handle = m_nextHandle.fetch_add(1, std::memory_order_relaxed);
+    if (handle == InvalidPathHandle) {
+        handle = m_nextHandle.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!m_requests.push(Request{handle, from, to, Clock::now()})) {
+        return InvalidPathHandle;
+    }
+    return handle;
+}
+
+PathStatus PathService::getStatus(PathHandle handle) const {
+    if (handle == InvalidPathHandle) return PathStatus::Invalid;
+
+    auto it = m_entries.find(handle);
+    if (it != m_entries.end()) return it->second.status;
+
+    // 还没被 sync 取出的请求仍在队列里；其余的已取走、已释放或从未发出
+    return isQueued(handle) && !m_released.count(handle) ? PathStatus::Pending : PathStatus::Invalid;
+}
+
+bool PathService::takeResult(PathHandle handle, std::vector<sf::Vector2f>& waypoints) {
+    waypoints.clear();
+
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end() || it->second.status == PathStatus::Pending) return false;
+
+    if (it->second.status == PathStatus::Ready) {
+        waypoints = std::move(it->second.waypoints);
+    }
+    m_entries.erase(it);
+    return true;
+}
+
+void PathService::release(PathHandle handle) {
+    if (handle == InvalidPathHandle) return;
+
+    // 已登记的直接删除（计算中的任务发布时会跳过它），还在队列里的等它出队时丢弃
+    if (!m_entries.erase(handle) && isQueued(handle)) {
+        m_released.insert(handle);
+    }
+}
+
+bool PathService::isQueued(PathHandle handle) const {
+    return handle >= m_drainedHandles && handle < m_nextHandle.load(std::memory_order_acquire);
+}
+
+void PathService::sync() {
+    m_stats.requestsThisFrame = 0;
+    m_stats.mergedThisFrame = 0;
+    m_stats.cacheHitsThisFrame = 0;
+    m_stats.dispatchedThisFrame = 0;
+    m_stats.completedThisFrame = 0;
+    m_stats.maxLatencyMs = 0.f;
+
+    if (!m_pathfinder) return;
+
+    // 导航数据变化后换用新快照；旧快照由仍在计算的任务持有
+    m_snapshot = m_pathfinder->getSnapshot();
+    m_stats.snapshotVersion = m_snapshot ? m_snapshot->version : 0;
+
+    // 1. 发布工作线程完成的结果
+    Job* job;
+    while (m_results.pop(job)) {
+        publish(*job);
+        m_inFlight.erase(job);
+    }
+
+    // 2. 取出新请求并按目标合并（同步点没有系统在发请求，水位之前的句柄都已入队）
+    m_drainedHandles = m_nextHandle.load(std::memory_order_acquire);
+    drainRequests();
+
+    // 3. 在预算内派发
+    dispatchJobs();
+
+    // 4. 清理长时间无人领取的结果（请求者可能已被销毁）
+    const auto now = Clock::now();
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const bool expired = it->second.status != PathStatus::Pending &&
+            std::chrono::duration<float>(now - it->second.completed).count() > kResultLifetimeSeconds;
+        it = expired ? m_entries.erase(it) : std::next(it);
+    }
+
+    m_stats.queuedJobs = m_pendingJobs.size();
+    m_stats.inFlightJobs = m_inFlight.size();
+}
+
+void PathService::drainRequests() {
+    Request request;
+    while (m_requests.pop(request)) {
+        ++m_stats.requestsThisFrame;
+        if (m_released.erase(request.handle)) continue;
+
+        Entry& entry = m_entries[request.handle];
+        entry.requested = request.time;
+
+        const int start = m_snapshot ? m_snapshot->grid.worldToIndex(request.from) : -1;
+        const int goal = m_snapshot ? m_snapshot->grid.worldToIndex(request.to) : -1;
+        if (start < 0 || goal < 0) {
+            entry.status = PathStatus::Failed;
+            entry.completed = Clock::now();
+            continue;
+        }
+
+        // 同一版本导航数据上算过的路线直接应答
+        if (const std::vector<int>* cached = m_cache.find(start, goal, m_snapshot->version)) {
+            resolve(entry, m_snapshot->grid, *cached, Clock::now());
+            ++m_stats.cacheHitsThisFrame;
+            continue;
+        }
+
+        // 同一目标格子的请求并入同一个尚未派发的任务，相同的起点只算一次
+        Job*& pending = m_pendingByGoal[goal];
+        if (!pending) {
+            m_pendingJobs.push_back(std::make_unique<Job>());
+            pending = m_pendingJobs.back().get();
+            pending->goal = goal;
+        } else {
+            ++m_stats.mergedThisFrame;
+        }
+
+        auto it = std::find(pending->starts.begin(), pending->starts.end(), start);
+        const int slot = static_cast<int>(it - pending->starts.begin());
+        if (it == pending->starts.end()) {
+            pending->starts.push_back(start);
+        }
+        pending->waiters.emplace_back(request.handle, slot);
+    }
+}
+
+void PathService::dispatchJobs() {
+    if (m_pendingJobs.empty()) return;
+
+    const auto start = Clock::now();
+    size_t dispatched = 0;
+
+    while (!m_pendingJobs.empty() && dispatched < static_cast<size_t>(m_maxJobsPerFrame)) {
+        Job* job = m_pendingJobs.front().get();
+        job->snapshot = m_snapshot;
+
+        if (m_workers.empty()) {
+            // 没有工作线程：在时间预算内同步计算（至少一个任务，保证有进展）
+            if (dispatched > 0 &&
+                std::chrono::duration<float, std::milli>(Clock::now() - start).count() >= m_maxInlineMs) {
+                break;
+            }
+            solve(*job, m_inlineSolver);
+            publish(*job);
+        } else {
+            if (m_inFlight.size() >= m_jobs.capacity() || !m_jobs.push(job)) break;
+            m_inFlight.emplace(job, std::move(m_pendingJobs.front()));
+        }
+
+        m_pendingByGoal.erase(job->goal);
+        m_pendingJobs.pop_front();
+        ++dispatched;
+    }
+
+    m_stats.dispatchedThisFrame = dispatched;
+
+    if (dispatched > 0 && !m_workers.empty()) {
+        // 先拿一次锁再通知，避免工作线程在检查条件和进入等待之间错过唤醒
+        { std::lock_guard<std::mutex> lock(m_wakeMutex); }
+        m_wakeCondition.notify_all();
+    }
+}
+
+void PathService::workerLoop() {
+    Solver solver;
+
+    while (true) {
+        Job* job = nullptr;
+        if (m_jobs.pop(job)) {
+            solve(*job, solver);
+            while (!m_results.push(job)) {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait(lock, [this] { return !m_running || m_jobs.sizeApprox() > 0; });
+        if (!m_running) break;
+    }
+}
+
+void PathService::solve(Job& job, Solver& solver) {
+    const NavGrid& grid = job.snapshot->grid;
+    job.paths.assign(job.starts.size(), {});
+
+    if (job.starts.size() >= kSharedSearchStarts) {
+        // 起点多：从目标反向一次搜索覆盖所有起点
+        const CellRect whole{0, 0, grid.getWidth() - 1, grid.getHeight() - 1};
+        solver.search.pathsToGoal(grid, job.goal, job.starts, whole, job.paths);
+        return;
+    }
+
+    const int width = grid.getWidth();
+    for (size_t i = 0; i < job.starts.size(); ++i) {
+        const int start = job.starts[i];
+        const int range = std::max(std::abs(start % width - job.goal % width), std::abs(start / width - job.goal / width));
+        if (range <= kJumpPointRange) {
+            float cost;
+            solver.jumpSearch.findPath(grid, start, job.goal, job.paths[i], cost);
+        } else {
+            job.snapshot->hierarchy.findPath(grid, start, job.goal, job.paths[i], solver.context);
+        }
+    }
+}
+
+void PathService::publish(Job& job) {
+    const auto now = Clock::now();
+    const NavGrid& grid = job.snapshot->grid;
+
+    for (size_t i = 0; i < job.starts.size(); ++i) {
+        m_cache.store(job.starts[i], job.goal, job.snapshot->version, job.paths[i]);
+    }
+
+    for (const auto& waiter : job.waiters) {
+        auto it = m_entries.find(waiter.first);
+        if (it == m_entries.end()) continue;   // 请求已被放弃
+
+        resolve(it->second, grid, job.paths[waiter.second], now);
+    }
+}
+
+void PathService::resolve(Entry& entry, const NavGrid& grid, const std::vector<int>& cells, Clock::time_point now) {
+    entry.status = cells.empty() ? PathStatus::Failed : PathStatus::Ready;
+    entry.waypoints.clear();
+    for (size_t i = 1; i < cells.size(); ++i) {
+        entry.waypoints.push_back(grid.cellCenter(cells[i]));
+    }
+    entry.completed = now;
+
+    const float latency = std::chrono::duration<float, std::milli>(now - entry.requested).count();
+    m_stats.maxLatencyMs = std::max(m_stats.maxLatencyMs, latency);
+    m_stats.averageLatencyMs = m_stats.averageLatencyMs > 0.f
+        ? m_stats.averageLatencyMs + (latency - m_stats.averageLatencyMs) * kLatencySmoothing
+        : latency;
+    ++m_stats.completedThisFrame;
+}
+
+} // namespace Nightfall
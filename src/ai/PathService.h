@@ -0,0 +1,175 @@
+﻿#pragma once
+
+#include "Pathfinding.h"
+#include "../utils/LockFreeQueue.h"
+#include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Nightfall {
+
+/// 寻路请求句柄（0 表示无效）
+using PathHandle = std::uint32_t;
+constexpr PathHandle InvalidPathHandle = 0;
+
+enum class PathStatus {
+    Invalid,   // 句柄无效或已释放
+    Pending,   // 排队或计算中
+    Ready,     // 已找到路径
+    Failed     // 不可达
+};
+
+/// 寻路服务的统计数据（每次 sync 更新）
+struct PathServiceStats {
+    size_t requestsThisFrame{0};     // 本帧收到的请求
+    size_t mergedThisFrame{0};       // 并入已有任务的请求（同一目标）
+    size_t cacheHitsThisFrame{0};    // 直接由路径缓存应答的请求
+    size_t dispatchedThisFrame{0};   // 本帧派发的任务
+    size_t completedThisFrame{0};    // 本帧发布结果的请求
+    size_t queuedJobs{0};            // 因预算限制仍在排队的任务
+    size_t inFlightJobs{0};          // 工作线程上的任务
+    float averageLatencyMs{0.f};     // 请求到结果发布的平均延迟（指数滑动平均）
+    float maxLatencyMs{0.f};         // 本帧发布的结果中最大的延迟
+    std::uint32_t snapshotVersion{0};
+};
+
+/**
+ * @brief 异步寻路服务 - 僵尸、NPC、阵型领队的寻路请求都经由这里，不在系统更新里同步计算
+ *
+ * 流程：
+ * - request() 可在任意线程调用：分配句柄，请求进入无锁队列
+ * - sync() 每个逻辑帧在主线程调用一次（同步点）：
+ *   发布工作线程完成的结果 → 取出新请求并按目标格子合并 → 在每帧预算内派发任务
+ * - 工作线程只读取任务携带的不可变导航快照（带版本号），不接触 ECS
+ * - 同一目标的多个起点合并为一个任务：起点较多时从目标反向做一次搜索，
+ *   否则逐个求解（近距离用跳点搜索，远距离用 HPA*）
+ * - 结果按 (起点格子, 目标格子, 快照版本) 进入 LRU 缓存，重复的路线在同步点直接应答
+ * - 超出每帧预算的任务留在队列里，下一帧继续派发，避免重帧卡顿
+ *
+ * 除 request() 外的接口只能在主线程调用。工作线程数为 0 时在 sync() 里按时间预算同步计算。
+ */
+class PathService {
+public:
+    PathService();
+    ~PathService();
+
+    /// 启动服务（workerCount 个工作线程）
+    void init(Pathfinder* pathfinder, int workerCount);
+
+    /// 停止工作线程并丢弃所有请求
+    void shutdown();
+
+    /// 设置每帧预算：最多派发的任务数，以及无工作线程时同步计算的时间上限（毫秒）
+    void setFrameBudget(int maxJobsPerFrame, float maxInlineMs);
+
+    /// 设置路径缓存容量（条目数，0 表示不缓存）
+    void setCacheCapacity(size_t capacity) { m_cache.setCapacity(capacity); }
+
+    /**
+     * @brief 发起寻路请求（线程安全）
+     * @return 请求队列已满时返回 InvalidPathHandle，调用方下一帧重试
+     */
+    PathHandle request(const sf::Vector2f& from, const sf::Vector2f& to);
+
+    /// 查询请求状态（已取走、已释放或从未发出的句柄返回 Invalid）
+    PathStatus getStatus(PathHandle handle) const;
+
+    /**
+     * @brief 取走结果并释放句柄
+     * @param waypoints Ready 时写入路点（格子中心，不含起点所在格子）
+     * @return 状态为 Ready 或 Failed 时返回 true
+     */
+    bool takeResult(PathHandle handle, std::vector<sf::Vector2f>& waypoints);
+
+    /// 放弃请求（结果到达后直接丢弃）
+    void release(PathHandle handle);
+
+    /// 同步点：发布结果、合并并派发新请求、更新统计
+    void sync();
+
+    const PathServiceStats& getStats() const { return m_stats; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        PathHandle handle{InvalidPathHandle};
+        sf::Vector2f from;
+        sf::Vector2f to;
+        Clock::time_point time;
+    };
+
+    /// 同一目标格子的一组请求（工作线程只读写 starts / paths）
+    struct Job {
+        std::shared_ptr<const NavSnapshot> snapshot;
+        int goal{-1};
+        std::vector<int> starts;                 // 不重复的起点格子
+        std::vector<std::vector<int>> paths;     // 与 starts 对应的格子路径（不可达为空）
+        std::vector<std::pair<PathHandle, int>> waiters;   // 句柄 -> starts 下标（主线程维护）
+    };
+
+    struct Entry {
+        PathStatus status{PathStatus::Pending};
+        std::vector<sf::Vector2f> waypoints;
+        Clock::time_point requested;
+        Clock::time_point completed;
+    };
+
+    /// 求解用的临时数据（每个工作线程一份）
+    struct Solver {
+        HierarchicalPathfinder::QueryContext context;
+        GridSearch search;
+        JumpPointSearch jumpSearch;
+    };
+
+    void workerLoop();
+    static void solve(Job& job, Solver& solver);
+    void publish(Job& job);
+    void resolve(Entry& entry, const NavGrid& grid, const std::vector<int>& cells, Clock::time_point now);
+    void drainRequests();
+    void dispatchJobs();
+
+    /// 句柄是否已发出、但请求还在队列里（尚未被 sync 取出）
+    bool isQueued(PathHandle handle) const;
+
+    Pathfinder* m_pathfinder{nullptr};
+    std::shared_ptr<const NavSnapshot> m_snapshot;
+
+    int m_maxJobsPerFrame{8};
+    float m_maxInlineMs{2.f};
+
+    std::atomic<PathHandle> m_nextHandle{1};          // 句柄单调递增
+    PathHandle m_drainedHandles{1};                   // 小于此值的句柄都已从请求队列取出（上次 sync 时的水位）
+    LockFreeQueue<Request> m_requests;
+    LockFreeQueue<Job*> m_jobs;
+    LockFreeQueue<Job*> m_results;
+
+    // 主线程状态
+    std::unordered_map<PathHandle, Entry> m_entries;
+    std::unordered_set<PathHandle> m_released;             // 还在请求队列里就被放弃的句柄
+    std::unordered_map<int, Job*> m_pendingByGoal;        // 尚未派发、可继续合并的任务
+    std::deque<std::unique_ptr<Job>> m_pendingJobs;       // 按到达顺序等待派发
+    std::unordered_map<Job*, std::unique_ptr<Job>> m_inFlight;
+    PathCache m_cache;
+    PathServiceStats m_stats;
+
+    // 工作线程
+    std::vector<std::thread> m_workers;
+    std::mutex m_wakeMutex;                // 只用于空闲时休眠，队列本身无锁
+    std::condition_variable m_wakeCondition;
+    std::atomic<bool> m_running{false};
+
+    // 无工作线程时同步计算用的缓冲
+    Solver m_inlineSolver;
+};
+
+} // namespace Nightfall
@@ -1 +1,1203 @@
-﻿
\ No newline at end of file
+﻿#include "Pathfinding.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Nightfall {
+
+namespace {
+
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+constexpr float kDiagonalCost = 1.41421356f;
+
+// 8 邻接方向（前 4 个为正交方向）
+constexpr int kNeighborX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+constexpr int kNeighborY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+/// 从 (x, y) 走到 (x + dx, y + dy) 是否可行：目标可通行，斜向移动时两侧的正交格子也必须可通行
+bool canStep(const NavGrid& grid, int x, int y, int dx, int dy) {
+    if (!grid.isWalkable(x + dx, y + dy)) return false;
+    if (dx != 0 && dy != 0) {
+        return grid.isWalkable(x + dx, y) && grid.isWalkable(x, y + dy);
+    }
+    return true;
+}
+
+/// 8 邻接下的路径长度下界
+float octileDistance(int x0, int y0, int x1, int y1) {
+    const int dx = std::abs(x1 - x0);
+    const int dy = std::abs(y1 - y0);
+    return static_cast<float>(std::max(dx, dy)) + (kDiagonalCost - 1.f) * static_cast<float>(std::min(dx, dy));
+}
+
+/// 最低的置位（value 不为 0）
+int lowestBit(std::uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+/// 最高的置位（value 不为 0）
+int highestBit(std::uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+bool testBit(const std::uint64_t* bits, int position) {
+    return ((bits[position >> 6] >> (position & 63)) & 1) != 0;
+}
+
+/// 正向移动时的强迫邻居：侧边的格子可通行，但它后面一格（position - 1）不可通行
+std::uint64_t forcedForward(const std::uint64_t* side, int word) {
+    if (!side) return 0;
+    const std::uint64_t previous = (side[word] << 1) | (word > 0 ? side[word - 1] >> 63 : 0);
+    return side[word] & ~previous;
+}
+
+/// 反向移动时的强迫邻居：侧边的格子可通行，但 position + 1 不可通行
+std::uint64_t forcedBackward(const std::uint64_t* side, int word, int words) {
+    if (!side) return 0;
+    const std::uint64_t previous = (side[word] >> 1) | (word + 1 < words ? side[word + 1] << 63 : 0);
+    return side[word] & ~previous;
+}
+
+/**
+ * 沿一行（或转置后的一列）扫描：从 from 开始按 step（±1）前进，返回第一个有强迫邻居的位置，
+ * 途中经过 target 时返回 target；先遇到阻挡或走出网格返回 -1。
+ * sideA / sideB 为两侧相邻的行（网格外为 nullptr），target 为 -1 表示本行没有目标。
+ */
+int scanLine(const std::uint64_t* line, const std::uint64_t* sideA, const std::uint64_t* sideB,
+             int words, int from, int step, int target) {
+    if (from < 0 || from >= words * 64) return -1;
+
+    int word = from >> 6;
+    if (step > 0) {
+        std::uint64_t mask = ~0ull << (from & 63);
+        for (; word < words; ++word, mask = ~0ull) {
+            const std::uint64_t stop = (~line[word] | forcedForward(sideA, word) | forcedForward(sideB, word)) & mask;
+            if (!stop) continue;
+
+            const int position = (word << 6) + lowestBit(stop);
+            if (target >= from && target <= position) return testBit(line, target) ? target : -1;
+            return testBit(line, position) ? position : -1;
+        }
+        return target >= from ? target : -1;
+    }
+
+    std::uint64_t mask = ~0ull >> (63 - (from & 63));
+    for (; word >= 0; --word, mask = ~0ull) {
+        const std::uint64_t stop =
+            (~line[word] | forcedBackward(sideA, word, words) | forcedBackward(sideB, word, words)) & mask;
+        if (!stop) continue;
+
+        const int position = (word << 6) + highestBit(stop);
+        if (target >= 0 && target <= from && target >= position) return testBit(line, target) ? target : -1;
+        return testBit(line, position) ? position : -1;
+    }
+    return target >= 0 && target <= from ? target : -1;
+}
+
+int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+} // namespace
+
+// ========== NavGrid ==========
+
+void NavGrid::resize(const sf::FloatRect& worldBounds, float cellSize) {
+    m_origin = worldBounds.position;
+    m_cellSize = cellSize > 1.f ? cellSize : 1.f;
+    m_width = std::max(1, static_cast<int>(std::ceil(worldBounds.size.x / m_cellSize)));
+    m_height = std::max(1, static_cast<int>(std::ceil(worldBounds.size.y / m_cellSize)));
+    m_blocked.assign(static_cast<size_t>(m_width) * m_height, 0);
+
+    // 通行位：网格内全部置 1，行尾 / 列尾多出的位保持 0（视为阻挡）
+    m_rowWords = (m_width + 63) / 64;
+    m_columnWords = (m_height + 63) / 64;
+    m_rowBits.assign(static_cast<size_t>(m_rowWords) * m_height, 0);
+    m_columnBits.assign(static_cast<size_t>(m_columnWords) * m_width, 0);
+    for (int y = 0; y < m_height; ++y) {
+        for (int x = 0; x < m_width; ++x) {
+            m_rowBits[static_cast<size_t>(y) * m_rowWords + (x >> 6)] |= 1ull << (x & 63);
+            m_columnBits[static_cast<size_t>(x) * m_columnWords + (y >> 6)] |= 1ull << (y & 63);
+        }
+    }
+}
+
+void NavGrid::setBlocked(int x, int y, bool blocked) {
+    m_blocked[toIndex(x, y)] = blocked ? 1 : 0;
+
+    std::uint64_t& rowWord = m_rowBits[static_cast<size_t>(y) * m_rowWords + (x >> 6)];
+    std::uint64_t& columnWord = m_columnBits[static_cast<size_t>(x) * m_columnWords + (y >> 6)];
+    if (blocked) {
+        rowWord &= ~(1ull << (x & 63));
+        columnWord &= ~(1ull << (y & 63));
+    } else {
+        rowWord |= 1ull << (x & 63);
+        columnWord |= 1ull << (y & 63);
+    }
+}
+
+int NavGrid::worldToIndex(const sf::Vector2f& position) const {
+    const int x = static_cast<int>(std::floor((position.x - m_origin.x) / m_cellSize));
+    const int y = static_cast<int>(std::floor((position.y - m_origin.y) / m_cellSize));
+    return inBounds(x, y) ? toIndex(x, y) : -1;
+}
+
+sf::Vector2f NavGrid::cellCenter(int index) const {
+    const int x = index % m_width;
+    const int y = index / m_width;
+    return m_origin + sf::Vector2f((x + 0.5f) * m_cellSize, (y + 0.5f) * m_cellSize);
+}
+
+bool NavGrid::cellRange(const sf::FloatRect& area, int& minX, int& minY, int& maxX, int& maxY) const {
+    minX = std::max(0, static_cast<int>(std::floor((area.position.x - m_origin.x) / m_cellSize)));
+    minY = std::max(0, static_cast<int>(std::floor((area.position.y - m_origin.y) / m_cellSize)));
+    maxX = std::min(m_width - 1, static_cast<int>(std::floor((area.position.x + area.size.x - m_origin.x) / m_cellSize)));
+    maxY = std::min(m_height - 1, static_cast<int>(std::floor((area.position.y + area.size.y - m_origin.y) / m_cellSize)));
+    return minX <= maxX && minY <= maxY;
+}
+
+// ========== FlowField ==========
+
+void FlowField::build(const NavGrid& grid, const std::vector<int>& goals) {
+    const size_t count = grid.getCellCount();
+    m_distance.assign(count, kInfinity);
+    m_next.assign(count, -1);
+    m_invalid.assign(count, 0);
+    m_goals = goals;
+    m_heap.clear();
+
+    // 目标格子距离恒为 0（即使被阻挡，也从它向外扩展）
+    for (int goal : m_goals) {
+        relaxTo(goal, 0.f, -1);
+    }
+    propagate(grid);
+}
+
+void FlowField::repair(const NavGrid& grid, const std::vector<int>& changed) {
+    if (m_next.size() != grid.getCellCount()) {
+        build(grid, m_goals);
+        return;
+    }
+
+    const int width = grid.getWidth();
+    auto invalidate = [&](int index) {
+        if (!m_invalid[index]) {
+            m_invalid[index] = 1;
+            m_invalidList.push_back(index);
+        }
+    };
+
+    // 1. 变化的格子失效；斜穿它所在墙角的相邻格子也失效
+    for (int cell : changed) {
+        invalidate(cell);
+
+        const int cx = cell % width;
+        const int cy = cell / width;
+        for (int dir = 0; dir < 8; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (!grid.inBounds(nx, ny)) continue;
+
+            const int neighbor = grid.toIndex(nx, ny);
+            const int next = m_next[neighbor];
+            if (next < 0) continue;
+
+            const int stepX = next % width - nx;
+            const int stepY = next / width - ny;
+            if (stepX != 0 && stepY != 0 &&
+                ((nx + stepX == cx && ny == cy) || (nx == cx && ny + stepY == cy))) {
+                invalidate(neighbor);
+            }
+        }
+    }
+
+    // 2. 下一步指向失效格子的格子也失效（沿反向指针扩散，只访问受影响的子树）
+    for (size_t i = 0; i < m_invalidList.size(); ++i) {
+        const int cell = m_invalidList[i];
+        const int cx = cell % width;
+        const int cy = cell / width;
+        for (int dir = 0; dir < 8; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (!grid.inBounds(nx, ny)) continue;
+
+            const int neighbor = grid.toIndex(nx, ny);
+            if (m_next[neighbor] == cell) {
+                invalidate(neighbor);
+            }
+        }
+    }
+
+    for (int cell : m_invalidList) {
+        m_distance[cell] = kInfinity;
+        m_next[cell] = -1;
+    }
+
+    // 3. 从失效区域边界上仍然有效的格子（以及失效的目标格子）重新松弛
+    m_heap.clear();
+    for (int goal : m_goals) {
+        if (m_invalid[goal]) {
+            relaxTo(goal, 0.f, -1);
+        }
+    }
+    for (int cell : m_invalidList) {
+        const int cx = cell % width;
+        const int cy = cell / width;
+        for (int dir = 0; dir < 8; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (!grid.inBounds(nx, ny)) continue;
+
+            const int neighbor = grid.toIndex(nx, ny);
+            if (!m_invalid[neighbor] && m_distance[neighbor] < kInfinity) {
+                m_heap.push_back({m_distance[neighbor], neighbor});
+                std::push_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+            }
+        }
+    }
+    propagate(grid);
+
+    m_lastRepairCount = m_invalidList.size();
+    for (int cell : m_invalidList) {
+        m_invalid[cell] = 0;
+    }
+    m_invalidList.clear();
+}
+
+void FlowField::propagate(const NavGrid& grid) {
+    const int width = grid.getWidth();
+
+    while (!m_heap.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+        const QueueItem item = m_heap.back();
+        m_heap.pop_back();
+
+        // 过期的堆条目（该格子之后找到了更短的路径）
+        if (item.distance > m_distance[item.index]) continue;
+
+        const int cx = item.index % width;
+        const int cy = item.index / width;
+        for (int dir = 0; dir < 8; ++dir) {
+            const int dx = kNeighborX[dir];
+            const int dy = kNeighborY[dir];
+
+            // 邻居沿 (-dx, -dy) 走到当前格子，墙角规则对称
+            if (!canStep(grid, cx, cy, dx, dy)) continue;
+
+            const int neighbor = grid.toIndex(cx + dx, cy + dy);
+            const float distance = item.distance + (dir < 4 ? 1.f : kDiagonalCost);
+            if (distance < m_distance[neighbor]) {
+                relaxTo(neighbor, distance, item.index);
+            }
+        }
+    }
+}
+
+void FlowField::relaxTo(int index, float distance, int next) {
+    m_distance[index] = distance;
+    m_next[index] = next;
+    m_heap.push_back({distance, index});
+    std::push_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+}
+
+// ========== GridSearch ==========
+
+void GridSearch::prepare(size_t cellCount) {
+    if (m_seen.size() != cellCount) {
+        m_seen.assign(cellCount, 0);
+        m_closed.assign(cellCount, 0);
+        m_cost.resize(cellCount);
+        m_parent.resize(cellCount);
+        m_generation = 0;
+    }
+
+    // 代数戳回绕时清空一次
+    if (++m_generation == 0) {
+        std::fill(m_seen.begin(), m_seen.end(), 0);
+        std::fill(m_closed.begin(), m_closed.end(), 0);
+        m_generation = 1;
+    }
+    m_heap.clear();
+}
+
+bool GridSearch::findPath(const NavGrid& grid, int start, int goal, const CellRect& bounds,
+                          std::vector<int>& path, float& cost) {
+    path.clear();
+    if (grid.isBlocked(start) || grid.isBlocked(goal)) return false;
+
+    prepare(grid.getCellCount());
+
+    const int width = grid.getWidth();
+    const int goalX = goal % width;
+    const int goalY = goal / width;
+
+    m_seen[start] = m_generation;
+    m_cost[start] = 0.f;
+    m_parent[start] = -1;
+    m_heap.push_back({octileDistance(start % width, start / width, goalX, goalY), start});
+
+    while (!m_heap.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+        const int current = m_heap.back().index;
+        m_heap.pop_back();
+
+        if (isClosed(current)) continue;
+        m_closed[current] = m_generation;
+
+        if (current == goal) {
+            cost = m_cost[goal];
+            for (int cell = goal; cell != -1; cell = m_parent[cell]) {
+                path.push_back(cell);
+            }
+            std::reverse(path.begin(), path.end());
+            return true;
+        }
+
+        const int cx = current % width;
+        const int cy = current / width;
+        for (int dir = 0; dir < 8; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (!bounds.contains(nx, ny) || !canStep(grid, cx, cy, kNeighborX[dir], kNeighborY[dir])) continue;
+
+            const int neighbor = grid.toIndex(nx, ny);
+            if (isClosed(neighbor)) continue;
+
+            const float newCost = m_cost[current] + (dir < 4 ? 1.f : kDiagonalCost);
+            if (!isSeen(neighbor) || newCost < m_cost[neighbor]) {
+                m_seen[neighbor] = m_generation;
+                m_cost[neighbor] = newCost;
+                m_parent[neighbor] = current;
+                m_heap.push_back({newCost + octileDistance(nx, ny, goalX, goalY), neighbor});
+                std::push_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+            }
+        }
+    }
+
+    return false;
+}
+
+void GridSearch::distances(const NavGrid& grid, int start, const CellRect& bounds,
+                           const std::vector<int>& targets, std::vector<float>& out) {
+    out.assign(targets.size(), kInfinity);
+    if (grid.isBlocked(start)) return;
+
+    prepare(grid.getCellCount());
+
+    const int width = grid.getWidth();
+    m_seen[start] = m_generation;
+    m_cost[start] = 0.f;
+    m_heap.push_back({0.f, start});
+
+    while (!m_heap.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+        const int current = m_heap.back().index;
+        m_heap.pop_back();
+
+        if (isClosed(current)) continue;
+        m_closed[current] = m_generation;
+
+        const int cx = current % width;
+        const int cy = current / width;
+        for (int dir = 0; dir < 8; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (!bounds.contains(nx, ny) || !canStep(grid, cx, cy, kNeighborX[dir], kNeighborY[dir])) continue;
+
+            const int neighbor = grid.toIndex(nx, ny);
+            if (isClosed(neighbor)) continue;
+
+            const float newCost = m_cost[current] + (dir < 4 ? 1.f : kDiagonalCost);
+            if (!isSeen(neighbor) || newCost < m_cost[neighbor]) {
+                m_seen[neighbor] = m_generation;
+                m_cost[neighbor] = newCost;
+                m_heap.push_back({newCost, neighbor});
+                std::push_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+            }
+        }
+    }
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (isClosed(targets[i])) {
+            out[i] = m_cost[targets[i]];
+        }
+    }
+}
+
+void GridSearch::pathsToGoal(const NavGrid& grid, int goal, const std::vector<int>& starts, const CellRect& bounds,
+                             std::vector<std::vector<int>>& paths) {
+    paths.assign(starts.size(), {});
+    if (grid.isBlocked(goal)) return;
+
+    prepare(grid.getCellCount());
+
+    const int width = grid.getWidth();
+    m_seen[goal] = m_generation;
+    m_cost[goal] = 0.f;
+    m_parent[goal] = -1;
+    m_heap.push_back({0.f, goal});
+
+    // 还没确定距离的起点（所有起点都确定后提前结束）
+    std::unordered_set<int> pendingStarts(starts.begin(), starts.end());
+
+    while (!m_heap.empty() && !pendingStarts.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+        const int current = m_heap.back().index;
+        m_heap.pop_back();
+
+        if (isClosed(current)) continue;
+        m_closed[current] = m_generation;
+
+        pendingStarts.erase(current);
+
+        const int cx = current % width;
+        const int cy = current / width;
+        for (int dir = 0; dir < 8; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (!bounds.contains(nx, ny) || !canStep(grid, cx, cy, kNeighborX[dir], kNeighborY[dir])) continue;
+
+            const int neighbor = grid.toIndex(nx, ny);
+            if (isClosed(neighbor)) continue;
+
+            const float newCost = m_cost[current] + (dir < 4 ? 1.f : kDiagonalCost);
+            if (!isSeen(neighbor) || newCost < m_cost[neighbor]) {
+                m_seen[neighbor] = m_generation;
+                m_cost[neighbor] = newCost;
+                m_parent[neighbor] = current;
+                m_heap.push_back({newCost, neighbor});
+                std::push_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+            }
+        }
+    }
+
+    // 父指针指向目标方向，从起点沿父指针走到目标即为路径
+    for (size_t i = 0; i < starts.size(); ++i) {
+        if (!isClosed(starts[i])) continue;
+        for (int cell = starts[i]; cell != -1; cell = m_parent[cell]) {
+            paths[i].push_back(cell);
+        }
+    }
+}
+
+// ========== JumpPointSearch ==========
+
+void JumpPointSearch::prepare(size_t cellCount) {
+    if (m_seen.size() != cellCount) {
+        m_seen.assign(cellCount, 0);
+        m_closed.assign(cellCount, 0);
+        m_cost.resize(cellCount);
+        m_parent.resize(cellCount);
+        m_generation = 0;
+    }
+
+    if (++m_generation == 0) {
+        std::fill(m_seen.begin(), m_seen.end(), 0);
+        std::fill(m_closed.begin(), m_closed.end(), 0);
+        m_generation = 1;
+    }
+    m_heap.clear();
+}
+
+int JumpPointSearch::jumpStraight(const NavGrid& grid, int x, int y, int dx, int dy, int goalX, int goalY) const {
+    if (dy == 0) {
+        const int words = grid.getRowWords();
+        const std::uint64_t* above = y > 0 ? grid.getRowBits(y - 1) : nullptr;
+        const std::uint64_t* below = y + 1 < grid.getHeight() ? grid.getRowBits(y + 1) : nullptr;
+        const int hit = scanLine(grid.getRowBits(y), above, below, words, x + dx, dx, goalY == y ? goalX : -1);
+        return hit < 0 ? -1 : grid.toIndex(hit, y);
+    }
+
+    const int words = grid.getColumnWords();
+    const std::uint64_t* left = x > 0 ? grid.getColumnBits(x - 1) : nullptr;
+    const std::uint64_t* right = x + 1 < grid.getWidth() ? grid.getColumnBits(x + 1) : nullptr;
+    const int hit = scanLine(grid.getColumnBits(x), left, right, words, y + dy, dy, goalX == x ? goalY : -1);
+    return hit < 0 ? -1 : grid.toIndex(x, hit);
+}
+
+int JumpPointSearch::jumpDiagonal(const NavGrid& grid, int x, int y, int dx, int dy, int goalX, int goalY) const {
+    while (canStep(grid, x, y, dx, dy)) {
+        x += dx;
+        y += dy;
+        if (x == goalX && y == goalY) return grid.toIndex(x, y);
+
+        if (jumpStraight(grid, x, y, dx, 0, goalX, goalY) >= 0 ||
+            jumpStraight(grid, x, y, 0, dy, goalX, goalY) >= 0) {
+            return grid.toIndex(x, y);
+        }
+    }
+    return -1;
+}
+
+bool JumpPointSearch::findPath(const NavGrid& grid, int start, int goal, std::vector<int>& path, float& cost) {
+    path.clear();
+    m_lastExpanded = 0;
+    if (grid.isBlocked(start) || grid.isBlocked(goal)) return false;
+
+    prepare(grid.getCellCount());
+
+    const int width = grid.getWidth();
+    const int goalX = goal % width;
+    const int goalY = goal / width;
+
+    m_seen[start] = m_generation;
+    m_cost[start] = 0.f;
+    m_parent[start] = -1;
+    m_heap.push_back({octileDistance(start % width, start / width, goalX, goalY), start});
+
+    while (!m_heap.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+        const int current = m_heap.back().index;
+        m_heap.pop_back();
+
+        if (isClosed(current)) continue;
+        m_closed[current] = m_generation;
+        ++m_lastExpanded;
+
+        const int cx = current % width;
+        const int cy = current / width;
+
+        if (current == goal) {
+            cost = m_cost[goal];
+
+            // 跳点之间只会是直线或对角线，逐格展开
+            m_jumpPoints.clear();
+            for (int cell = goal; cell != -1; cell = m_parent[cell]) {
+                m_jumpPoints.push_back(cell);
+            }
+            std::reverse(m_jumpPoints.begin(), m_jumpPoints.end());
+
+            path.push_back(start);
+            for (size_t i = 1; i < m_jumpPoints.size(); ++i) {
+                int x = m_jumpPoints[i - 1] % width;
+                int y = m_jumpPoints[i - 1] / width;
+                const int toX = m_jumpPoints[i] % width;
+                const int toY = m_jumpPoints[i] / width;
+                const int stepX = sign(toX - x);
+                const int stepY = sign(toY - y);
+                while (x != toX || y != toY) {
+                    x += stepX;
+                    y += stepY;
+                    path.push_back(grid.toIndex(x, y));
+                }
+            }
+            return true;
+        }
+
+        // 剪枝后的邻居方向：起点展开全部 8 个方向，其余只沿来向及可能的强迫邻居
+        int directionX[8];
+        int directionY[8];
+        int directionCount = 0;
+        auto addDirection = [&](int dx, int dy) {
+            directionX[directionCount] = dx;
+            directionY[directionCount] = dy;
+            ++directionCount;
+        };
+
+        const int parent = m_parent[current];
+        if (parent < 0) {
+            for (int dir = 0; dir < 8; ++dir) {
+                addDirection(kNeighborX[dir], kNeighborY[dir]);
+            }
+        } else {
+            const int dx = sign(cx - parent % width);
+            const int dy = sign(cy - parent / width);
+            if (dx != 0 && dy != 0) {
+                addDirection(dx, 0);
+                addDirection(0, dy);
+                addDirection(dx, dy);
+            } else if (dx != 0) {
+                addDirection(dx, 0);
+                addDirection(dx, 1);
+                addDirection(dx, -1);
+                addDirection(0, 1);
+                addDirection(0, -1);
+            } else {
+                addDirection(0, dy);
+                addDirection(1, dy);
+                addDirection(-1, dy);
+                addDirection(1, 0);
+                addDirection(-1, 0);
+            }
+        }
+
+        for (int i = 0; i < directionCount; ++i) {
+            const int dx = directionX[i];
+            const int dy = directionY[i];
+            if (!canStep(grid, cx, cy, dx, dy)) continue;
+
+            const int jumpPoint = (dx != 0 && dy != 0)
+                ? jumpDiagonal(grid, cx, cy, dx, dy, goalX, goalY)
+                : jumpStraight(grid, cx, cy, dx, dy, goalX, goalY);
+            if (jumpPoint < 0 || isClosed(jumpPoint)) continue;
+
+            const int jx = jumpPoint % width;
+            const int jy = jumpPoint / width;
+            const float newCost = m_cost[current] + octileDistance(cx, cy, jx, jy);
+            if (!isSeen(jumpPoint) || newCost < m_cost[jumpPoint]) {
+                m_seen[jumpPoint] = m_generation;
+                m_cost[jumpPoint] = newCost;
+                m_parent[jumpPoint] = current;
+                m_heap.push_back({newCost + octileDistance(jx, jy, goalX, goalY), jumpPoint});
+                std::push_heap(m_heap.begin(), m_heap.end(), std::greater<QueueItem>());
+            }
+        }
+    }
+
+    return false;
+}
+
+// ========== PathCache ==========
+
+size_t PathCache::KeyHash::operator()(const Key& key) const {
+    std::uint64_t hash = static_cast<std::uint32_t>(key.start);
+    hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<std::uint32_t>(key.goal);
+    hash = hash * 0x9E3779B97F4A7C15ull ^ key.version;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+void PathCache::setCapacity(size_t capacity) {
+    m_capacity = capacity;
+    while (m_entries.size() > m_capacity) {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+const std::vector<int>* PathCache::find(int start, int goal, std::uint32_t version) {
+    auto it = m_index.find(Key{start, goal, version});
+    if (it == m_index.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &it->second->path;
+}
+
+void PathCache::store(int start, int goal, std::uint32_t version, const std::vector<int>& path) {
+    if (m_capacity == 0) return;
+
+    const Key key{start, goal, version};
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        it->second->path = path;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+
+    if (m_entries.size() >= m_capacity) {
+        // 把最久未用的条目移到前端重用（保留 vector 的容量）
+        m_index.erase(m_entries.back().key);
+        m_entries.splice(m_entries.begin(), m_entries, std::prev(m_entries.end()));
+        m_entries.front().key = key;
+        m_entries.front().path = path;
+    } else {
+        m_entries.push_front(Entry{key, path});
+    }
+    m_index.emplace(key, m_entries.begin());
+}
+
+void PathCache::clear() {
+    m_entries.clear();
+    m_index.clear();
+}
+
+// ========== HierarchicalPathfinder ==========
+
+void HierarchicalPathfinder::build(const NavGrid& grid, int clusterSize, GridSearch& search) {
+    m_clusterSize = std::max(2, clusterSize);
+    // 每条边上的入口不超过边长（每段最多两个、段之间至少隔一格），角落的入口会合并
+    m_portalStride = 4 * m_clusterSize;
+    m_clustersX = (grid.getWidth() + m_clusterSize - 1) / m_clusterSize;
+    m_clustersY = (grid.getHeight() + m_clusterSize - 1) / m_clusterSize;
+
+    m_clusters.assign(static_cast<size_t>(m_clustersX) * m_clustersY, Cluster{});
+    m_portalIndex.clear();
+    m_dirtyClusters.clear();
+
+    for (int cy = 0; cy < m_clustersY; ++cy) {
+        for (int cx = 0; cx < m_clustersX; ++cx) {
+            Cluster& cluster = m_clusters[cy * m_clustersX + cx];
+            cluster.bounds.minX = cx * m_clusterSize;
+            cluster.bounds.minY = cy * m_clusterSize;
+            cluster.bounds.maxX = std::min(grid.getWidth(), (cx + 1) * m_clusterSize) - 1;
+            cluster.bounds.maxY = std::min(grid.getHeight(), (cy + 1) * m_clusterSize) - 1;
+        }
+    }
+
+    for (size_t i = 0; i < m_clusters.size(); ++i) {
+        rebuildPortals(grid, static_cast<int>(i));
+    }
+    for (size_t i = 0; i < m_clusters.size(); ++i) {
+        linkPortals(grid, static_cast<int>(i));
+        rebuildCosts(grid, static_cast<int>(i), search);
+    }
+    labelComponents();
+}
+
+void HierarchicalPathfinder::invalidateCells(const NavGrid& grid, const std::vector<int>& cells) {
+    if (m_clusters.empty()) return;
+
+    for (int cell : cells) {
+        const int clusterIndex = clusterOf(grid, cell);
+        Cluster& cluster = m_clusters[clusterIndex];
+        if (!cluster.dirty) {
+            cluster.dirty = true;
+            m_dirtyClusters.push_back(clusterIndex);
+        }
+    }
+}
+
+size_t HierarchicalPathfinder::refresh(const NavGrid& grid, GridSearch& search) {
+    if (m_dirtyClusters.empty()) return 0;
+
+    // 失效簇四条边上的入口都可能变化，所以邻簇的入口列表和簇内代价也要一起重建；
+    // 入口只由公共边两侧的格子决定，两侧各自重建的结果一致
+    std::vector<int> affected = m_dirtyClusters;
+    for (int clusterIndex : m_dirtyClusters) {
+        const int cx = clusterIndex % m_clustersX;
+        const int cy = clusterIndex / m_clustersX;
+        for (int dir = 0; dir < 4; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (nx >= 0 && ny >= 0 && nx < m_clustersX && ny < m_clustersY) {
+                affected.push_back(ny * m_clustersX + nx);
+            }
+        }
+        m_clusters[clusterIndex].dirty = false;
+    }
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+    m_dirtyClusters.clear();
+
+    for (int clusterIndex : affected) {
+        rebuildPortals(grid, clusterIndex);
+    }
+    for (int clusterIndex : affected) {
+        rebuildCosts(grid, clusterIndex, search);
+    }
+
+    // 受影响簇的入口下标可能变了，指向它们的链接要重新解析：受影响的簇和它们的邻簇
+    std::vector<int> relinked = affected;
+    for (int clusterIndex : affected) {
+        const int cx = clusterIndex % m_clustersX;
+        const int cy = clusterIndex / m_clustersX;
+        for (int dir = 0; dir < 4; ++dir) {
+            const int nx = cx + kNeighborX[dir];
+            const int ny = cy + kNeighborY[dir];
+            if (nx >= 0 && ny >= 0 && nx < m_clustersX && ny < m_clustersY) {
+                relinked.push_back(ny * m_clustersX + nx);
+            }
+        }
+    }
+    std::sort(relinked.begin(), relinked.end());
+    relinked.erase(std::unique(relinked.begin(), relinked.end()), relinked.end());
+    for (int clusterIndex : relinked) {
+        linkPortals(grid, clusterIndex);
+    }
+    labelComponents();
+    return affected.size();
+}
+
+int HierarchicalPathfinder::clusterOf(const NavGrid& grid, int cell) const {
+    const int x = cell % grid.getWidth();
+    const int y = cell / grid.getWidth();
+    return (y / m_clusterSize) * m_clustersX + (x / m_clusterSize);
+}
+
+void HierarchicalPathfinder::collectTransitions(const NavGrid& grid, int clusterIndex, int dx, int dy,
+                                                std::vector<std::pair<int, int>>& transitions) const {
+    transitions.clear();
+
+    const CellRect& bounds = m_clusters[clusterIndex].bounds;
+    const bool vertical = dx != 0;   // 左右相邻：公共边是竖直的
+
+    // 本簇一侧的边界格子沿公共边排列
+    const int fixed = vertical ? (dx > 0 ? bounds.maxX : bounds.minX) : (dy > 0 ? bounds.maxY : bounds.minY);
+    const int from = vertical ? bounds.minY : bounds.minX;
+    const int to = vertical ? bounds.maxY : bounds.maxX;
+
+    auto ownCell = [&](int i) { return vertical ? grid.toIndex(fixed, i) : grid.toIndex(i, fixed); };
+    auto otherCell = [&](int i) { return vertical ? grid.toIndex(fixed + dx, i) : grid.toIndex(i, fixed + dy); };
+    auto open = [&](int i) {
+        return vertical ? grid.isWalkable(fixed, i) && grid.isWalkable(fixed + dx, i)
+                        : grid.isWalkable(i, fixed) && grid.isWalkable(i, fixed + dy);
+    };
+
+    if (vertical ? !grid.inBounds(fixed + dx, from) : !grid.inBounds(from, fixed + dy)) return;
+
+    // 连续可通行的一段：短段在中点放一个入口，长段在两端各放一个
+    constexpr int kLongRun = 6;
+    int i = from;
+    while (i <= to) {
+        if (!open(i)) {
+            ++i;
+            continue;
+        }
+
+        int runEnd = i;
+        while (runEnd + 1 <= to && open(runEnd + 1)) {
+            ++runEnd;
+        }
+
+        if (runEnd - i + 1 >= kLongRun) {
+            transitions.emplace_back(ownCell(i), otherCell(i));
+            transitions.emplace_back(ownCell(runEnd), otherCell(runEnd));
+        } else {
+            const int mid = (i + runEnd) / 2;
+            transitions.emplace_back(ownCell(mid), otherCell(mid));
+        }
+        i = runEnd + 1;
+    }
+}
+
+void HierarchicalPathfinder::rebuildPortals(const NavGrid& grid, int clusterIndex) {
+    Cluster& cluster = m_clusters[clusterIndex];
+    for (const Portal& portal : cluster.portals) {
+        m_portalIndex.erase(portal.cell);
+    }
+    cluster.portals.clear();
+
+    for (int dir = 0; dir < 4; ++dir) {
+        collectTransitions(grid, clusterIndex, kNeighborX[dir], kNeighborY[dir], m_transitions);
+        for (const auto& transition : m_transitions) {
+            // 角落的格子可能同时是两条边上的入口，合并为一个节点
+            auto it = m_portalIndex.find(transition.first);
+            if (it == m_portalIndex.end()) {
+                it = m_portalIndex.emplace(transition.first, static_cast<int>(cluster.portals.size())).first;
+                cluster.portals.push_back({transition.first, {}, {}});
+            }
+            cluster.portals[it->second].partners.push_back(transition.second);
+        }
+    }
+}
+
+void HierarchicalPathfinder::rebuildCosts(const NavGrid& grid, int clusterIndex, GridSearch& search) {
+    Cluster& cluster = m_clusters[clusterIndex];
+    const size_t count = cluster.portals.size();
+    cluster.costs.assign(count * count, kInfinity);
+
+    m_targets.clear();
+    for (const Portal& portal : cluster.portals) {
+        m_targets.push_back(portal.cell);
+    }
+
+    // 每个入口在簇内做一次 Dijkstra，缓存到其余入口的代价
+    for (size_t i = 0; i < count; ++i) {
+        search.distances(grid, cluster.portals[i].cell, cluster.bounds, m_targets, m_row);
+        std::copy(m_row.begin(), m_row.end(), cluster.costs.begin() + i * count);
+    }
+
+    // 簇内互相可达的入口归入同一区域，连通分量编号时只需合并区域和跨簇链接
+    cluster.regions.assign(count, -1);
+    for (size_t i = 0; i < count; ++i) {
+        if (cluster.regions[i] != -1) continue;
+        cluster.regions[i] = static_cast<int>(i);
+        for (size_t j = i + 1; j < count; ++j) {
+            if (cluster.costs[i * count + j] < kInfinity) cluster.regions[j] = static_cast<int>(i);
+        }
+    }
+}
+
+void HierarchicalPathfinder::linkPortals(const NavGrid& grid, int clusterIndex) {
+    for (Portal& portal : m_clusters[clusterIndex].portals) {
+        portal.links.clear();
+        for (int partner : portal.partners) {
+            portal.links.push_back(clusterOf(grid, partner) * m_portalStride + m_portalIndex.at(partner));
+        }
+    }
+}
+
+void HierarchicalPathfinder::labelComponents() {
+    // 并查集：m_components 先存父节点，最后压平为分量代表（代表即编号）
+    m_components.resize(m_clusters.size() * m_portalStride);
+    std::iota(m_components.begin(), m_components.end(), 0);
+
+    auto find = [&](int node) {
+        while (m_components[node] != node) {
+            m_components[node] = m_components[m_components[node]];
+            node = m_components[node];
+        }
+        return node;
+    };
+    auto unite = [&](int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) m_components[std::max(a, b)] = std::min(a, b);
+    };
+
+    for (size_t clusterIndex = 0; clusterIndex < m_clusters.size(); ++clusterIndex) {
+        const Cluster& cluster = m_clusters[clusterIndex];
+        const int base = static_cast<int>(clusterIndex) * m_portalStride;
+        for (size_t i = 0; i < cluster.portals.size(); ++i) {
+            const int node = base + static_cast<int>(i);
+            unite(node, base + cluster.regions[i]);
+            for (int link : cluster.portals[i].links) {
+                unite(node, link);
+            }
+        }
+    }
+
+    for (size_t node = 0; node < m_components.size(); ++node) {
+        m_components[node] = find(static_cast<int>(node));
+    }
+}
+
+bool HierarchicalPathfinder::findRoute(const NavGrid& grid, int start, int goal, std::vector<int>& route,
+                                       QueryContext& context) const {
+    route.clear();
+    if (m_clusters.empty() || start < 0 || goal < 0 || grid.isBlocked(start) || grid.isBlocked(goal)) {
+        return false;
+    }
+
+    const int width = grid.getWidth();
+    const int startCluster = clusterOf(grid, start);
+    const int goalCluster = clusterOf(grid, goal);
+
+    // 同一个簇内且簇内可达：直接作为一段
+    if (startCluster == goalCluster) {
+        float cost;
+        if (context.search.findPath(grid, start, goal, m_clusters[startCluster].bounds, context.segment, cost)) {
+            route.push_back(start);
+            route.push_back(goal);
+            return true;
+        }
+    }
+
+    // 把起点和终点临时接入抽象图：各自到所在簇入口的代价
+    auto clusterTargets = [&](int clusterIndex) {
+        context.targets.clear();
+        for (const Portal& portal : m_clusters[clusterIndex].portals) {
+            context.targets.push_back(portal.cell);
+        }
+    };
+    clusterTargets(startCluster);
+    context.search.distances(grid, start, m_clusters[startCluster].bounds, context.targets, context.startCosts);
+    clusterTargets(goalCluster);
+    context.search.distances(grid, goal, m_clusters[goalCluster].bounds, context.targets, context.goalCosts);
+
+    // 节点编号：簇下标 * 每簇入口上限 + 簇内下标；起点和终点排在最后
+    const int stride = m_portalStride;
+
+    // 起点能到的入口和能到终点的入口不在同一个连通分量：不必搜索
+    const Cluster& lastCluster = m_clusters[goalCluster];
+    bool connected = false;
+    for (size_t i = 0; i < m_clusters[startCluster].portals.size() && !connected; ++i) {
+        if (context.startCosts[i] >= kInfinity) continue;
+        const int component = m_components[startCluster * stride + static_cast<int>(i)];
+        for (size_t j = 0; j < lastCluster.portals.size(); ++j) {
+            if (context.goalCosts[j] < kInfinity && m_components[goalCluster * stride + static_cast<int>(j)] == component) {
+                connected = true;
+                break;
+            }
+        }
+    }
+    if (!connected) return false;
+
+    const int startNode = static_cast<int>(m_clusters.size()) * stride;
+    const int goalNode = startNode + 1;
+    if (context.records.size() != static_cast<size_t>(goalNode + 1)) {
+        context.records.assign(goalNode + 1, QueryContext::Record{});
+        context.generation = 0;
+    }
+    if (++context.generation == 0) {
+        std::fill(context.records.begin(), context.records.end(), QueryContext::Record{});
+        context.generation = 1;
+    }
+    context.heap.clear();
+
+    const int goalX = goal % width;
+    const int goalY = goal / width;
+    auto push = [&](int node, int cell, float cost, int parent) {
+        QueryContext::Record& record = context.records[node];
+        if (record.generation == context.generation && (record.closed || record.cost <= cost)) return;
+
+        record = QueryContext::Record{cost, parent, context.generation, false};
+        const float estimate = node == goalNode ? 0.f : octileDistance(cell % width, cell / width, goalX, goalY);
+        context.heap.push_back({cost + estimate, node});
+        std::push_heap(context.heap.begin(), context.heap.end(), std::greater<QueryContext::QueueItem>());
+    };
+
+    context.records[startNode] = QueryContext::Record{0.f, -1, context.generation, true};
+    const Cluster& firstCluster = m_clusters[startCluster];
+    for (size_t i = 0; i < firstCluster.portals.size(); ++i) {
+        if (context.startCosts[i] < kInfinity) {
+            push(startCluster * stride + static_cast<int>(i), firstCluster.portals[i].cell, context.startCosts[i], startNode);
+        }
+    }
+
+    bool found = false;
+    while (!context.heap.empty()) {
+        std::pop_heap(context.heap.begin(), context.heap.end(), std::greater<QueryContext::QueueItem>());
+        const int node = context.heap.back().node;
+        context.heap.pop_back();
+
+        QueryContext::Record& record = context.records[node];
+        if (record.closed) continue;
+        record.closed = true;
+
+        if (node == goalNode) {
+            found = true;
+            break;
+        }
+
+        const float cost = record.cost;
+        const int clusterIndex = node / stride;
+        const int local = node % stride;
+        const Cluster& cluster = m_clusters[clusterIndex];
+        const size_t portalCount = cluster.portals.size();
+
+        // 簇内：缓存的入口间代价
+        for (size_t j = 0; j < portalCount; ++j) {
+            const float edge = cluster.costs[local * portalCount + j];
+            if (static_cast<int>(j) != local && edge < kInfinity) {
+                push(clusterIndex * stride + static_cast<int>(j), cluster.portals[j].cell, cost + edge, node);
+            }
+        }
+
+        // 跨簇：相邻簇中对应的入口
+        const Portal& portal = cluster.portals[local];
+        for (size_t k = 0; k < portal.links.size(); ++k) {
+            push(portal.links[k], portal.partners[k], cost + 1.f, node);
+        }
+
+        // 终点所在簇：接到终点
+        if (clusterIndex == goalCluster && context.goalCosts[local] < kInfinity) {
+            push(goalNode, goal, cost + context.goalCosts[local], node);
+        }
+    }
+
+    if (!found) return false;
+
+    for (int node = goalNode; node != -1; node = context.records[node].parent) {
+        if (node == goalNode) {
+            route.push_back(goal);
+        } else if (node == startNode) {
+            route.push_back(start);
+        } else {
+            route.push_back(m_clusters[node / stride].portals[node % stride].cell);
+        }
+    }
+    std::reverse(route.begin(), route.end());
+    return true;
+}
+
+bool HierarchicalPathfinder::refineSegment(const NavGrid& grid, int from, int to, std::vector<int>& cells,
+                                           QueryContext& context) const {
+    cells.clear();
+    if (from == to) {
+        cells.push_back(from);
+        return true;
+    }
+
+    // 跨簇的一步是相邻格子
+    const int fromCluster = clusterOf(grid, from);
+    if (fromCluster != clusterOf(grid, to)) {
+        cells.push_back(from);
+        cells.push_back(to);
+        return true;
+    }
+
+    float cost;
+    return context.search.findPath(grid, from, to, m_clusters[fromCluster].bounds, cells, cost);
+}
+
+bool HierarchicalPathfinder::findPath(const NavGrid& grid, int start, int goal, std::vector<int>& cells,
+                                      QueryContext& context) const {
+    cells.clear();
+
+    std::vector<int>& route = context.route;
+    if (!findRoute(grid, start, goal, route, context)) return false;
+
+    cells.push_back(route.front());
+    for (size_t i = 1; i < route.size(); ++i) {
+        if (!refineSegment(grid, route[i - 1], route[i], context.segment, context)) return false;
+        cells.insert(cells.end(), context.segment.begin() + 1, context.segment.end());
+    }
+    return true;
+}
+
+// ========== Pathfinder ==========
+
+Pathfinder::~Pathfinder() {
+    NF_INFO("Pathfinder shutdown");
+}
+
+bool Pathfinder::findRoute(const sf::Vector2f& from, const sf::Vector2f& to, std::vector<int>& route) {
+    route.clear();
+    if (!m_initialized) return false;
+
+    return m_hierarchy.findRoute(m_grid, m_grid.worldToIndex(from), m_grid.worldToIndex(to), route, m_queryContext);
+}
+
+bool Pathfinder::refineRouteSegment(int fromCell, int toCell, std::vector<sf::Vector2f>& waypoints) {
+    waypoints.clear();
+    if (!m_initialized) return false;
+
+    std::vector<int> cells;
+    if (!m_hierarchy.refineSegment(m_grid, fromCell, toCell, cells, m_queryContext)) return false;
+
+    for (size_t i = 1; i < cells.size(); ++i) {
+        waypoints.push_back(m_grid.cellCenter(cells[i]));
+    }
+    return true;
+}
+
+std::shared_ptr<const NavSnapshot> Pathfinder::getSnapshot() {
+    if (!m_initialized) return nullptr;
+
+    // 只在版本变化后复制一次，旧快照由仍在使用它的工作线程持有到任务结束
+    if (!m_snapshot || m_snapshot->version != m_version) {
+        m_snapshot = std::make_shared<const NavSnapshot>(NavSnapshot{m_grid, m_hierarchy, m_version});
+    }
+    return m_snapshot;
+}
+
+bool Pathfinder::sampleWaypoint(const sf::Vector2f& position, sf::Vector2f& waypoint) const {
+    if (m_flowField.getCellCount() != m_grid.getCellCount()) return false;
+
+    const int index = m_grid.worldToIndex(position);
+    if (index < 0) return false;
+
+    const int next = m_flowField.getNext(index);
+    if (next < 0) return false;
+
+    waypoint = m_grid.cellCenter(next);
+    return true;
+}
+
+bool Pathfinder::sampleDirection(const sf::Vector2f& position, sf::Vector2f& direction) const {
+    sf::Vector2f waypoint;
+    if (!sampleWaypoint(position, waypoint)) return false;
+
+    sf::Vector2f offset = waypoint - position;
+    const float length = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+    if (length <= 0.f) return false;
+
+    direction = offset / length;
+    return true;
+}
+
+} // namespace Nightfall
@@ -1 +1,471 @@
-﻿
\ No newline at end of file
+﻿#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Nightfall {
+
+class Registry;
+
+/**
+ * @brief 导航网格 - 世界按固定边长划分的可通行格子
+ *
+ * 格子中心被实心静态碰撞体（建筑、资源点等，不含触发器）覆盖时视为阻挡。
+ * 只在被标记为脏的区域重新栅格化，返回通行性发生变化的格子。
+ * 另外按行和按列各维护一份打包的通行位（每格 1 位），供跳点搜索整字扫描。
+ */
+class NavGrid {
+public:
+    NavGrid() = default;
+
+    /// 按世界范围和格子边长重新分配网格（所有格子可通行）
+    void resize(const sf::FloatRect& worldBounds, float cellSize);
+
+    /// 从静态碰撞体索引栅格化整个网格（栅格化在 PathfindingRegistry.cpp）
+    void rasterize(Registry& registry);
+
+    /**
+     * @brief 重新栅格化与区域重叠的格子
+     * @param changed 追加通行性发生变化的格子下标
+     */
+    void rasterizeRegion(Registry& registry, const sf::FloatRect& area, std::vector<int>& changed);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    float getCellSize() const { return m_cellSize; }
+    size_t getCellCount() const { return m_blocked.size(); }
+
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < m_width && y < m_height; }
+    int toIndex(int x, int y) const { return y * m_width + x; }
+    bool isBlocked(int index) const { return m_blocked[index] != 0; }
+    bool isWalkable(int x, int y) const { return inBounds(x, y) && !m_blocked[toIndex(x, y)]; }
+    void setBlocked(int x, int y, bool blocked);
+
+    /// 第 y 行的通行位（位为 1 表示可通行，网格外的位为 0），共 getRowWords() 个字
+    const std::uint64_t* getRowBits(int y) const { return &m_rowBits[static_cast<size_t>(y) * m_rowWords]; }
+
+    /// 第 x 列的通行位（转置存储，用于纵向扫描），共 getColumnWords() 个字
+    const std::uint64_t* getColumnBits(int x) const { return &m_columnBits[static_cast<size_t>(x) * m_columnWords]; }
+
+    int getRowWords() const { return m_rowWords; }
+    int getColumnWords() const { return m_columnWords; }
+
+    /// 世界坐标所在的格子下标（网格外返回 -1）
+    int worldToIndex(const sf::Vector2f& position) const;
+
+    /// 格子中心的世界坐标
+    sf::Vector2f cellCenter(int index) const;
+
+private:
+    /// 计算与区域重叠的格子范围（闭区间，已裁剪到网格内），区域在网格外时返回 false
+    bool cellRange(const sf::FloatRect& area, int& minX, int& minY, int& maxX, int& maxY) const;
+
+    sf::Vector2f m_origin{0.f, 0.f};
+    float m_cellSize{32.f};
+    int m_width{0};
+    int m_height{0};
+    std::vector<std::uint8_t> m_blocked;
+    int m_rowWords{0};
+    int m_columnWords{0};
+    std::vector<std::uint64_t> m_rowBits;
+    std::vector<std::uint64_t> m_columnBits;
+};
+
+/**
+ * @brief 流场 - 从一组目标格子出发的 Dijkstra 积分场
+ *
+ * 每个格子保存到最近目标的路径长度和下一步的格子（8 邻接，不允许斜穿墙角）。
+ * 任意数量的单位都只需 O(1) 采样方向，计算量与单位数量无关。
+ * 目标格子不变时，通行性变化只修复受影响的子树，不重算整个网格。
+ */
+class FlowField {
+public:
+    /// 从目标格子重新计算整个场
+    void build(const NavGrid& grid, const std::vector<int>& goals);
+
+    /// 通行性变化后局部修复（changed 为发生变化的格子）
+    void repair(const NavGrid& grid, const std::vector<int>& changed);
+
+    /// 格子到目标的路径长度（以格子为单位，不可达时为无穷大）
+    float getDistance(int index) const { return m_distance[index]; }
+
+    /// 下一步的格子（目标格子或不可达时为 -1）
+    int getNext(int index) const { return m_next[index]; }
+
+    const std::vector<int>& getGoals() const { return m_goals; }
+
+    /// 已计算的格子数（尚未 build 时为 0）
+    size_t getCellCount() const { return m_next.size(); }
+
+    /// 修复时重新计算的格子数（用于调试输出）
+    size_t getLastRepairCount() const { return m_lastRepairCount; }
+
+private:
+    /// 从堆中的格子向外松弛，直到堆为空
+    void propagate(const NavGrid& grid);
+
+    /// 更新格子距离并入堆
+    void relaxTo(int index, float distance, int next);
+
+    struct QueueItem {
+        float distance;
+        int index;
+        bool operator>(const QueueItem& other) const { return distance > other.distance; }
+    };
+
+    std::vector<float> m_distance;
+    std::vector<int> m_next;
+    std::vector<int> m_goals;
+    std::vector<QueueItem> m_heap;             // 最小堆（std::push_heap / std::pop_heap）
+    std::vector<std::uint8_t> m_invalid;       // 修复时被失效的格子
+    std::vector<int> m_invalidList;
+    size_t m_lastRepairCount{0};
+};
+
+/// 网格上的格子范围（闭区间）
+struct CellRect {
+    int minX{0};
+    int minY{0};
+    int maxX{-1};
+    int maxY{-1};
+
+    bool contains(int x, int y) const { return x >= minX && x <= maxX && y >= minY && y <= maxY; }
+};
+
+/**
+ * @brief 网格底层搜索 - 限定在格子范围内的 8 邻接 A* / Dijkstra
+ *
+ * 临时数组按整个网格分配并用代数戳复用，不需要在每次搜索前清空。
+ */
+class GridSearch {
+public:
+    /**
+     * @brief 在 bounds 内从 start 到 goal 做 A*
+     * @param path 成功时写入从 start 到 goal 的格子序列（含两端）
+     * @param cost 成功时写入路径长度
+     */
+    bool findPath(const NavGrid& grid, int start, int goal, const CellRect& bounds,
+                  std::vector<int>& path, float& cost);
+
+    /// 在 bounds 内从 start 出发做 Dijkstra，按 targets 的顺序写出路径长度（不可达为无穷大）
+    void distances(const NavGrid& grid, int start, const CellRect& bounds,
+                   const std::vector<int>& targets, std::vector<float>& out);
+
+    /**
+     * @brief 同一目标的多条路径：从 goal 反向做一次 Dijkstra，所有起点都确定后停止
+     * @param paths 按 starts 的顺序写入从起点到 goal 的格子序列（不可达时为空）
+     */
+    void pathsToGoal(const NavGrid& grid, int goal, const std::vector<int>& starts, const CellRect& bounds,
+                     std::vector<std::vector<int>>& paths);
+
+private:
+    void prepare(size_t cellCount);
+    bool isSeen(int index) const { return m_seen[index] == m_generation; }
+    bool isClosed(int index) const { return m_closed[index] == m_generation; }
+
+    struct QueueItem {
+        float priority;
+        int index;
+        bool operator>(const QueueItem& other) const { return priority > other.priority; }
+    };
+
+    std::uint32_t m_generation{0};
+    std::vector<std::uint32_t> m_seen;
+    std::vector<std::uint32_t> m_closed;
+    std::vector<float> m_cost;
+    std::vector<int> m_parent;
+    std::vector<QueueItem> m_heap;
+};
+
+/**
+ * @brief 跳点搜索（JPS）- 整张网格上的最优路径
+ *
+ * 网格代价均匀时，沿直线和对角线“跳过”对称路径，只把拐点（跳点）放进开放列表。
+ * 直线扫描按 64 格一字使用 NavGrid 打包的通行位：阻挡和强迫邻居都用位运算一次找出。
+ * 与 GridSearch 使用同样的移动规则（8 邻接，不允许斜穿墙角），路径长度相同。
+ */
+class JumpPointSearch {
+public:
+    /**
+     * @brief 从 start 到 goal 的最优路径
+     * @param path 成功时写入从 start 到 goal 的格子序列（含两端，跳点之间已展开）
+     * @param cost 成功时写入路径长度
+     */
+    bool findPath(const NavGrid& grid, int start, int goal, std::vector<int>& path, float& cost);
+
+    /// 上一次搜索展开的跳点数（用于基准测试）
+    size_t getLastExpandedCount() const { return m_lastExpanded; }
+
+private:
+    void prepare(size_t cellCount);
+    bool isSeen(int index) const { return m_seen[index] == m_generation; }
+    bool isClosed(int index) const { return m_closed[index] == m_generation; }
+
+    /// 从 (x, y) 沿直线方向跳，返回遇到的跳点（或 goal），撞墙返回 -1
+    int jumpStraight(const NavGrid& grid, int x, int y, int dx, int dy, int goalX, int goalY) const;
+
+    /// 从 (x, y) 沿对角方向跳，两个分量方向上能跳到跳点的格子本身就是跳点
+    int jumpDiagonal(const NavGrid& grid, int x, int y, int dx, int dy, int goalX, int goalY) const;
+
+    struct QueueItem {
+        float priority;
+        int index;
+        bool operator>(const QueueItem& other) const { return priority > other.priority; }
+    };
+
+    std::uint32_t m_generation{0};
+    std::vector<std::uint32_t> m_seen;
+    std::vector<std::uint32_t> m_closed;
+    std::vector<float> m_cost;
+    std::vector<int> m_parent;
+    std::vector<QueueItem> m_heap;
+    std::vector<int> m_jumpPoints;
+    size_t m_lastExpanded{0};
+};
+
+/**
+ * @brief 路径缓存 - 按 (起点格子, 目标格子, 导航版本) 缓存格子路径，容量满时淘汰最久未用的
+ *
+ * NPC 的差事（去工作台、回床位）大多重复同样的路线。导航版本变化后旧条目不会再命中，
+ * 随后自然被淘汰，不需要主动清理。不可达的结果也缓存（空路径）。
+ */
+class PathCache {
+public:
+    explicit PathCache(size_t capacity = 256) : m_capacity(capacity) {}
+
+    /// 设置容量（缩小时立即淘汰多出的条目）
+    void setCapacity(size_t capacity);
+
+    /// 命中时标记为最近使用并返回路径（空路径表示不可达），未命中返回 nullptr
+    const std::vector<int>* find(int start, int goal, std::uint32_t version);
+
+    /// 写入（已存在则覆盖），容量满时复用最久未用条目的存储
+    void store(int start, int goal, std::uint32_t version, const std::vector<int>& path);
+
+    void clear();
+
+    size_t size() const { return m_entries.size(); }
+    size_t getHits() const { return m_hits; }
+    size_t getMisses() const { return m_misses; }
+
+private:
+    struct Key {
+        int start;
+        int goal;
+        std::uint32_t version;
+        bool operator==(const Key& other) const {
+            return start == other.start && goal == other.goal && version == other.version;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        std::vector<int> path;
+    };
+
+    size_t m_capacity;
+    std::list<Entry> m_entries;   // 前端为最近使用
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+    size_t m_hits{0};
+    size_t m_misses{0};
+};
+
+/**
+ * @brief 分层寻路（HPA*）- 长距离路径
+ *
+ * 网格划分为固定大小的簇，相邻簇的公共边上每段连续可通行区域生成入口（短段取中点，长段取两端）。
+ * 抽象图的节点是入口格子：跨簇边代价为 1，同簇入口之间的代价预先算好并缓存。
+ * 查询先在抽象图上做 A*，再只在需要时逐段细化为格子路径（每段限定在一个簇内）。
+ * 通行性变化只让所在的簇失效，重建时只重算这些簇及其邻簇的入口和簇内代价。
+ * 查询不修改抽象图，临时数据放在调用方的 QueryContext 里，多个线程可以各用一份上下文并发查询。
+ */
+class HierarchicalPathfinder {
+public:
+    /// 查询用的临时数据（每个线程一份）
+    class QueryContext {
+        friend class HierarchicalPathfinder;
+
+        struct QueueItem {
+            float priority;
+            int node;
+            bool operator>(const QueueItem& other) const { return priority > other.priority; }
+        };
+
+        struct Record {
+            float cost{0.f};
+            int parent{-1};
+            std::uint32_t generation{0};
+            bool closed{false};
+        };
+
+        GridSearch search;
+        std::vector<int> targets;
+        std::vector<float> startCosts;
+        std::vector<float> goalCosts;
+        std::vector<Record> records;          // 按抽象节点编号，代数戳复用
+        std::uint32_t generation{0};
+        std::vector<QueueItem> heap;
+        std::vector<int> segment;
+        std::vector<int> route;
+    };
+
+    /// 按簇边长（格子数）重建整个抽象图（search 提供簇内代价计算的缓冲）
+    void build(const NavGrid& grid, int clusterSize, GridSearch& search);
+
+    /// 标记包含这些格子的簇失效（下一次 refresh 时重建）
+    void invalidateCells(const NavGrid& grid, const std::vector<int>& cells);
+
+    /// 重建失效的簇，返回重建的簇数
+    size_t refresh(const NavGrid& grid, GridSearch& search);
+
+    /**
+     * @brief 抽象路径查询
+     * @param route 成功时写入起点、途经的入口格子、终点（格子下标）
+     */
+    bool findRoute(const NavGrid& grid, int start, int goal, std::vector<int>& route,
+                   QueryContext& context) const;
+
+    /**
+     * @brief 把抽象路径上相邻的两个节点细化为格子路径
+     * @param cells 写入从 from 到 to 的格子序列（含两端）
+     */
+    bool refineSegment(const NavGrid& grid, int from, int to, std::vector<int>& cells,
+                       QueryContext& context) const;
+
+    /// 抽象查询并细化整条路径（基准测试和短路径用；长路径应逐段细化）
+    bool findPath(const NavGrid& grid, int start, int goal, std::vector<int>& cells,
+                  QueryContext& context) const;
+
+    int getClusterSize() const { return m_clusterSize; }
+    size_t getClusterCount() const { return m_clusters.size(); }
+    size_t getPortalCount() const { return m_portalIndex.size(); }
+
+private:
+    struct Portal {
+        int cell;
+        std::vector<int> partners;   // 相邻簇中与之相连的入口格子
+        std::vector<int> links;      // partners 对应的抽象节点编号（查询时免去格子到入口的查表）
+    };
+
+    struct Cluster {
+        CellRect bounds;
+        std::vector<Portal> portals;
+        std::vector<float> costs;    // 入口两两之间的簇内路径长度（n × n，不可达为无穷大）
+        std::vector<int> regions;    // 每个入口所在簇内连通区域中下标最小的入口
+        bool dirty{false};
+    };
+
+    int clusterOf(const NavGrid& grid, int cell) const;
+    void rebuildPortals(const NavGrid& grid, int clusterIndex);
+    void rebuildCosts(const NavGrid& grid, int clusterIndex, GridSearch& search);
+    void linkPortals(const NavGrid& grid, int clusterIndex);
+
+    /// 给抽象图的连通分量编号（查询时直接拒绝不连通的起终点，不必搜完整张图）
+    void labelComponents();
+
+    /// 与相邻簇公共边上的入口（ownCell 在本簇，otherCell 在邻簇）
+    void collectTransitions(const NavGrid& grid, int clusterIndex, int dx, int dy,
+                            std::vector<std::pair<int, int>>& transitions) const;
+
+    int m_clusterSize{16};
+    int m_portalStride{64};                       // 抽象节点编号中每个簇占用的入口数
+    int m_clustersX{0};
+    int m_clustersY{0};
+    std::vector<Cluster> m_clusters;
+    std::unordered_map<int, int> m_portalIndex;   // 入口格子 -> 在所属簇 portals 中的下标
+    std::vector<int> m_dirtyClusters;
+    std::vector<int> m_components;                // 抽象节点编号 -> 连通分量编号
+
+    // 重建用的临时数据
+    std::vector<std::pair<int, int>> m_transitions;
+    std::vector<int> m_targets;
+    std::vector<float> m_row;
+};
+
+/// 导航数据的不可变快照（供工作线程寻路），通行性每变化一次 version 递增
+struct NavSnapshot {
+    NavGrid grid;
+    HierarchicalPathfinder hierarchy;
+    std::uint32_t version{0};
+};
+
+/**
+ * @brief 寻路器 - 僵尸群的流场导航与 NPC 的长距离寻路
+ *
+ * 功能：
+ * - 维护覆盖整个世界的导航网格和一个以吸引点（玩家等）为目标的流场
+ * - 吸引点所在的格子变化时重算流场，否则只修复被标记为脏的区域
+ * - 分层寻路（HPA*）用于跨地图的路径（如全员召唤），脏区域只让所在的簇失效
+ * - 建筑放置、摧毁时由 BuildingSystem / CombatSystem 标记脏区域
+ */
+class Pathfinder {
+public:
+    Pathfinder() = default;
+    ~Pathfinder();
+
+    /// 初始化网格并栅格化当前所有静态碰撞体，clusterSize 为 HPA* 的簇边长（格子数）
+    void init(Registry& registry, const sf::FloatRect& worldBounds, float cellSize, int clusterSize = 16);
+
+    /// 标记区域内的通行性需要重新计算（下一次 update 时处理）
+    void markDirty(const sf::FloatRect& area) { m_dirtyRegions.push_back(area); }
+
+    /**
+     * @brief 处理脏区域并在目标格子变化时重算流场
+     * @param attractors 吸引点（世界坐标）
+     */
+    void update(Registry& registry, const std::vector<sf::Vector2f>& attractors);
+
+    /**
+     * @brief 采样流场方向
+     * @param direction 成功时写入朝下一格中心的单位向量
+     * @return 位置在目标格子、阻挡格子或不可达区域时返回 false（调用方直接朝目标移动）
+     */
+    bool sampleDirection(const sf::Vector2f& position, sf::Vector2f& direction) const;
+
+    /// 采样流场的下一格中心（世界坐标），失败条件同 sampleDirection
+    bool sampleWaypoint(const sf::Vector2f& position, sf::Vector2f& waypoint) const;
+
+    /**
+     * @brief 长距离路径（HPA*）的抽象路线
+     * @param route 写入起点、途经的入口格子、终点（格子下标）；用 refineRouteSegment 逐段展开
+     */
+    bool findRoute(const sf::Vector2f& from, const sf::Vector2f& to, std::vector<int>& route);
+
+    /// 把路线上相邻两个节点展开为格子中心的路点（不含起始节点）
+    bool refineRouteSegment(int fromCell, int toCell, std::vector<sf::Vector2f>& waypoints);
+
+    const NavGrid& getGrid() const { return m_grid; }
+    const FlowField& getFlowField() const { return m_flowField; }
+    const HierarchicalPathfinder& getHierarchy() const { return m_hierarchy; }
+
+    /// 导航数据版本（通行性每变化一次递增）
+    std::uint32_t getVersion() const { return m_version; }
+
+    /// 当前版本的不可变快照（版本不变时返回同一个快照）
+    std::shared_ptr<const NavSnapshot> getSnapshot();
+
+private:
+    bool m_initialized{false};
+    NavGrid m_grid;
+    FlowField m_flowField;
+    HierarchicalPathfinder m_hierarchy;
+    HierarchicalPathfinder::QueryContext m_queryContext;
+    GridSearch m_buildSearch;
+    std::uint32_t m_version{0};
+    std::shared_ptr<const NavSnapshot> m_snapshot;
+    std::vector<sf::FloatRect> m_dirtyRegions;
+    std::vector<int> m_changedCells;
+    std::vector<int> m_goalCells;
+};
+
+} // namespace Nightfall
@@ -0,0 +1,112 @@
+﻿#include "Pathfinding.h"
+#include "../ecs/Registry.h"
+#include "../core/Logger.h"
+#include <algorithm>
+
+// 寻路与 ECS 的接口：从 Registry 的静态碰撞体索引栅格化导航网格。
+// 单独成文件，寻路算法本身（Pathfinding.cpp）不依赖 Registry，测试与基准只需链接寻路代码。
+
+namespace Nightfall {
+
+// ========== NavGrid ==========
+
+void NavGrid::rasterize(Registry& registry) {
+    std::vector<int> changed;
+    rasterizeRegion(registry, sf::FloatRect(m_origin, sf::Vector2f(m_width * m_cellSize, m_height * m_cellSize)),
+                    changed);
+}
+
+void NavGrid::rasterizeRegion(Registry& registry, const sf::FloatRect& area, std::vector<int>& changed) {
+    int minX, minY, maxX, maxY;
+    if (!cellRange(area, minX, minY, maxX, maxY)) return;
+
+    // 先收集覆盖这些格子的实心静态碰撞体，再逐格测试格子中心
+    const sf::FloatRect cells(m_origin + sf::Vector2f(minX * m_cellSize, minY * m_cellSize),
+                              sf::Vector2f((maxX - minX + 1) * m_cellSize, (maxY - minY + 1) * m_cellSize));
+    std::vector<sf::FloatRect> obstacles;
+    registry.getStaticIndex().query(cells, [&](entt::entity entity, const sf::FloatRect& bounds) {
+        const auto* collider = registry.tryGetComponent<Collider>(entity);
+        if (collider && !collider->isTrigger) {
+            obstacles.push_back(bounds);
+        }
+    });
+
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            const int index = toIndex(x, y);
+            const sf::Vector2f center = cellCenter(index);
+
+            bool blocked = false;
+            for (const auto& bounds : obstacles) {
+                if (center.x >= bounds.position.x && center.x < bounds.position.x + bounds.size.x &&
+                    center.y >= bounds.position.y && center.y < bounds.position.y + bounds.size.y) {
+                    blocked = true;
+                    break;
+                }
+            }
+
+            if (isBlocked(index) != blocked) {
+                setBlocked(x, y, blocked);
+                changed.push_back(index);
+            }
+        }
+    }
+}
+
+// ========== Pathfinder ==========
+
+void Pathfinder::init(Registry& registry, const sf::FloatRect& worldBounds, float cellSize, int clusterSize) {
+    m_grid.resize(worldBounds, cellSize);
+    m_grid.rasterize(registry);
+    m_dirtyRegions.clear();
+    m_goalCells.clear();
+    m_flowField.build(m_grid, m_goalCells);
+    m_hierarchy.build(m_grid, clusterSize, m_buildSearch);
+    m_snapshot.reset();
+    ++m_version;
+    m_initialized = true;
+
+    NF_INFO("Pathfinder initialized ({}x{} cells, cell size: {}, {} clusters, {} portals)",
+            m_grid.getWidth(), m_grid.getHeight(), m_grid.getCellSize(),
+            m_hierarchy.getClusterCount(), m_hierarchy.getPortalCount());
+}
+
+void Pathfinder::update(Registry& registry, const std::vector<sf::Vector2f>& attractors) {
+    if (!m_initialized) return;
+
+    // 重新栅格化脏区域，收集通行性变化的格子
+    m_changedCells.clear();
+    for (const auto& area : m_dirtyRegions) {
+        m_grid.rasterizeRegion(registry, area, m_changedCells);
+    }
+    m_dirtyRegions.clear();
+
+    // 分层图只重建通行性变化的簇
+    if (!m_changedCells.empty()) {
+        m_hierarchy.invalidateCells(m_grid, m_changedCells);
+        size_t rebuilt = m_hierarchy.refresh(m_grid, m_buildSearch);
+        ++m_version;
+        NF_DEBUG("Path hierarchy refreshed: {} clusters rebuilt", rebuilt);
+    }
+
+    m_goalCells.clear();
+    for (const auto& position : attractors) {
+        int index = m_grid.worldToIndex(position);
+        if (index >= 0) {
+            m_goalCells.push_back(index);
+        }
+    }
+    std::sort(m_goalCells.begin(), m_goalCells.end());
+    m_goalCells.erase(std::unique(m_goalCells.begin(), m_goalCells.end()), m_goalCells.end());
+
+    if (m_goalCells != m_flowField.getGoals()) {
+        // 目标换了格子：整场重算（代价只与格子数有关）
+        m_flowField.build(m_grid, m_goalCells);
+    } else if (!m_changedCells.empty()) {
+        m_flowField.repair(m_grid, m_changedCells);
+        NF_DEBUG("Flow field repaired: {} cells changed, {} cells recomputed",
+                 m_changedCells.size(), m_flowField.getLastRepairCount());
+    }
+}
+
+} // namespace Nightfall
@@ -3,91 +3,242 @@
 #include "Time.h"
 #include "ResourceManager.h"
 #include "../utils/Config.h"
+#include "../utils/Random.h"
+#include <algorithm>
+#include <cmath>
 #include <optional>
 
 namespace Nightfall {
 
 Application::Application(const std::string& title, unsigned int width, unsigned int height)
-    : m_window(sf::VideoMode({width, height}), title)
+    : m_title(title)
+    , m_windowSize(width, height)
     , m_isRunning(true)
 {
-    // 设置帧率限制
-    int fpsLimit = Config::getInt("window.fps_limit", 60);
-    m_window.setFramerateLimit(fpsLimit);
-    
-    // 启用垂直同步（如果配置启用）
-    bool vsync = Config::getBool("window.vsync", false);
-    if (vsync) {
-        // m_window.setVerticalSyncEnabled(true);
-    }
-    
     NF_CORE_INFO("应用程序初始化成功");
-    NF_CORE_INFO("窗口大小: {}x{}", width, height);
-    NF_CORE_INFO("目标帧率: {} FPS", fpsLimit);
+    
+    // 固定步长模拟：逻辑帧率与渲染帧率解耦
+    int tickRate = std::max(1, Config::getInt("simulation.tick_rate", 60));
+    m_fixedDeltaTime = 1.f / static_cast<float>(tickRate);
+    m_maxSubsteps = std::max(1, Config::getInt("simulation.max_substeps", 5));
+    m_statsLogInterval = std::max(0.f, Config::getFloat("simulation.stats_log_interval", 5.f));
+    NF_CORE_INFO("逻辑帧率: {} Hz（单帧最多 {} 步）", tickRate, m_maxSubsteps);
     
     // 初始化时间系统 (从第1天早上6:00开始)
     float realSecondsPerGameHour = Config::getFloat("gameplay.real_seconds_per_game_hour", 120.0f);
     Time::init(6, 0, 1);
     Time::setGameHourDuration(realSecondsPerGameHour);
     
-    // 初始化资源管理器
-    ResourceManager::getInstance().preloadEssentials();
+    // 随机数种子（各系统在 init 中派生自己的随机数流）
+    Random::init(static_cast<std::uint64_t>(
+        Config::getInt("simulation.random_seed", static_cast<int>(kDefaultRandomSeed))));
+    
+    // 任务系统：系统调度与 Registry::parallel_each 共用同一组工作线程
+    m_jobSystem.init(std::max(0, Config::getInt("simulation.worker_threads", 2)));
+    m_registry.setJobSystem(&m_jobSystem);
+    m_registry.loadArchetypes(Config::getString("archetypes.enemies", "assets/data/enemies.json"),
+                              Config::getString("archetypes.buildings", "assets/data/buildings.json"));
+    if (Config::getBool("pooling.enabled", true)) {
+        // 僵尸死亡后停放复用，整波生成和死亡不再反复增删存储
+        const int zombieCapacity = std::max(0, Config::getInt("pooling.zombie_capacity", 2048));
+        for (ZombieType type : {ZombieType::Normal, ZombieType::Fast, ZombieType::Tank, ZombieType::Exploder, ZombieType::Boss}) {
+            m_registry.enablePooling(m_registry.getArchetypes().getZombie(type), static_cast<size_t>(zombieCapacity));
+        }
+    }
     
     // 初始化 ECS 系统
+    m_spatialQuery.init(m_registry);
     m_renderingSystem.init();
     m_movementSystem.init();
+    m_survivalSystem.setEnabled(Config::getBool("survival.enabled", true));
+    m_survivalSystem.setStarvationDamage(Config::getBool("survival.starvation_damage", false));
+    m_survivalSystem.init();
     m_combatSystem.init();
     m_visualEffectsSystem.init();
     m_resourceSystem.init();
-    m_aiSystem.init();
+    m_aiSystem.init(m_registry);
     m_aiSystem.setCombatSystem(&m_combatSystem);
+    m_aiSystem.setPhysicsSystem(&m_physicsSystem);
+    m_aiSystem.setPathfinder(&m_pathfinder);
+    m_aiSystem.setPathService(&m_pathService);
+    m_aiSystem.setNPCController(&m_npcController);
+    m_aiSystem.setLodSettings(Config::getFloat("ai.lod_near_distance", 600.f),
+                              Config::getFloat("ai.lod_mid_distance", 1200.f),
+                              Config::getInt("ai.lod_mid_interval", 2),
+                              Config::getInt("ai.lod_far_interval", 8));
+    m_npcController.init(m_registry);
+    m_npcController.setResourceSystem(&m_resourceSystem);
+    m_npcController.setSearchSettings(Config::getFloat("npc.job_search_radius", 800.f),
+                                      Config::getInt("npc.job_candidates", 4));
+    m_npcController.setWorkSettings(Config::getFloat("npc.work_range", 40.f),
+                                    Config::getFloat("npc.repair_rate", 10.f),
+                                    Config::getFloat("npc.refill_time", 3.f),
+                                    Config::getFloat("npc.repair_threshold", 0.8f));
+    m_formationSystem.setPathService(&m_pathService);
+    m_formationSystem.setSquadSettings(Config::getInt("formation.squad_size", 16),
+                                       Config::getFloat("formation.spacing", 40.f));
+    m_formationSystem.setMarchSettings(Config::getFloat("formation.arrive_distance", 150.f),
+                                       Config::getFloat("formation.repath_distance", 256.f));
+    m_formationSystem.init(m_registry);
+    m_crowdSystem.setEnabled(Config::getBool("crowd.enabled", true));
+    m_crowdSystem.setNeighborRadius(Config::getFloat("crowd.neighbor_radius", 48.f));
+    m_crowdSystem.setMaxNeighbors(Config::getInt("crowd.max_neighbors", 8));
+    m_crowdSystem.setWeights(Config::getFloat("crowd.separation_weight", 1.5f),
+                             Config::getFloat("crowd.alignment_weight", 0.3f),
+                             Config::getFloat("crowd.cohesion_weight", 0.1f));
+    m_crowdSystem.init();
     m_buildingSystem.init();
     m_buildingSystem.setResourceSystem(&m_resourceSystem);
+    m_buildingSystem.setPathfinder(&m_pathfinder);
+    m_buildingSystem.setPhysicsSystem(&m_physicsSystem);
     m_turretSystem.init();
     m_turretSystem.setCombatSystem(&m_combatSystem);
     m_turretSystem.setVisualEffectsSystem(&m_visualEffectsSystem);
+    m_turretSystem.setSpatialQuery(&m_spatialQuery);
+    m_turretSystem.setProjectileSystem(&m_projectileSystem);
+    m_projectileSystem.setCapacity(static_cast<size_t>(std::max(0, Config::getInt("projectiles.max_count", 4096))));
+    m_projectileSystem.setCellSize(Config::getFloat("projectiles.cell_size", 64.f));
+    m_projectileSystem.init();
+    m_projectileSystem.setCombatSystem(&m_combatSystem);
     m_combatSystem.setVisualEffectsSystem(&m_visualEffectsSystem);
     m_combatSystem.setResourceSystem(&m_resourceSystem);
+    m_combatSystem.setPathfinder(&m_pathfinder);
     
     // 设置物理系统世界边界
     m_physicsSystem.setWorldBounds(sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(static_cast<float>(width), static_cast<float>(height))));
     
+    // 碰撞宽相位：spatial_hash（默认）或 brute_force（暴力 O(N²)，用于对比）
+    std::string broadphase = Config::getString("physics.broadphase", "spatial_hash");
+    m_physicsSystem.setBroadphase(broadphase == "brute_force"
+        ? PhysicsSystem::Broadphase::BruteForce
+        : PhysicsSystem::Broadphase::SpatialHash);
+    m_physicsSystem.setCellSize(Config::getFloat("physics.cell_size", 64.f));
+    NF_CORE_INFO("碰撞宽相位: {}", broadphase);
+    
+    // 物体休眠：静止一段时间的动态物体不再参与积分和碰撞，写入速度或被碰撞时唤醒
+    m_physicsSystem.setSleepEnabled(Config::getBool("physics.sleep_enabled", true));
+    m_physicsSystem.setSleepParameters(Config::getInt("physics.sleep_ticks", 30),
+                                       Config::getFloat("physics.sleep_velocity", 1.f));
+    
+    // 碰撞层矩阵：列出的层对互不碰撞，也不产生触发事件
+    const auto& physicsConfig = Config::getConfig().value("physics", nlohmann::json::object());
+    for (const auto& pair : physicsConfig.value("ignore_layer_pairs", nlohmann::json::array())) {
+        if (!pair.is_array() || pair.size() != 2 || !pair[0].is_string() || !pair[1].is_string()) continue;
+        
+        std::uint32_t layerA = PhysicsSystem::layerFromName(pair[0].get<std::string>());
+        std::uint32_t layerB = PhysicsSystem::layerFromName(pair[1].get<std::string>());
+        if (layerA == 0 || layerB == 0) {
+            NF_CORE_WARN("未知的碰撞层: {} / {}", pair[0].get<std::string>(), pair[1].get<std::string>());
+            continue;
+        }
+        m_physicsSystem.setLayerCollision(layerA, layerB, false);
+    }
+    
     // 初始化波次系统
     m_waveSystem.init(sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(static_cast<float>(width), static_cast<float>(height))));
+    m_waveSystem.setSpawnInterval(Config::getFloat("waves.spawn_interval", 1.f));
+    m_waveSystem.setSpawnBatchSize(Config::getInt("waves.spawn_batch_size", 0));
+    
+    // 创建游戏实体
+    initEntities();
+    
+    // 导航网格覆盖整个世界，从初始的静态碰撞体栅格化
+    m_pathfinder.init(m_registry, m_physicsSystem.getWorldBounds(), Config::getFloat("pathfinding.cell_size", 32.f),
+                      Config::getInt("pathfinding.cluster_size", 16));
+    
+    // 寻路请求在工作线程上对导航快照求解，结果在每个逻辑帧的同步点发布
+    m_pathService.setFrameBudget(Config::getInt("pathfinding.max_jobs_per_frame", 8),
+                                 Config::getFloat("pathfinding.inline_budget_ms", 2.f));
+    m_pathService.setCacheCapacity(static_cast<size_t>(Config::getInt("pathfinding.path_cache_size", 256)));
+    m_pathService.init(&m_pathfinder, Config::getInt("pathfinding.worker_threads", 2));
+    
+    // 逻辑帧的系统按声明的组件访问建图，互不冲突的系统在调度线程上并发执行
+    m_scheduler.setJobSystem(&m_jobSystem);
+    registerSystems();
+    m_scheduler.build(m_registry);
+}
+
+void Application::initGraphics() {
+    // 窗口、纹理和字体都需要图形上下文，只在有窗口的模式下创建
+    m_window = std::make_unique<sf::RenderWindow>(sf::VideoMode(m_windowSize), m_title);
+    
+    // 设置帧率限制
+    int fpsLimit = Config::getInt("window.fps_limit", 60);
+    m_window->setFramerateLimit(fpsLimit);
+    
+    // 启用垂直同步（如果配置启用）
+    bool vsync = Config::getBool("window.vsync", false);
+    if (vsync) {
+        // m_window->setVerticalSyncEnabled(true);
+    }
+    
+    NF_CORE_INFO("窗口大小: {}x{}", m_windowSize.x, m_windowSize.y);
+    NF_CORE_INFO("目标帧率: {} FPS", fpsLimit);
+    
+    // 初始化资源管理器
+    ResourceManager::getInstance().preloadEssentials();
     
     // 初始化 UI 系统
     auto* font = ResourceManager::getInstance().getFont("default");
     m_hud.init(font);
-    
-    // 创建游戏实体
-    initEntities();
+    m_visualEffectsSystem.setFont(font);
 }
 
 void Application::run() {
+    if (!m_window) {
+        initGraphics();
+    }
+    
     NF_CORE_INFO("========== 游戏循环启动 ==========");
     
-    while (m_isRunning && m_window.isOpen()) {
+    m_clock.restart();
+    m_accumulator = 0.f;
+    
+    while (m_isRunning && m_window->isOpen()) {
         // 计算帧间隔时间
-        float deltaTime = m_clock.restart().asSeconds();
+        float frameTime = m_clock.restart().asSeconds();
         
-        // 限制 deltaTime 防止卡顿时出现大跳跃
-        if (deltaTime > 0.1f) {
-            deltaTime = 0.1f;
+        processEvents();
+        
+        // 以固定步长推进逻辑，最多追赶 m_maxSubsteps 步
+        m_accumulator += frameTime;
+        int substeps = 0;
+        while (m_accumulator >= m_fixedDeltaTime && substeps < m_maxSubsteps) {
+            fixedUpdate(m_fixedDeltaTime);
+            m_accumulator -= m_fixedDeltaTime;
+            ++substeps;
         }
         
-        processEvents();
-        update(deltaTime);
-        render();
+        // 追赶不上时丢弃积压的整步，防止卡顿后越积越多（螺旋死亡）
+        if (m_accumulator >= m_fixedDeltaTime) {
+            m_accumulator = std::fmod(m_accumulator, m_fixedDeltaTime);
+        }
+        
+        frameUpdate(frameTime);
+        render(m_accumulator / m_fixedDeltaTime);
     }
     
     NF_CORE_INFO("========== 游戏循环结束 ==========");
 }
 
+void Application::runHeadless(int tickCount) {
+    NF_CORE_INFO("========== 无渲染模拟启动: {} 逻辑帧 ==========", tickCount);
+    
+    sf::Clock clock;
+    for (int tick = 0; tick < tickCount && m_isRunning; ++tick) {
+        fixedUpdate(m_fixedDeltaTime);
+    }
+    
+    float elapsed = clock.getElapsedTime().asSeconds();
+    NF_CORE_INFO("模拟了 {:.1f} 秒游戏时间，耗时 {:.3f} 秒（{:.0f} 逻辑帧/秒）",
+                 tickCount * m_fixedDeltaTime, elapsed, elapsed > 0.f ? tickCount / elapsed : 0.f);
+}
+
 void Application::processEvents() {
-    while (std::optional<sf::Event> event = m_window.pollEvent()) {
+    while (std::optional<sf::Event> event = m_window->pollEvent()) {
         if (event->is<sf::Event::Closed>()) {
             m_isRunning = false;
-            m_window.close();
+            m_window->close();
         }
         else if (const auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
             if (keyPressed->code == sf::Keyboard::Key::Escape) {
@@ -131,6 +282,12 @@ void Application::processEvents() {
                     NF_INFO("Building cancelled");
                 }
             }
+            // M键全员迁移：所有已招募的 NPC 结阵前往玩家位置
+            else if (keyPressed->code == sf::Keyboard::Key::M) {
+                if (auto* transform = m_registry.tryGetComponent<Transform>(m_player)) {
+                    m_formationSystem.startMigration(m_registry, transform->position);
+                }
+            }
             // E键采集资源
             else if (keyPressed->code == sf::Keyboard::Key::E) {
                 harvestNearbyResources();
@@ -140,8 +297,8 @@ void Application::processEvents() {
             if (mousePressed->button == sf::Mouse::Button::Left) {
                 // 左键确认放置建筑
                 if (m_buildingSystem.isPlacing()) {
-                    sf::Vector2i mousePixelPos = sf::Mouse::getPosition(m_window);
-                    sf::Vector2f mouseWorldPos = m_window.mapPixelToCoords(mousePixelPos);
+                    sf::Vector2i mousePixelPos = sf::Mouse::getPosition(*m_window);
+                    sf::Vector2f mouseWorldPos = m_window->mapPixelToCoords(mousePixelPos);
                     m_buildingSystem.tryPlaceBuilding(mouseWorldPos, m_registry);
                 }
             }
@@ -155,7 +312,12 @@ void Application::processEvents() {
     }
 }
 
-void Application::update(float deltaTime) {
+void Application::fixedUpdate(float deltaTime) {
+    // 记录上一逻辑帧的位置（渲染插值用）
+    m_registry.each<Transform>([](entt::entity, Transform& transform) {
+        transform.previousPosition = transform.position;
+    });
+    
     // 更新游戏时间
     Time::update(deltaTime);
     
@@ -195,48 +357,155 @@ void Application::update(float deltaTime) {
         }
     }
     
-    // 更新移动系统
-    m_movementSystem.update(deltaTime, m_registry);
-    
-    // 更新AI系统
-    m_aiSystem.update(deltaTime, m_registry, m_player);
-    
-    // 更新炮塔系统
-    m_turretSystem.update(deltaTime, m_registry);
-    
-    // 更新战斗系统（处理死亡）
-    m_combatSystem.update(deltaTime, m_registry);
-    
-    // 更新波次系统
-    m_waveSystem.update(deltaTime, m_registry);
+    // 其余系统由调度器按依赖图执行（见 registerSystems）
+    m_scheduler.run(deltaTime);
     
-    // 更新建筑系统
-    m_buildingSystem.update(deltaTime, m_registry);
+    // 定期输出各系统的统计（无渲染模式同样输出）
+    if (m_statsLogInterval > 0.f) {
+        m_statsLogTimer += deltaTime;
+        if (m_statsLogTimer >= m_statsLogInterval) {
+            m_statsLogTimer = 0.f;
+            logStats();
+        }
+    }
+}
+
+void Application::logStats() const {
+    const SchedulerStats& scheduler = m_scheduler.getStats();
+    NF_DEBUG("调度器: {} 个系统 / {} 个阶段（{} 个可并发），本帧 {:.2f} ms（各系统合计 {:.2f} ms），回放命令缓冲 {} 次",
+             scheduler.systems, scheduler.stages, scheduler.parallelStages, scheduler.tickMs, scheduler.systemMs,
+             scheduler.flushes);
+    
+    const AILodStats& lod = m_aiSystem.getLodStats();
+    const auto tier = [](AILodTier t) { return static_cast<size_t>(t); };
+    NF_DEBUG("AI LOD: 近 {}/{}，中 {}/{}，远 {}/{}（本帧更新/总数），{:.2f} ms",
+             lod.updated[tier(AILodTier::Near)], lod.agents[tier(AILodTier::Near)],
+             lod.updated[tier(AILodTier::Mid)], lod.agents[tier(AILodTier::Mid)],
+             lod.updated[tier(AILodTier::Far)], lod.agents[tier(AILodTier::Far)], lod.updateMs);
+    
+    const BehaviorTreeStats& behavior = m_aiSystem.getBehaviorStats();
+    NF_DEBUG("行为树: {} 个 NPC，{} 批，{} 次叶子，{:.2f} ms",
+             behavior.agents, behavior.batches, behavior.leafRuns, behavior.tickMs);
+    
+    const PathServiceStats& path = m_pathService.getStats();
+    NF_DEBUG("寻路服务: 请求 {}（合并 {}，缓存命中 {}），派发 {}，完成 {}，排队 {}，计算中 {}，"
+             "平均延迟 {:.1f} ms（本帧最大 {:.1f} ms），快照 v{}",
+             path.requestsThisFrame, path.mergedThisFrame, path.cacheHitsThisFrame, path.dispatchedThisFrame,
+             path.completedThisFrame, path.queuedJobs, path.inFlightJobs, path.averageLatencyMs, path.maxLatencyMs,
+             path.snapshotVersion);
+    
+    const JobBoardStats& jobs = m_npcController.getStats();
+    NF_DEBUG("任务板: 开放 修理 {} / 采集 {} / 补料 {}，已认领 {}，空闲工作者 {}，本帧分配 {}，{:.2f} ms",
+             jobs.openJobs[static_cast<size_t>(JobType::Repair)], jobs.openJobs[static_cast<size_t>(JobType::Harvest)],
+             jobs.openJobs[static_cast<size_t>(JobType::Refill)], jobs.claimedJobs, jobs.idleWorkers,
+             jobs.assignedThisFrame, jobs.assignMs);
+    
+    for (const EntityPoolStats& pool : m_registry.getPoolStats()) {
+        NF_DEBUG("实体池 {}: 停放 {}/{}（峰值 {}），新建 {}，复用 {}，回收 {}，丢弃 {}",
+                 pool.archetype, pool.parked, pool.capacity, pool.peakParked, pool.created, pool.revived,
+                 pool.recycled, pool.discarded);
+    }
+}
+
+void Application::registerSystems() {
+    // 注册顺序即单线程时的执行顺序；冲突的系统按此顺序串行，其余并发
+    // 需要立即创建 / 销毁实体或增删组件的系统声明为独占，在主线程上执行；
+    // 其余系统的结构性修改记录到命令缓冲，在每个阶段结束时回放
+    
+    // 寻路同步点：发布上一帧完成的路径，派发新请求
+    m_scheduler.addSyncPoint("path_service", [this] { m_pathService.sync(); });
+    
+    // 任务板：为空闲的 NPC 批量分配工作（由 AI 中的行为树执行）
+    m_scheduler.addSystem("npc_jobs", SystemAccess().exclusive(),
+        [this](float dt) { m_npcController.update(dt, m_registry); });
+    
+    // 更新AI系统（写入期望速度），相机内的僵尸不降频
+    m_scheduler.addSystem("ai", SystemAccess().exclusive(), [this](float dt) {
+        if (m_window) {   // 无渲染模式没有相机，只按与玩家的距离分级
+            const sf::View& view = m_window->getView();
+            m_aiSystem.setCameraView(sf::FloatRect(view.getCenter() - view.getSize() / 2.f, view.getSize()));
+        }
+        m_aiSystem.update(dt, m_registry, m_player);
+    });
     
-    // 更新资源系统（处理资源生产）
-    m_resourceSystem.update(deltaTime, m_registry);
+    // 行军阵型：覆盖迁移中 NPC 的速度（领队寻路，成员向阵位转向）
+    m_scheduler.addSystem("formation", SystemAccess().exclusive(),
+        [this](float dt) { m_formationSystem.update(dt, m_registry, m_player); });
     
-    // 更新视觉效果系统
-    m_visualEffectsSystem.update(deltaTime, m_registry);
+    // 群体转向：在积分之前把尸群的速度修正为互相避让
+    m_scheduler.addSystem("crowd",
+        SystemAccess().read<Transform, Hostile, Asleep>().write<Velocity>().writeResource<CrowdSystem>(),
+        [this](float dt) { m_crowdSystem.update(dt, m_registry); });
     
+    // 更新移动系统
+    m_scheduler.addSystem("movement",
+        SystemAccess().read<Asleep>().write<Transform, Velocity>(),
+        [this](float dt) { m_movementSystem.update(dt, m_registry); });
+    
+    // 同步空间查询索引：在移动之后，炮塔查询本帧位置；AI 与建筑放置读到的是上一帧移动后的位置
+    m_scheduler.addSystem("spatial_query",
+        SystemAccess().read<Transform, Collider, Hostile, Building, ResourceNode, Dropped>().writeResource<SpatialQuery>(),
+        [this](float) { m_spatialQuery.update(m_registry); });
+    
+    // 炮塔、弹道、战斗的伤害结算经由 CombatSystem，死亡实体记录到命令缓冲、在阶段结束时销毁
+    m_scheduler.addSystem("turret",
+        SystemAccess().read<Transform>().write<Turret, Health, Building>()
+            .readResource<SpatialQuery>().writeResource<ProjectileSystem, VisualEffectsSystem, CombatSystem, Pathfinder>(),
+        [this](float dt) { m_turretSystem.update(dt, m_registry); });
+    
+    m_scheduler.addSystem("projectile",
+        SystemAccess().read<Transform, Collider, Hostile, Player>().write<Health, Building>()
+            .writeResource<ProjectileSystem, VisualEffectsSystem, CombatSystem, Pathfinder>(),
+        [this](float dt) { m_projectileSystem.update(dt, m_registry); });
+    
+    m_scheduler.addSystem("combat",
+        SystemAccess().read<Health, Player, Zombie, Transform>()
+            .writeResource<CombatSystem, VisualEffectsSystem, ResourceSystem>(),
+        [this](float dt) { m_combatSystem.update(dt, m_registry); });
+    
+    // 波次直接创建僵尸
+    m_scheduler.addSystem("wave", SystemAccess().exclusive(),
+        [this](float dt) { m_waveSystem.update(dt, m_registry); });
+    
+    // 以下系统只改写已有组件：建造、粒子、生存状态先并发，资源生产与物理等建造进度写完后并发
+    m_scheduler.addSystem("building",
+        SystemAccess().read<Transform>().write<Building>(),
+        [this](float dt) { m_buildingSystem.update(dt, m_registry); });
+    
+    m_scheduler.addSystem("survival",
+        SystemAccess().write<Hunger, Stamina, Health>(),
+        [this](float dt) { m_survivalSystem.update(dt, m_registry); });
+    
+    m_scheduler.addSystem("resource",
+        SystemAccess().read<Building>().write<Producer, ResourceNode, Sprite>().writeResource<ResourceSystem>(),
+        [this](float dt) { m_resourceSystem.update(dt, m_registry); });
+    
+    m_scheduler.addSystem("visual_effects",
+        SystemAccess().writeResource<VisualEffectsSystem>(),
+        [this](float dt) { m_visualEffectsSystem.update(dt, m_registry); });
+    
+    // 物理只增删自己的 Asleep 组件，声明为写入即可与上面的系统并发
+    m_scheduler.addSystem("physics",
+        SystemAccess().read<Collider, Static>().write<Transform, Velocity, Asleep>().writeResource<PhysicsSystem>(),
+        [this](float dt) { m_physicsSystem.update(dt, m_registry); });
+}
+
+void Application::frameUpdate(float frameTime) {
     // 更新鼠标位置用于建筑预览
     if (m_buildingSystem.isPlacing()) {
-        sf::Vector2i mousePixelPos = sf::Mouse::getPosition(m_window);
-        sf::Vector2f mouseWorldPos = m_window.mapPixelToCoords(mousePixelPos);
+        sf::Vector2i mousePixelPos = sf::Mouse::getPosition(*m_window);
+        sf::Vector2f mouseWorldPos = m_window->mapPixelToCoords(mousePixelPos);
         m_buildingSystem.updatePreview(mouseWorldPos, m_registry);
     }
     
-    // 更新物理/碰撞系统
-    m_physicsSystem.update(deltaTime, m_registry);
-    
     // 更新 HUD
-    m_hud.update(deltaTime, m_registry, m_player);
+    m_hud.update(frameTime, m_registry, m_player);
     m_hud.updateWaveInfo(m_waveSystem.getCurrentWave(), m_waveSystem.getEnemiesRemaining());
     m_hud.updateResources(&m_resourceSystem);
     m_hud.updateBuildingCost(&m_buildingSystem);
 }
 
-void Application::render() {
+void Application::render(float alpha) {
     // 根据时间段设置背景色
     sf::Color bgColor;
     switch (Time::getTimeOfDay()) {
@@ -251,29 +520,32 @@ void Application::render() {
             break;
     }
     
-    m_window.clear(bgColor);
+    m_window->clear(bgColor);
     
     // 使用 ECS 渲染系统渲染所有实体
-    m_renderingSystem.render(m_window, m_registry);
+    m_renderingSystem.render(*m_window, m_registry, alpha);
+    
+    // 渲染视觉效果(攻击线条、伤害数字、粒子)
+    m_visualEffectsSystem.render(*m_window, m_registry);
     
-    // 渲染视觉效果(子弹、伤害数字、粒子)
-    m_visualEffectsSystem.render(m_window, m_registry);
+    // 渲染子弹
+    m_projectileSystem.render(*m_window, m_renderingSystem.getCameraPosition());
     
     // 渲染建筑预览
-    m_buildingSystem.renderPreview(m_window);
+    m_buildingSystem.renderPreview(*m_window);
     
     // 渲染 HUD
-    m_hud.render(m_window);
+    m_hud.render(*m_window);
     
     // 显示画面
-    m_window.display();
+    m_window->display();
 }
 
 void Application::initEntities() {
     NF_INFO("初始化游戏实体...");
     
     // 创建玩家
-    sf::Vector2u windowSize = m_window.getSize();
+    sf::Vector2u windowSize = m_windowSize;
     m_player = m_registry.createPlayer(sf::Vector2f(windowSize.x / 2.f, windowSize.y / 2.f));
     
     NF_INFO("玩家实体创建完成: {}", static_cast<uint32_t>(m_player));
@@ -348,28 +620,13 @@ void Application::harvestNearbyResources() {
     }
     
     const float harvestRange = 80.f;  // 采集范围
-    entt::entity closestNode = entt::null;
-    float closestDistSq = harvestRange * harvestRange;
-    
-    // 查找最近的可采集资源节点
-    auto view = m_registry.view<Transform, ResourceNode>();
-    for (auto entity : view) {
-        const auto& nodeTransform = view.get<Transform>(entity);
-        const auto& node = view.get<ResourceNode>(entity);
-        
-        // 跳过耗尽的资源
-        if (node.isDepleted || node.resourceAmount <= 0) continue;
-        
-        // 计算距离
-        float dx = nodeTransform.position.x - playerTransform->position.x;
-        float dy = nodeTransform.position.y - playerTransform->position.y;
-        float distSq = dx * dx + dy * dy;
-        
-        if (distSq < closestDistSq) {
-            closestDistSq = distSq;
-            closestNode = entity;
-        }
-    }
+    
+    // 查找最近的可采集资源节点（跳过耗尽的资源）
+    entt::entity closestNode = m_spatialQuery.nearest(SpatialCategory::ResourceNode, playerTransform->position, harvestRange,
+        [&](entt::entity entity) {
+            const auto& node = m_registry.getComponent<ResourceNode>(entity);
+            return !node.isDepleted && node.resourceAmount > 0;
+        });
     
     if (closestNode != entt::null) {
         startHarvesting(closestNode);
@@ -2,17 +2,27 @@
 #include <SFML/Graphics.hpp>
 #include <memory>
 #include <string>
+#include "JobSystem.h"
 #include "../ecs/Registry.h"
+#include "../ecs/Systems.h"
 #include "../systems/RenderingSystem.h"
 #include "../systems/MovementSystem.h"
+#include "../systems/SurvivalSystem.h"
 #include "../systems/PhysicsSystem.h"
 #include "../systems/AISystem.h"
 #include "../systems/WaveSystem.h"
 #include "../systems/CombatSystem.h"
 #include "../systems/BuildingSystem.h"
 #include "../systems/TurretSystem.h"
+#include "../systems/ProjectileSystem.h"
+#include "../systems/CrowdSystem.h"
+#include "../systems/FormationSystem.h"
+#include "../ai/Pathfinding.h"
+#include "../ai/PathService.h"
+#include "../ai/NPCController.h"
 #include "../systems/VisualEffectsSystem.h"
 #include "../systems/ResourceSystem.h"
+#include "../systems/SpatialQuery.h"
 #include "../ui/HUD.h"
 
 namespace Nightfall {
@@ -49,9 +59,15 @@ public:
     void run();
 
     /**
-     * @brief 获取窗口引用
+     * @brief 无渲染运行：尽快推进指定数量的逻辑帧
+     * @param tickCount 逻辑帧数
      */
-    sf::RenderWindow& getWindow() { return m_window; }
+    void runHeadless(int tickCount);
+
+    /**
+     * @brief 获取窗口引用（run() 创建窗口之后才有效）
+     */
+    sf::RenderWindow& getWindow() { return *m_window; }
 
     /**
      * @brief 获取 ECS 注册表
@@ -59,21 +75,43 @@ public:
     Registry& getRegistry() { return m_registry; }
 
 private:
+    /**
+     * @brief 创建窗口并加载纹理、字体（无渲染模式不调用，不需要显示设备）
+     */
+    void initGraphics();
+
     /**
      * @brief 处理输入事件
      */
     void processEvents();
 
     /**
-     * @brief 更新游戏逻辑
-     * @param deltaTime 帧间隔时间（秒）
+     * @brief 推进一个固定逻辑帧
+     * @param deltaTime 固定步长（秒）
+     */
+    void fixedUpdate(float deltaTime);
+
+    /**
+     * @brief 向调度器注册逻辑帧的系统及其组件访问
      */
-    void update(float deltaTime);
+    void registerSystems();
+
+    /**
+     * @brief 以 debug 级别输出调度器、AI LOD、行为树、寻路服务、任务板和实体池的统计
+     */
+    void logStats() const;
+
+    /**
+     * @brief 每个渲染帧的更新（建筑预览、HUD）
+     * @param frameTime 渲染帧间隔时间（秒）
+     */
+    void frameUpdate(float frameTime);
 
     /**
      * @brief 渲染画面
+     * @param alpha 插值系数（累积器剩余时间 / 固定步长）
      */
-    void render();
+    void render(float alpha);
 
     /**
      * @brief 初始化游戏实体
@@ -101,22 +139,43 @@ private:
     void cancelHarvesting();
 
 private:
-    sf::RenderWindow m_window;      // 游戏窗口
+    std::unique_ptr<sf::RenderWindow> m_window;  // 游戏窗口（run() 中创建）
+    std::string m_title;            // 窗口标题
+    sf::Vector2u m_windowSize;      // 窗口大小（同时是世界大小）
     sf::Clock m_clock;              // 用于计算 deltaTime
     bool m_isRunning;               // 游戏是否运行中
     
+    // 固定步长模拟
+    float m_fixedDeltaTime{1.f / 60.f};  // 逻辑帧步长（秒）
+    int m_maxSubsteps{5};                // 单帧最多追赶的逻辑帧数
+    float m_accumulator{0.f};            // 尚未模拟的真实时间
+    float m_statsLogInterval{5.f};       // 统计输出间隔（逻辑时间，秒；0 表示不输出）
+    float m_statsLogTimer{0.f};
+    
+    // 任务系统放在 ECS 之前：最后析构，其余成员析构时不会再有任务在执行
+    JobSystem m_jobSystem;
+    
     // ECS 系统
     Registry m_registry;
+    SpatialQuery m_spatialQuery;
     RenderingSystem m_renderingSystem;
     MovementSystem m_movementSystem;
+    SurvivalSystem m_survivalSystem;
     PhysicsSystem m_physicsSystem;
     CombatSystem m_combatSystem;
     AISystem m_aiSystem;
+    CrowdSystem m_crowdSystem;
+    FormationSystem m_formationSystem;
+    Pathfinder m_pathfinder;
+    PathService m_pathService;
+    NPCController m_npcController;
     WaveSystem m_waveSystem;
     BuildingSystem m_buildingSystem;
     TurretSystem m_turretSystem;
+    ProjectileSystem m_projectileSystem;
     VisualEffectsSystem m_visualEffectsSystem;
     ResourceSystem m_resourceSystem;
+    SystemScheduler m_scheduler;
     
     // UI 系统
     HUD m_hud;
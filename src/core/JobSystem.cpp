@@ -0,0 +1,184 @@
+﻿#include "JobSystem.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace Nightfall {
+
+namespace {
+
+// 当前线程所属的任务系统和队列编号（非工作线程为 nullptr / 0）
+thread_local const JobSystem* t_owner = nullptr;
+thread_local size_t t_queueIndex = 0;
+
+constexpr int kSpinsBeforeYield = 64;
+
+} // namespace
+
+JobSystem::JobSystem() {
+    m_queues.push_back(std::make_unique<WorkQueue>());
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+}
+
+void JobSystem::init(int workerCount) {
+    shutdown();
+
+    m_queues.clear();
+    for (int i = 0; i <= std::max(0, workerCount); ++i) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    m_running = true;
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, static_cast<size_t>(i + 1));
+    }
+
+    NF_CORE_INFO("Job system initialized ({} worker threads)", m_workers.size());
+}
+
+void JobSystem::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running = false;
+    }
+    m_wakeCondition.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    // 工作线程队列里剩下的任务移到主线程队列，不会丢失
+    for (size_t i = 1; i < m_queues.size(); ++i) {
+        Job job;
+        while (pop(i, job)) {
+            push(0, job);
+        }
+    }
+}
+
+size_t JobSystem::getThreadIndex() const {
+    return t_owner == this ? t_queueIndex : 0;
+}
+
+void JobSystem::submit(const Job& job) {
+    push(getThreadIndex(), job);
+    wake(1);
+}
+
+void JobSystem::wait(const std::atomic<int>& counter) {
+    const size_t queue = getThreadIndex();
+    int spins = 0;
+
+    while (counter.load(std::memory_order_acquire) > 0) {
+        if (tryExecute(queue)) {
+            spins = 0;
+            continue;
+        }
+
+        // 剩下的任务正在其他线程上执行
+        if (++spins < kSpinsBeforeYield) continue;
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::dispatchRanges(JobFunction function, void* context, size_t count, size_t rangeSize) {
+    const size_t queue = getThreadIndex();
+    std::atomic<int> counter{0};
+
+    size_t jobCount = 0;
+    for (size_t begin = rangeSize; begin < count; begin += rangeSize) {
+        ++jobCount;
+    }
+    counter.store(static_cast<int>(jobCount), std::memory_order_relaxed);
+
+    // 倒序入队：自己从尾部先取到的是紧接第一个区间的内存
+    for (size_t begin = rangeSize * jobCount; begin > 0; begin -= rangeSize) {
+        push(queue, Job{function, context, begin, std::min(count, begin + rangeSize), &counter});
+    }
+    wake(jobCount);
+
+    function(context, 0, std::min(count, rangeSize));
+    wait(counter);
+}
+
+void JobSystem::push(size_t queue, const Job& job) {
+    WorkQueue& target = *m_queues[queue];
+    {
+        std::lock_guard<std::mutex> lock(target.mutex);
+        target.jobs.push_back(job);
+    }
+    m_queuedJobs.fetch_add(1, std::memory_order_release);
+}
+
+bool JobSystem::pop(size_t queue, Job& job) {
+    WorkQueue& source = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(source.mutex);
+    if (source.jobs.empty()) return false;
+
+    job = source.jobs.back();
+    source.jobs.pop_back();
+    m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::steal(size_t thief, Job& job) {
+    const size_t queueCount = m_queues.size();
+    for (size_t offset = 1; offset < queueCount; ++offset) {
+        WorkQueue& victim = *m_queues[(thief + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.jobs.empty()) continue;
+
+        job = victim.jobs.front();
+        victim.jobs.pop_front();
+        m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::tryExecute(size_t queue) {
+    if (m_queuedJobs.load(std::memory_order_acquire) == 0) return false;
+
+    Job job;
+    if (!pop(queue, job) && !steal(queue, job)) return false;
+    execute(job);
+    return true;
+}
+
+void JobSystem::execute(const Job& job) {
+    job.function(job.context, job.begin, job.end);
+    if (job.counter) {
+        job.counter->fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void JobSystem::wake(size_t jobCount) {
+    if (m_workers.empty() || jobCount == 0) return;
+
+    // 先经过互斥锁，避免工作线程检查完条件、尚未休眠时错过通知
+    { std::lock_guard<std::mutex> lock(m_wakeMutex); }
+    if (jobCount == 1) {
+        m_wakeCondition.notify_one();
+    } else {
+        m_wakeCondition.notify_all();
+    }
+}
+
+void JobSystem::workerLoop(size_t index) {
+    t_owner = this;
+    t_queueIndex = index;
+
+    while (true) {
+        if (tryExecute(index)) continue;
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.wait(lock, [this] {
+            return !m_running || m_queuedJobs.load(std::memory_order_acquire) > 0;
+        });
+        if (!m_running) break;
+    }
+}
+
+} // namespace Nightfall
@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Nightfall {
+
+/// 任务函数：处理 [begin, end) 区间（单个任务时 begin 为任意参数，end 不使用）
+using JobFunction = void (*)(void* context, size_t begin, size_t end);
+
+/// 一个任务（不分配内存，上下文由提交方保证在任务完成前有效）
+struct Job {
+    JobFunction function{nullptr};
+    void* context{nullptr};
+    size_t begin{0};
+    size_t end{0};
+    std::atomic<int>* counter{nullptr};   // 完成后减 1（可为空）
+};
+
+/**
+ * @brief 任务系统 - 每个线程一个任务双端队列，空闲线程从其他队列窃取任务
+ *
+ * - 线程向自己的队列尾部压入、从尾部取出（后进先出，数据还在缓存里）；
+ *   窃取者从其他队列头部取（先进先出，拿走最大块的剩余工作）
+ * - wait() 等待计数器归零期间，调用线程（包括主线程）会执行队列里的任务，而不是空等
+ * - 任务里可以再提交任务并等待（嵌套的 parallelFor），等待的线程同样会帮忙执行
+ * - 工作线程数为 0 时所有任务都在调用 wait 的线程上执行，结果与多线程一致
+ *
+ * 队列 0 属于主线程（以及其他非工作线程），1..N 属于工作线程。
+ * 任务必须只访问互不重叠的数据，或由调用方自己保证同步。
+ */
+class JobSystem {
+public:
+    JobSystem();
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /// 启动 workerCount 个工作线程
+    void init(int workerCount);
+
+    /// 停止工作线程（队列中剩余的任务由之后的 wait 在调用线程上执行）
+    void shutdown();
+
+    /// 参与执行的线程数（工作线程 + 调用线程）
+    size_t getThreadCount() const { return m_workers.size() + 1; }
+    size_t getWorkerCount() const { return m_workers.size(); }
+
+    /// 当前线程的队列编号（工作线程为 1..N，其他线程为 0）
+    size_t getThreadIndex() const;
+
+    /// 提交任务（调用方事先把 job.counter 加 1）
+    void submit(const Job& job);
+
+    /// 等待计数器归零，期间执行队列中的任务
+    void wait(const std::atomic<int>& counter);
+
+    /**
+     * @brief 把 [0, count) 切成若干区间并发执行 func(begin, end)，返回时全部完成
+     * @param grain 区间长度总是 grain 的整数倍（最后一个区间除外），也是最小区间
+     */
+    template<typename Func>
+    void parallelFor(size_t count, size_t grain, Func&& func) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+
+        // 每个线程约 4 个区间，方便负载不均时窃取
+        const size_t targetRanges = getThreadCount() * 4;
+        size_t rangeSize = (count + targetRanges - 1) / targetRanges;
+        rangeSize = std::max(grain, (rangeSize + grain - 1) / grain * grain);
+
+        if (m_workers.empty() || rangeSize >= count) {
+            func(size_t{0}, count);
+            return;
+        }
+
+        using Callable = std::remove_reference_t<Func>;
+        dispatchRanges([](void* context, size_t begin, size_t end) {
+            (*static_cast<Callable*>(context))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(&func)), count, rangeSize);
+    }
+
+private:
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    /// 第一个区间在调用线程上执行，其余入队后等待
+    void dispatchRanges(JobFunction function, void* context, size_t count, size_t rangeSize);
+
+    void push(size_t queue, const Job& job);
+    bool pop(size_t queue, Job& job);
+    bool steal(size_t thief, Job& job);
+    bool tryExecute(size_t queue);
+    void execute(const Job& job);
+    void wake(size_t jobCount);
+
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<size_t> m_queuedJobs{0};
+    std::mutex m_wakeMutex;                // 只用于空闲时休眠
+    std::condition_variable m_wakeCondition;
+    bool m_running{false};
+};
+
+} // namespace Nightfall
@@ -0,0 +1,423 @@
+﻿#include "Archetype.h"
+#include "../core/Logger.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <optional>
+
+namespace Nightfall {
+
+// ========== Archetype ==========
+
+void Archetype::spawn(entt::registry& registry, const sf::Vector2f* positions, size_t count, entt::entity* out) const {
+    if (count == 0) return;
+
+    std::vector<entt::entity> entities(count);
+    registry.create(entities.begin(), entities.end());
+
+    // Transform 是唯一逐个不同的组件
+    std::vector<Transform> transforms(positions, positions + count);
+    auto& transformStorage = registry.storage<Transform>();
+    transformStorage.reserve(transformStorage.size() + count);
+    registry.insert<Transform>(entities.data(), entities.data() + count, transforms.begin());
+
+    for (const auto& [type, component] : m_components) {
+        component->insert(registry, entities.data(), entities.data() + count);
+    }
+
+    if (out) {
+        std::copy(entities.begin(), entities.end(), out);
+    }
+}
+
+void Archetype::reset(entt::registry& registry, const entt::entity* entities, const sf::Vector2f* positions, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+        registry.emplace_or_replace<Transform>(entities[i], positions[i]);
+    }
+
+    for (const auto& [type, component] : m_components) {
+        component->assign(registry, entities, entities + count);
+    }
+}
+
+std::vector<entt::id_type> Archetype::getComponentTypes() const {
+    std::vector<entt::id_type> types;
+    types.reserve(m_components.size());
+    for (const auto& [type, component] : m_components) {
+        types.push_back(type);
+    }
+    return types;
+}
+
+// ========== 蓝图 ==========
+
+namespace {
+
+constexpr const char* kZombieTypeNames[] = {"normal", "fast", "tank", "exploder", "boss"};
+constexpr const char* kBuildingTypeNames[] = {"wall", "turret", "gate", "generator", "storage", "workshop", "farm", "house"};
+constexpr const char* kInteractableTypeNames[] = {"item", "door", "container", "workbench", "npc", "vehicle"};
+
+template<typename Enum, size_t N>
+bool parseEnum(const std::string& text, const char* const (&names)[N], Enum& result) {
+    for (size_t i = 0; i < N; ++i) {
+        if (text == names[i]) {
+            result = static_cast<Enum>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+sf::Vector2f readSize(const nlohmann::json& entry, const sf::Vector2f& fallback) {
+    if (!entry.contains("size") || !entry["size"].is_array() || entry["size"].size() != 2) return fallback;
+    return sf::Vector2f(entry["size"][0].get<float>(), entry["size"][1].get<float>());
+}
+
+bool readJson(const std::string& path, nlohmann::json& data) {
+    std::ifstream file(path);
+    if (!file) {
+        NF_WARN("Archetype file not found: {}", path);
+        return false;
+    }
+
+    try {
+        file >> data;
+        return true;
+    } catch (const std::exception& e) {
+        NF_ERROR("Failed to parse archetypes ({}): {}", path, e.what());
+        return false;
+    }
+}
+
+/// 敌人蓝图
+struct EnemyBlueprint {
+    std::string name;
+    ZombieType type{ZombieType::Normal};
+    std::string sprite;
+    int zOrder{5};
+    sf::Vector2f size{32.f, 32.f};
+    float speed{50.f};
+    float health{50.f};
+    float damage{10.f};
+    float attackSpeed{1.f};
+    float attackRange{40.f};
+    float detectionRange{200.f};
+};
+
+EnemyBlueprint defaultEnemy(ZombieType type) {
+    EnemyBlueprint blueprint;
+    blueprint.type = type;
+    blueprint.name = std::string("zombie_") + kZombieTypeNames[static_cast<size_t>(type)];
+    blueprint.sprite = blueprint.name;
+
+    switch (type) {
+        case ZombieType::Fast:
+            blueprint.speed = 150.f;
+            blueprint.health = 30.f;
+            blueprint.damage = 8.f;
+            break;
+
+        case ZombieType::Tank:
+            blueprint.speed = 30.f;
+            blueprint.health = 200.f;
+            blueprint.damage = 20.f;
+            break;
+
+        case ZombieType::Exploder:
+            blueprint.speed = 60.f;
+            blueprint.health = 40.f;
+            blueprint.damage = 50.f;  // 爆炸伤害
+            break;
+
+        case ZombieType::Boss:
+            blueprint.speed = 40.f;
+            blueprint.health = 500.f;
+            blueprint.damage = 30.f;
+            blueprint.detectionRange = 400.f;
+            blueprint.zOrder = 6;
+            break;
+
+        case ZombieType::Normal:
+        default:
+            break;
+    }
+    return blueprint;
+}
+
+Archetype compileEnemy(const EnemyBlueprint& blueprint) {
+    Archetype archetype(blueprint.name);
+
+    Collider collider(blueprint.size.x, blueprint.size.y);
+    collider.layer = CollisionLayer::Hostile;
+
+    Combat combat;
+    combat.attackDamage = blueprint.damage;
+    combat.attackSpeed = blueprint.attackSpeed;
+    combat.attackRange = blueprint.attackRange;
+
+    AI ai;
+    ai.detectionRange = blueprint.detectionRange;
+    ai.attackRange = blueprint.attackRange;
+    ai.state = AIState::Patrol;
+    ai.stateTimer = 0.f;
+    ai.attackCooldown = 0.f;
+    ai.moveSpeed = blueprint.speed;
+
+    Zombie zombie;
+    zombie.type = blueprint.type;
+
+    archetype.with(Sprite(blueprint.sprite, blueprint.zOrder))
+             .with(collider)
+             .with(Velocity(0.f, 0.f, blueprint.speed))
+             .with(Health(blueprint.health))
+             .with(combat)
+             .with(ai)
+             .with(zombie)
+             .with<Hostile>()
+             .with<Destructible>();
+    return archetype;
+}
+
+/// 建筑蓝图
+struct BuildingBlueprint {
+    std::string name;
+    Building::Type type{Building::Type::Wall};
+    std::string sprite;
+    int zOrder{3};
+    sf::Vector2f size{64.f, 64.f};
+    float durability{100.f};
+    std::optional<Turret> turret;
+    float attackRange{300.f};                    // 炮塔的 Combat 攻击范围
+    std::optional<Producer> producer;
+    int inventorySlots{0};                       // 0 表示没有库存
+    std::optional<Interactable::Type> interactable;
+};
+
+BuildingBlueprint defaultBuilding(Building::Type type) {
+    BuildingBlueprint blueprint;
+    blueprint.type = type;
+    blueprint.name = std::string("building_") + kBuildingTypeNames[static_cast<size_t>(type)];
+    blueprint.sprite = "building_" + std::to_string(static_cast<int>(type));
+
+    switch (type) {
+        case Building::Type::Wall:
+            blueprint.durability = 200.f;
+            break;
+
+        case Building::Type::Turret:
+            blueprint.turret = Turret{};
+            break;
+
+        case Building::Type::Generator:
+            blueprint.durability = 150.f;
+            blueprint.producer = Producer{};
+            blueprint.producer->resourceType = "electricity";
+            blueprint.producer->refillCycles = 6;  // 每补一次料发电6次
+            break;
+
+        case Building::Type::Farm:
+            blueprint.durability = 80.f;
+            blueprint.producer = Producer{};
+            blueprint.producer->resourceType = "food";
+            blueprint.producer->productionAmount = 2;
+            blueprint.producer->productionInterval = 10.f;  // 每10秒生产2个食物
+            break;
+
+        case Building::Type::Storage:
+            blueprint.durability = 120.f;
+            blueprint.inventorySlots = 50;
+            blueprint.interactable = Interactable::Type::Container;
+            break;
+
+        case Building::Type::Workshop:
+            blueprint.producer = Producer{};
+            blueprint.producer->resourceType = "metal";
+            blueprint.producer->productionAmount = 1;
+            blueprint.producer->productionInterval = 15.f;  // 每15秒生产1个金属
+            blueprint.producer->refillCycles = 4;
+            blueprint.interactable = Interactable::Type::Workbench;
+            break;
+
+        default:
+            break;
+    }
+    return blueprint;
+}
+
+Archetype compileBuilding(const BuildingBlueprint& blueprint) {
+    Archetype archetype(blueprint.name);
+
+    Collider collider(blueprint.size.x, blueprint.size.y);
+    collider.layer = CollisionLayer::Building;
+
+    Building building;
+    building.type = blueprint.type;
+    building.isComplete = false;
+    building.constructionProgress = 0.f;
+    building.maxDurability = blueprint.durability;
+    building.durability = blueprint.durability;
+
+    archetype.with(Sprite(blueprint.sprite, blueprint.zOrder))
+             .with(collider)
+             .with(building);
+
+    if (blueprint.turret) {
+        Combat combat;
+        combat.attackRange = blueprint.attackRange;
+        archetype.with(*blueprint.turret).with(combat);
+    }
+    if (blueprint.producer) {
+        archetype.with(*blueprint.producer);
+    }
+    if (blueprint.inventorySlots > 0) {
+        Inventory inventory;
+        inventory.maxSlots = blueprint.inventorySlots;
+        archetype.with(inventory);
+    }
+    if (blueprint.interactable) {
+        Interactable interactable;
+        interactable.type = *blueprint.interactable;
+        archetype.with(interactable);
+    }
+
+    archetype.with<Static>().with<Destructible>();
+    return archetype;
+}
+
+} // namespace
+
+// ========== ArchetypeLibrary ==========
+
+ArchetypeLibrary::ArchetypeLibrary() {
+    for (size_t i = 0; i < m_zombies.size(); ++i) {
+        m_zombies[i] = store(compileEnemy(defaultEnemy(static_cast<ZombieType>(i))));
+    }
+    for (size_t i = 0; i < m_buildings.size(); ++i) {
+        m_buildings[i] = store(compileBuilding(defaultBuilding(static_cast<Building::Type>(i))));
+    }
+}
+
+const Archetype* ArchetypeLibrary::store(Archetype archetype) {
+    std::string name = archetype.getName();
+    auto it = m_archetypes.find(name);
+    if (it != m_archetypes.end()) {
+        it->second = std::move(archetype);
+        return &it->second;
+    }
+    return &m_archetypes.emplace(std::move(name), std::move(archetype)).first->second;
+}
+
+const Archetype* ArchetypeLibrary::find(const std::string& name) const {
+    auto it = m_archetypes.find(name);
+    return it != m_archetypes.end() ? &it->second : nullptr;
+}
+
+bool ArchetypeLibrary::loadEnemies(const std::string& path) {
+    nlohmann::json data;
+    if (!readJson(path, data)) return false;
+
+    bool ok = true;
+    int count = 0;
+    for (const auto& entry : data.value("enemies", nlohmann::json::array())) {
+        ZombieType type = ZombieType::Normal;
+        const std::string typeName = entry.value("type", "normal");
+        if (!parseEnum(typeName, kZombieTypeNames, type)) {
+            NF_WARN("Unknown enemy type '{}' in {}", typeName, path);
+            ok = false;
+            continue;
+        }
+
+        try {
+            EnemyBlueprint blueprint = defaultEnemy(type);
+            blueprint.name = entry.value("id", blueprint.name);
+            blueprint.sprite = entry.value("sprite", blueprint.sprite);
+            blueprint.zOrder = entry.value("z_order", blueprint.zOrder);
+            blueprint.size = readSize(entry, blueprint.size);
+            blueprint.speed = entry.value("speed", blueprint.speed);
+            blueprint.health = entry.value("health", blueprint.health);
+            blueprint.damage = entry.value("damage", blueprint.damage);
+            blueprint.attackSpeed = entry.value("attack_speed", blueprint.attackSpeed);
+            blueprint.attackRange = entry.value("attack_range", blueprint.attackRange);
+            blueprint.detectionRange = entry.value("detection_range", blueprint.detectionRange);
+
+            store(compileEnemy(blueprint));
+            ++count;
+        } catch (const std::exception& e) {
+            NF_ERROR("Invalid enemy archetype in {}: {}", path, e.what());
+            ok = false;
+        }
+    }
+
+    NF_INFO("Loaded {} enemy archetypes from {}", count, path);
+    return ok;
+}
+
+bool ArchetypeLibrary::loadBuildings(const std::string& path) {
+    nlohmann::json data;
+    if (!readJson(path, data)) return false;
+
+    bool ok = true;
+    int count = 0;
+    for (const auto& entry : data.value("buildings", nlohmann::json::array())) {
+        Building::Type type = Building::Type::Wall;
+        const std::string typeName = entry.value("type", "wall");
+        if (!parseEnum(typeName, kBuildingTypeNames, type)) {
+            NF_WARN("Unknown building type '{}' in {}", typeName, path);
+            ok = false;
+            continue;
+        }
+
+        try {
+            BuildingBlueprint blueprint = defaultBuilding(type);
+            blueprint.name = entry.value("id", blueprint.name);
+            blueprint.sprite = entry.value("sprite", blueprint.sprite);
+            blueprint.zOrder = entry.value("z_order", blueprint.zOrder);
+            blueprint.size = readSize(entry, blueprint.size);
+            blueprint.durability = entry.value("durability", blueprint.durability);
+
+            if (entry.contains("turret")) {
+                const auto& turret = entry["turret"];
+                if (!blueprint.turret) blueprint.turret = Turret{};
+                blueprint.turret->range = turret.value("range", blueprint.turret->range);
+                blueprint.turret->damage = turret.value("damage", blueprint.turret->damage);
+                blueprint.turret->attackSpeed = turret.value("attack_speed", blueprint.turret->attackSpeed);
+                blueprint.turret->projectileSpeed = turret.value("projectile_speed", blueprint.turret->projectileSpeed);
+                blueprint.turret->rotationSpeed = turret.value("rotation_speed", blueprint.turret->rotationSpeed);
+                blueprint.attackRange = turret.value("attack_range", blueprint.attackRange);
+            }
+
+            if (entry.contains("producer")) {
+                const auto& producer = entry["producer"];
+                if (!blueprint.producer) blueprint.producer = Producer{};
+                blueprint.producer->resourceType = producer.value("resource", blueprint.producer->resourceType);
+                blueprint.producer->productionAmount = producer.value("amount", blueprint.producer->productionAmount);
+                blueprint.producer->productionInterval = producer.value("interval", blueprint.producer->productionInterval);
+                blueprint.producer->refillCycles = producer.value("refill_cycles", blueprint.producer->refillCycles);
+            }
+
+            blueprint.inventorySlots = entry.value("inventory_slots", blueprint.inventorySlots);
+
+            if (entry.contains("interactable")) {
+                Interactable::Type interactable = Interactable::Type::Item;
+                const std::string interactableName = entry["interactable"].get<std::string>();
+                if (parseEnum(interactableName, kInteractableTypeNames, interactable)) {
+                    blueprint.interactable = interactable;
+                } else {
+                    NF_WARN("Unknown interactable type '{}' in {}", interactableName, path);
+                    ok = false;
+                }
+            }
+
+            store(compileBuilding(blueprint));
+            ++count;
+        } catch (const std::exception& e) {
+            NF_ERROR("Invalid building archetype in {}: {}", path, e.what());
+            ok = false;
+        }
+    }
+
+    NF_INFO("Loaded {} building archetypes from {}", count, path);
+    return ok;
+}
+
+} // namespace Nightfall
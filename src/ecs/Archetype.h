@@ -0,0 +1,157 @@
+﻿#pragma once
+
+#include <entt/entt.hpp>
+#include "Components.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Nightfall {
+
+/**
+ * @brief 实体原型 - 一组预先构造好的组件模板，按位置批量生成实体
+ *
+ * 除 Transform 外的组件都是定值，生成 N 个实体时每种组件只预留一次存储，
+ * 再用 EnTT 的区间插入一次写入 N 份；Transform 按传入的位置逐个构造后同样区间插入。
+ * 原型由 ArchetypeLibrary 从 JSON 蓝图编译而来，也可以在代码里用 with<T>() 拼装。
+ */
+class Archetype {
+public:
+    Archetype() = default;
+    explicit Archetype(std::string name) : m_name(std::move(name)) {}
+
+    Archetype(Archetype&&) = default;
+    Archetype& operator=(Archetype&&) = default;
+
+    const std::string& getName() const { return m_name; }
+
+    /// 添加组件模板（已有同类组件时替换）
+    template<typename Component>
+    Archetype& with(Component component = {}) {
+        static_assert(!std::is_same_v<Component, Transform>, "Transform 由生成位置决定");
+
+        auto typed = std::make_unique<TypedTemplate<Component>>(std::move(component));
+        const entt::id_type id = entt::type_hash<Component>::value();
+        for (auto& [type, entry] : m_components) {
+            if (type == id) {
+                entry = std::move(typed);
+                return *this;
+            }
+        }
+        m_components.emplace_back(id, std::move(typed));
+        return *this;
+    }
+
+    /// 查找组件模板（没有时返回 nullptr）
+    template<typename Component>
+    Component* find() {
+        const entt::id_type id = entt::type_hash<Component>::value();
+        for (auto& [type, entry] : m_components) {
+            if (type == id) return &static_cast<TypedTemplate<Component>&>(*entry).value;
+        }
+        return nullptr;
+    }
+
+    template<typename Component>
+    const Component* find() const {
+        return const_cast<Archetype*>(this)->find<Component>();
+    }
+
+    /**
+     * @brief 在 positions[0..count) 处生成 count 个实体
+     * @param out 可选，写入生成的实体（长度至少为 count）
+     */
+    void spawn(entt::registry& registry, const sf::Vector2f* positions, size_t count, entt::entity* out = nullptr) const;
+
+    /// 把已有实体的原型组件恢复为模板值、Transform 移到 positions（对象池复用实体时调用）
+    void reset(entt::registry& registry, const entt::entity* entities, const sf::Vector2f* positions, size_t count) const;
+
+    /// 原型包含的组件类型（不含 Transform）
+    std::vector<entt::id_type> getComponentTypes() const;
+
+private:
+    /// 单个组件类型的模板（类型擦除）
+    struct ComponentTemplate {
+        virtual ~ComponentTemplate() = default;
+        virtual void insert(entt::registry& registry, const entt::entity* first, const entt::entity* last) const = 0;
+        virtual void assign(entt::registry& registry, const entt::entity* first, const entt::entity* last) const = 0;
+    };
+
+    template<typename Component>
+    struct TypedTemplate : ComponentTemplate {
+        Component value;
+
+        explicit TypedTemplate(Component component) : value(std::move(component)) {}
+
+        void insert(entt::registry& registry, const entt::entity* first, const entt::entity* last) const override {
+            auto& storage = registry.storage<Component>();
+            storage.reserve(storage.size() + static_cast<size_t>(last - first));
+            if constexpr (std::is_empty_v<Component>) {
+                registry.insert<Component>(first, last);
+            } else {
+                registry.insert<Component>(first, last, value);
+            }
+        }
+
+        void assign(entt::registry& registry, const entt::entity* first, const entt::entity* last) const override {
+            for (; first != last; ++first) {
+                if constexpr (std::is_empty_v<Component>) {
+                    if (!registry.all_of<Component>(*first)) {
+                        registry.emplace<Component>(*first);
+                    }
+                } else {
+                    registry.emplace_or_replace<Component>(*first, value);
+                }
+            }
+        }
+    };
+
+    std::string m_name;
+    std::vector<std::pair<entt::id_type, std::unique_ptr<ComponentTemplate>>> m_components;
+};
+
+/**
+ * @brief 原型库 - 把敌人、建筑蓝图编译成原型
+ *
+ * 内置默认蓝图与原先硬编码的属性一致；JSON 文件中出现的字段覆盖默认值，
+ * 也可以新增名字不同的原型（例如 "type": "fast" 的 "zombie_runner"）。
+ * 原型名：zombie_normal / zombie_fast / ...，building_wall / building_turret / ...
+ */
+class ArchetypeLibrary {
+public:
+    ArchetypeLibrary();
+
+    ArchetypeLibrary(const ArchetypeLibrary&) = delete;
+    ArchetypeLibrary& operator=(const ArchetypeLibrary&) = delete;
+
+    /// 载入 enemies.json（{"enemies": [...]}）
+    bool loadEnemies(const std::string& path);
+
+    /// 载入 buildings.json（{"buildings": [...]}）
+    bool loadBuildings(const std::string& path);
+
+    /// 按名字查找原型（没有时返回 nullptr）
+    const Archetype* find(const std::string& name) const;
+
+    const Archetype& getZombie(ZombieType type) const {
+        return *m_zombies[static_cast<size_t>(type)];
+    }
+
+    const Archetype& getBuilding(Building::Type type) const {
+        return *m_buildings[static_cast<size_t>(type)];
+    }
+
+private:
+    /// 添加或替换原型（替换时原型地址不变）
+    const Archetype* store(Archetype archetype);
+
+    std::unordered_map<std::string, Archetype> m_archetypes;
+    std::array<const Archetype*, static_cast<size_t>(ZombieType::Boss) + 1> m_zombies{};
+    std::array<const Archetype*, static_cast<size_t>(Building::Type::House) + 1> m_buildings{};
+};
+
+} // namespace Nightfall
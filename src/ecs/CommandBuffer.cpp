@@ -0,0 +1,87 @@
+﻿#include "CommandBuffer.h"
+#include <algorithm>
+
+namespace Nightfall {
+
+bool CommandBuffer::empty() const {
+    if (m_createCount > 0 || !m_destroys.empty() || !m_recycles.empty()) return false;
+
+    return std::all_of(m_components.begin(), m_components.end(), [](const auto& entry) {
+        return entry.second->empty();
+    });
+}
+
+void CommandBuffer::clear() {
+    m_createCount = 0;
+    m_created.clear();
+    m_destroys.clear();
+    m_recycles.clear();
+    for (auto& [type, commands] : m_components) {
+        commands->clear();
+    }
+}
+
+void CommandBuffer::playback(entt::registry& registry, CommandBuffer* const* buffers, size_t count,
+                             std::vector<entt::entity>& recycled) {
+    // 1. 批量创建延迟实体
+    for (size_t i = 0; i < count; ++i) {
+        CommandBuffer& buffer = *buffers[i];
+        buffer.m_created.resize(buffer.m_createCount);
+        registry.create(buffer.m_created.begin(), buffer.m_created.end());
+    }
+
+    // 2. 按组件类型分组添加、移除
+    std::vector<entt::id_type> types;
+    for (size_t i = 0; i < count; ++i) {
+        for (const auto& [type, commands] : buffers[i]->m_components) {
+            if (!commands->empty()) types.push_back(type);
+        }
+    }
+    std::sort(types.begin(), types.end());
+    types.erase(std::unique(types.begin(), types.end()), types.end());
+
+    for (entt::id_type type : types) {
+        for (size_t i = 0; i < count; ++i) {
+            auto it = buffers[i]->m_components.find(type);
+            if (it != buffers[i]->m_components.end()) {
+                it->second->applyEmplaces(registry, buffers[i]->m_created);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            auto it = buffers[i]->m_components.find(type);
+            if (it != buffers[i]->m_components.end()) {
+                it->second->applyRemovals(registry);
+            }
+        }
+    }
+
+    // 3. 销毁实体（多个系统可能销毁同一个实体）
+    std::vector<entt::entity> destroys;
+    for (size_t i = 0; i < count; ++i) {
+        destroys.insert(destroys.end(), buffers[i]->m_destroys.begin(), buffers[i]->m_destroys.end());
+    }
+    std::sort(destroys.begin(), destroys.end());
+    destroys.erase(std::unique(destroys.begin(), destroys.end()), destroys.end());
+    for (entt::entity entity : destroys) {
+        if (registry.valid(entity)) {
+            registry.destroy(entity);
+        }
+    }
+
+    // 4. 回收的实体（同时被销毁的已经失效）
+    recycled.clear();
+    for (size_t i = 0; i < count; ++i) {
+        recycled.insert(recycled.end(), buffers[i]->m_recycles.begin(), buffers[i]->m_recycles.end());
+    }
+    std::sort(recycled.begin(), recycled.end());
+    recycled.erase(std::unique(recycled.begin(), recycled.end()), recycled.end());
+    recycled.erase(std::remove_if(recycled.begin(), recycled.end(), [&registry](entt::entity entity) {
+        return !registry.valid(entity);
+    }), recycled.end());
+
+    for (size_t i = 0; i < count; ++i) {
+        buffers[i]->clear();
+    }
+}
+
+} // namespace Nightfall
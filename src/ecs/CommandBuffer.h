@@ -0,0 +1,149 @@
+﻿#pragma once
+
+#include <entt/entt.hpp>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Nightfall {
+
+/// 命令缓冲里延迟创建的实体（回放时才分配真正的实体，只在记录它的缓冲内有效）
+struct DeferredEntity {
+    std::uint32_t index{0};
+};
+
+/**
+ * @brief 命令缓冲 - 记录结构性修改（创建 / 销毁实体、添加 / 移除组件），在同步点批量回放
+ *
+ * 系统在遍历视图时直接增删会使迭代失效，多个线程同时修改注册表也不安全。
+ * 非独占系统通过 Registry::commands() 取得当前线程自己的缓冲记录修改，记录时不加锁；
+ * 调度器在每个阶段结束后于主线程回放所有线程的缓冲：
+ * 1. 先批量创建延迟实体
+ * 2. 再按组件类型逐类添加、移除（同一存储的操作连在一起，访问局部性好）
+ * 3. 最后排序去重后销毁实体（已失效的实体跳过），回收的实体交给调用方放回对象池
+ *
+ * 同一次回放中，对同一组件先添加后移除；销毁和回收总是最后执行。
+ */
+class CommandBuffer {
+public:
+    CommandBuffer() = default;
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    /// 延迟创建实体
+    DeferredEntity create() {
+        return DeferredEntity{m_createCount++};
+    }
+
+    /// 延迟销毁实体
+    void destroy(entt::entity entity) {
+        m_destroys.push_back(entity);
+    }
+
+    /// 延迟回收实体（有对象池的原型停放复用，否则销毁，见 Registry::recycle）
+    void recycle(entt::entity entity) {
+        m_recycles.push_back(entity);
+    }
+
+    /// 延迟添加组件（已有同类组件时替换）
+    template<typename Component>
+    void emplace(entt::entity entity, Component component = {}) {
+        commandsFor<Component>().emplaces.emplace_back(Target{entity, kNoDeferred}, std::move(component));
+    }
+
+    template<typename Component>
+    void emplace(DeferredEntity entity, Component component = {}) {
+        commandsFor<Component>().emplaces.emplace_back(Target{entt::null, entity.index}, std::move(component));
+    }
+
+    /// 延迟移除组件（没有该组件时忽略）
+    template<typename Component>
+    void remove(entt::entity entity) {
+        commandsFor<Component>().removals.push_back(entity);
+    }
+
+    bool empty() const;
+
+    /**
+     * @brief 回放多个缓冲（只能在没有系统执行时于主线程调用），回放后清空
+     * @param recycled 输出：待回收的实体（排序去重，已销毁的不含在内），由调用方停放或销毁
+     */
+    static void playback(entt::registry& registry, CommandBuffer* const* buffers, size_t count,
+                         std::vector<entt::entity>& recycled);
+
+private:
+    static constexpr std::uint32_t kNoDeferred = 0xFFFFFFFFu;
+
+    struct Target {
+        entt::entity entity;
+        std::uint32_t deferred;
+    };
+
+    /// 单个组件类型的命令（类型擦除，回放时按类型分组执行）
+    struct ComponentCommands {
+        virtual ~ComponentCommands() = default;
+        virtual void applyEmplaces(entt::registry& registry, const std::vector<entt::entity>& created) = 0;
+        virtual void applyRemovals(entt::registry& registry) = 0;
+        virtual bool empty() const = 0;
+        virtual void clear() = 0;
+    };
+
+    template<typename Component>
+    struct TypedCommands : ComponentCommands {
+        std::vector<std::pair<Target, Component>> emplaces;
+        std::vector<entt::entity> removals;
+
+        void applyEmplaces(entt::registry& registry, const std::vector<entt::entity>& created) override {
+            for (auto& [target, component] : emplaces) {
+                const entt::entity entity = target.deferred == kNoDeferred ? target.entity : created[target.deferred];
+                if (!registry.valid(entity)) continue;
+
+                if constexpr (std::is_empty_v<Component>) {
+                    if (!registry.all_of<Component>(entity)) {
+                        registry.emplace<Component>(entity);
+                    }
+                } else {
+                    registry.emplace_or_replace<Component>(entity, std::move(component));
+                }
+            }
+        }
+
+        void applyRemovals(entt::registry& registry) override {
+            for (entt::entity entity : removals) {
+                if (registry.valid(entity)) {
+                    registry.remove<Component>(entity);
+                }
+            }
+        }
+
+        bool empty() const override { return emplaces.empty() && removals.empty(); }
+
+        void clear() override {
+            emplaces.clear();
+            removals.clear();
+        }
+    };
+
+    template<typename Component>
+    TypedCommands<Component>& commandsFor() {
+        auto& commands = m_components[entt::type_hash<Component>::value()];
+        if (!commands) {
+            commands = std::make_unique<TypedCommands<Component>>();
+        }
+        return static_cast<TypedCommands<Component>&>(*commands);
+    }
+
+    void clear();
+
+    std::uint32_t m_createCount{0};
+    std::vector<entt::entity> m_created;     // 回放时分配的实体（按 DeferredEntity 下标）
+    std::vector<entt::entity> m_destroys;
+    std::vector<entt::entity> m_recycles;
+    std::unordered_map<entt::id_type, std::unique_ptr<ComponentCommands>> m_components;
+};
+
+} // namespace Nightfall
@@ -3,6 +3,7 @@
 #include <SFML/Graphics/Sprite.hpp>
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/System/Vector2.hpp>
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -15,10 +16,11 @@ struct Transform {
     sf::Vector2f position{0.f, 0.f};
     float rotation{0.f};  // 角度
     sf::Vector2f scale{1.f, 1.f};
+    sf::Vector2f previousPosition{0.f, 0.f};  // 上一逻辑帧的位置（渲染插值用）
 
     Transform() = default;
-    Transform(float x, float y) : position(x, y) {}
-    Transform(const sf::Vector2f& pos) : position(pos) {}
+    Transform(float x, float y) : position(x, y), previousPosition(x, y) {}
+    Transform(const sf::Vector2f& pos) : position(pos), previousPosition(pos) {}
 };
 
 /// 精灵组件 - 可视化表示
@@ -38,17 +40,33 @@ struct Sprite {
 struct Velocity {
     sf::Vector2f velocity{0.f, 0.f};
     float maxSpeed{100.f};  // 像素/秒
+    int restTicks{0};       // 连续低速的逻辑帧数（休眠判定用）
 
     Velocity() = default;
     Velocity(float vx, float vy, float maxSpd = 100.f)
         : velocity(vx, vy), maxSpeed(maxSpd) {}
 };
 
+/// 碰撞层（位标志，每个碰撞体属于一层）
+namespace CollisionLayer {
+    constexpr std::uint32_t Default  = 1u << 0;  // 墙壁等未分类物体
+    constexpr std::uint32_t Player   = 1u << 1;
+    constexpr std::uint32_t Hostile  = 1u << 2;
+    constexpr std::uint32_t NPC      = 1u << 3;
+    constexpr std::uint32_t Building = 1u << 4;
+    constexpr std::uint32_t Resource = 1u << 5;
+    constexpr std::uint32_t Item     = 1u << 6;
+    constexpr std::uint32_t Trap     = 1u << 7;
+    constexpr std::uint32_t All      = 0xFFFFFFFFu;
+}
+
 /// 碰撞箱组件
 struct Collider {
     sf::Vector2f size{32.f, 32.f};
     sf::Vector2f offset{0.f, 0.f};  // 相对于 Transform 的偏移
     bool isTrigger{false};  // 是否只用于触发事件，不阻挡移动
+    std::uint32_t layer{CollisionLayer::Default};  // 所属碰撞层
+    std::uint32_t mask{CollisionLayer::All};       // 与哪些层发生碰撞
     
     Collider() = default;
     Collider(float w, float h) : size(w, h) {}
@@ -155,6 +173,13 @@ enum class AIState {
     Dead
 };
 
+/// AI 细节层级（按与玩家 / 相机的距离划分，远处降频更新）
+enum class AILodTier : std::uint8_t {
+    Near,   // 相机内或玩家附近：每个逻辑帧更新
+    Mid,    // 中距离：每隔几帧更新
+    Far     // 远处：低频更新
+};
+
 /// 僵尸类型枚举
 enum class ZombieType {
     Normal,     // 普通僵尸
@@ -174,8 +199,17 @@ struct AI {
     float moveSpeed{80.f};            // 移动速度
     float fleeHealthThreshold{0.2f};  // 低于此血量比例时逃跑
     entt::entity target{entt::null};  // 当前目标实体
+    AILodTier lodTier{AILodTier::Near};   // 当前 LOD 档位（AISystem 每帧重新划分）
+    float lodDeltaTime{0.f};              // 降频期间累积、尚未处理的时间
 };
 
+/// AI 状态标签：与 AI::state 一一对应（Dead 没有标签），由 AISystem 在状态切换时替换
+struct IdleState {};
+struct PatrolState {};
+struct ChaseState {};
+struct AttackState {};
+struct FleeState {};
+
 /// 僵尸特性
 struct Zombie {
     ZombieType type{ZombieType::Normal};
@@ -192,6 +226,30 @@ struct Patrol {
     bool loop{true};
 };
 
+/// 沿寻路服务返回的路点移动（句柄非 0 表示结果尚未取回）
+struct PathFollow {
+    sf::Vector2f destination;
+    bool requested{false};               // destination 的请求已发出（新挂载或请求队列满时为 false）
+    std::uint32_t handle{0};
+    std::vector<sf::Vector2f> waypoints;
+    size_t currentWaypoint{0};
+};
+
+/// 行军阵型成员（领队带 PathFollow 寻路，其余成员只向自己的阵位转向）
+struct SquadMember {
+    std::uint32_t squad{0};       // FormationSystem 中的小队编号
+    sf::Vector2f slotOffset;      // 阵位相对领队的偏移
+    bool leader{false};
+};
+
+/// 行为树状态（由 BehaviorTreeEngine 挂载，黑板在引擎的内存池里）
+struct BehaviorAgent {
+    std::uint16_t tree{0};             // 树编号
+    std::uint16_t node{0};             // 当前叶子
+    std::uint16_t blackboardSize{0};   // 黑板槽位数
+    std::uint32_t blackboard{0};       // 黑板在内存池中的偏移
+};
+
 // ==================== 玩家与 NPC ====================
 
 /// 玩家组件（标记性组件）
@@ -218,6 +276,22 @@ struct NPC {
     int experience{0};
 };
 
+/// NPC 工作类型（任务板按类型分别索引）
+enum class JobType : std::uint8_t {
+    Repair,     // 修理受损建筑
+    Harvest,    // 采集资源点
+    Refill,     // 给停工的生产建筑补料
+    Count
+};
+
+/// NPC 工作者：各类工作的优先级面板与当前认领的工作
+struct Worker {
+    std::uint8_t priorities[static_cast<size_t>(JobType::Count)]{};   // 0 表示不做，数值越大越优先
+    entt::entity job{entt::null};    // 认领的目标实体（建筑 / 资源点）
+    JobType jobType{JobType::Repair};
+    float progress{0.f};             // 当前工作已进行的时间（秒）
+};
+
 /// 背包/库存
 struct Inventory {
     struct Slot {
@@ -268,7 +342,9 @@ struct Producer {
     int productionAmount{1};   // 每次生产数量
     float productionInterval{10.f};  // 生产间隔（秒）
     float productionTimer{0.f};
-    bool isActive{true};
+    int refillCycles{0};       // 每次补料可生产的次数（0 = 不需要补料）
+    int cyclesSinceRefill{0};
+    bool isActive{true};       // 料用完后停工，等待 NPC 补料（JobType::Refill）
 };
 
 /// 炮塔组件
@@ -276,8 +352,10 @@ struct Turret {
     float range{200.f};           // 射程
     float damage{15.f};           // 伤害
     float attackSpeed{1.f};       // 攻击速度（次/秒）
+    float projectileSpeed{500.f}; // 子弹速度（像素/秒）
     float attackCooldown{0.f};    // 攻击冷却
     entt::entity currentTarget{entt::null};  // 当前目标
+    std::uint32_t targetGeneration{0};        // 锁定时目标的复用代数（见 Registry::getGeneration）
     float rotationSpeed{180.f};   // 旋转速度（度/秒）
     float targetRotation{0.f};    // 目标旋转角度
     bool autoTarget{true};        // 自动瞄准
@@ -361,10 +439,16 @@ struct Destructible {};
 /// 静态对象（不移动）
 struct Static {};
 
-/// 子弹标记
-struct Bullet {
-    float damage{0.f};  // 子弹伤害(可选,通常由发射者决定)
-    entt::entity owner{entt::null};  // 发射者
+/// 休眠标记（静止的动态物体，跳过积分与碰撞，写入速度或被碰撞时唤醒）
+struct Asleep {};
+
+/// 禁用标记（停放在对象池中等待复用的实体，保留原型组件；Registry 的视图和 isValid 自动排除）
+struct Disabled {};
+
+/// 对象池成员（实体由启用了对象池的原型生成，回收时停放到第 pool 个池）
+struct Pooled {
+    std::uint32_t pool{0};
+    std::uint32_t generation{0};   // 每次回收停放时递增（实体编号和版本在复用时不变）
 };
 
 /// 临时实体（会自动销毁）
@@ -1,8 +1,189 @@
 ﻿#include "Registry.h"
 #include "../core/Logger.h"
+#include <algorithm>
 
 namespace Nightfall {
 
+Registry::Registry() {
+    // 静态碰撞体索引：三个组件任意顺序添加都能触发入索引，任一被移除即出索引
+    m_registry.on_construct<Static>().connect<&Registry::onStaticColliderChanged>(*this);
+    m_registry.on_construct<Transform>().connect<&Registry::onStaticColliderChanged>(*this);
+    m_registry.on_construct<Collider>().connect<&Registry::onStaticColliderChanged>(*this);
+    m_registry.on_update<Transform>().connect<&Registry::onStaticColliderChanged>(*this);
+    m_registry.on_update<Collider>().connect<&Registry::onStaticColliderChanged>(*this);
+
+    m_registry.on_destroy<Static>().connect<&Registry::onStaticColliderRemoved>(*this);
+    m_registry.on_destroy<Transform>().connect<&Registry::onStaticColliderRemoved>(*this);
+    m_registry.on_destroy<Collider>().connect<&Registry::onStaticColliderRemoved>(*this);
+
+    // 停放到对象池的实体移出索引，复用时重新加入
+    m_registry.on_construct<Disabled>().connect<&Registry::onStaticColliderRemoved>(*this);
+    m_registry.on_destroy<Disabled>().connect<&Registry::onEntityEnabled>(*this);
+
+    m_commandBuffers.push_back(std::make_unique<CommandBuffer>());
+}
+
+void Registry::setJobSystem(JobSystem* jobSystem) {
+    m_jobSystem = jobSystem;
+
+    const size_t threadCount = jobSystem ? jobSystem->getThreadCount() : 1;
+    while (m_commandBuffers.size() < threadCount) {
+        m_commandBuffers.push_back(std::make_unique<CommandBuffer>());
+    }
+}
+
+CommandBuffer& Registry::commands() {
+    const size_t index = m_jobSystem ? m_jobSystem->getThreadIndex() : 0;
+    return *m_commandBuffers[index];
+}
+
+bool Registry::hasPendingCommands() const {
+    for (const auto& buffer : m_commandBuffers) {
+        if (!buffer->empty()) return true;
+    }
+    return false;
+}
+
+void Registry::flushCommands() {
+    m_flushList.clear();
+    for (auto& buffer : m_commandBuffers) {
+        m_flushList.push_back(buffer.get());
+    }
+    CommandBuffer::playback(m_registry, m_flushList.data(), m_flushList.size(), m_recycleList);
+
+    for (entt::entity entity : m_recycleList) {
+        recycle(entity);
+    }
+}
+
+void Registry::loadArchetypes(const std::string& enemiesPath, const std::string& buildingsPath) {
+    m_archetypes.loadEnemies(enemiesPath);
+    m_archetypes.loadBuildings(buildingsPath);
+}
+
+void Registry::spawnBatch(const Archetype& archetype, const sf::Vector2f* positions, size_t count, entt::entity* out) {
+    auto it = m_poolIndex.find(&archetype);
+    if (it == m_poolIndex.end()) {
+        archetype.spawn(m_registry, positions, count, out);
+        return;
+    }
+
+    const std::uint32_t poolId = it->second;
+    EntityPool& pool = m_pools[poolId];
+    EntityPoolStats& stats = m_poolStats[poolId];
+
+    // 先复用停放的实体：组件仍在存储里，原地恢复后去掉 Disabled
+    const size_t reused = std::min(count, pool.parked.size());
+    if (reused > 0) {
+        const entt::entity* first = pool.parked.data() + (pool.parked.size() - reused);
+        archetype.reset(m_registry, first, positions, reused);
+        m_registry.remove<Disabled>(first, first + reused);
+        if (out) {
+            std::copy(first, first + reused, out);
+        }
+        pool.parked.resize(pool.parked.size() - reused);
+        stats.parked = pool.parked.size();
+        stats.revived += reused;
+    }
+
+    // 不够的再新建
+    const size_t remaining = count - reused;
+    if (remaining > 0) {
+        m_spawned.resize(remaining);
+        archetype.spawn(m_registry, positions + reused, remaining, m_spawned.data());
+        m_registry.insert<Pooled>(m_spawned.begin(), m_spawned.end(), Pooled{poolId});
+        if (out) {
+            std::copy(m_spawned.begin(), m_spawned.end(), out + reused);
+        }
+        stats.created += remaining;
+    }
+}
+
+void Registry::enablePooling(const Archetype& archetype, size_t capacity) {
+    auto it = m_poolIndex.find(&archetype);
+    if (it != m_poolIndex.end()) {
+        m_poolStats[it->second].capacity = capacity;
+        return;
+    }
+
+    EntityPool pool;
+    pool.archetype = &archetype;
+    pool.keep = archetype.getComponentTypes();
+    pool.keep.push_back(entt::type_hash<Transform>::value());
+    pool.keep.push_back(entt::type_hash<Pooled>::value());
+    pool.keep.push_back(entt::type_hash<Disabled>::value());
+    std::sort(pool.keep.begin(), pool.keep.end());
+    pool.parked.reserve(capacity);
+
+    EntityPoolStats stats;
+    stats.archetype = archetype.getName();
+    stats.capacity = capacity;
+
+    m_poolIndex.emplace(&archetype, static_cast<std::uint32_t>(m_pools.size()));
+    m_pools.push_back(std::move(pool));
+    m_poolStats.push_back(std::move(stats));
+}
+
+void Registry::recycle(entt::entity entity) {
+    if (!m_registry.valid(entity) || m_registry.all_of<Disabled>(entity)) return;
+
+    const auto* pooled = m_registry.try_get<Pooled>(entity);
+    if (!pooled) {
+        m_registry.destroy(entity);
+        return;
+    }
+
+    EntityPool& pool = m_pools[pooled->pool];
+    EntityPoolStats& stats = m_poolStats[pooled->pool];
+    if (pool.parked.size() >= stats.capacity) {
+        ++stats.discarded;
+        m_registry.destroy(entity);
+        return;
+    }
+
+    // 移除生存期间添加的组件（状态标签、寻路请求等），照常触发 on_destroy 信号
+    m_stripList.clear();
+    for (auto [id, storage] : m_registry.storage()) {
+        if (storage.contains(entity) && !std::binary_search(pool.keep.begin(), pool.keep.end(), id)) {
+            m_stripList.push_back(&storage);
+        }
+    }
+    for (entt::sparse_set* storage : m_stripList) {
+        storage->remove(entity);
+    }
+
+    // 复用时实体编号和版本不变，递增代数让持有旧句柄的一方能识别出新实体
+    ++m_registry.get<Pooled>(entity).generation;
+    m_registry.emplace<Disabled>(entity);
+    pool.parked.push_back(entity);
+
+    ++stats.recycled;
+    stats.parked = pool.parked.size();
+    stats.peakParked = std::max(stats.peakParked, stats.parked);
+}
+
+void Registry::onStaticColliderChanged(entt::registry& registry, entt::entity entity) {
+    if (registry.all_of<Disabled>(entity)) return;
+    updateStaticIndex(entity);
+}
+
+void Registry::onEntityEnabled(entt::registry&, entt::entity entity) {
+    // on_destroy 在 Disabled 移除之前发出，此时不能再检查 Disabled
+    updateStaticIndex(entity);
+}
+
+void Registry::updateStaticIndex(entt::entity entity) {
+    if (!m_registry.all_of<Static, Transform, Collider>(entity)) return;
+
+    const auto& transform = m_registry.get<Transform>(entity);
+    const auto& collider = m_registry.get<Collider>(entity);
+    m_staticIndex.insertOrUpdate(entity, sf::FloatRect(transform.position - collider.size / 2.f, collider.size));
+}
+
+void Registry::onStaticColliderRemoved(entt::registry&, entt::entity entity) {
+    m_staticIndex.remove(entity);
+}
+
 entt::entity Registry::createPlayer(const sf::Vector2f& position) {
     auto entity = createEntity();
 
@@ -10,7 +191,7 @@ entt::entity Registry::createPlayer(const sf::Vector2f& position) {
     addComponent<Transform>(entity, position);
     addComponent<Velocity>(entity, 0.f, 0.f, 200.f);  // 最大速度 200 px/s
     addComponent<Sprite>(entity, "player", 10);  // 高渲染层级
-    addComponent<Collider>(entity, 32.f, 32.f);
+    addComponent<Collider>(entity, 32.f, 32.f).layer = CollisionLayer::Player;
 
     // 生存组件
     addComponent<Health>(entity, 100.f);
@@ -31,79 +212,8 @@ entt::entity Registry::createPlayer(const sf::Vector2f& position) {
 }
 
 entt::entity Registry::createZombie(const sf::Vector2f& position, ZombieType type) {
-    auto entity = createEntity();
-
-    // 基础组件
-    addComponent<Transform>(entity, position);
-    addComponent<Sprite>(entity, "zombie_normal", 5);
-    addComponent<Collider>(entity, 32.f, 32.f);
-
-    // 根据僵尸类型设置属性
-    float maxSpeed = 50.f;
-    float health = 50.f;
-    float damage = 10.f;
-    float detectionRange = 200.f;
-
-    switch (type) {
-        case ZombieType::Fast:
-            maxSpeed = 150.f;
-            health = 30.f;
-            damage = 8.f;
-            addComponent<Sprite>(entity, "zombie_fast", 5);
-            break;
-
-        case ZombieType::Tank:
-            maxSpeed = 30.f;
-            health = 200.f;
-            damage = 20.f;
-            addComponent<Sprite>(entity, "zombie_tank", 5);
-            break;
-
-        case ZombieType::Exploder:
-            maxSpeed = 60.f;
-            health = 40.f;
-            damage = 50.f;  // 爆炸伤害
-            addComponent<Sprite>(entity, "zombie_exploder", 5);
-            break;
-
-        case ZombieType::Boss:
-            maxSpeed = 40.f;
-            health = 500.f;
-            damage = 30.f;
-            detectionRange = 400.f;
-            addComponent<Sprite>(entity, "zombie_boss", 6);
-            break;
-
-        case ZombieType::Normal:
-        default:
-            // 使用默认值
-            break;
-    }
-
-    addComponent<Velocity>(entity, 0.f, 0.f, maxSpeed);
-    addComponent<Health>(entity, health);
-
-    // 战斗组件
-    auto& combat = addComponent<Combat>(entity);
-    combat.attackDamage = damage;
-    combat.attackSpeed = 1.f;
-    combat.attackRange = 40.f;
-
-    // AI 组件
-    auto& ai = addComponent<AI>(entity);
-    ai.detectionRange = detectionRange;
-    ai.attackRange = 40.f;
-    ai.state = AIState::Patrol;
-    ai.stateTimer = 0.f;
-    ai.attackCooldown = 0.f;
-    ai.moveSpeed = maxSpeed;
-
-    // 僵尸特性
-    addComponent<Zombie>(entity).type = type;
-
-    // 标记
-    addComponent<Hostile>(entity);
-    addComponent<Destructible>(entity);
+    entt::entity entity = entt::null;
+    spawnBatch(m_archetypes.getZombie(type), &position, 1, &entity);
 
     NF_DEBUG("创建僵尸实体: {} (类型: {})", static_cast<uint32_t>(entity), static_cast<int>(type));
     return entity;
@@ -116,7 +226,7 @@ entt::entity Registry::createNPC(const sf::Vector2f& position, const std::string
     addComponent<Transform>(entity, position);
     addComponent<Velocity>(entity, 0.f, 0.f, 100.f);
     addComponent<Sprite>(entity, "npc_generic", 8);
-    addComponent<Collider>(entity, 32.f, 32.f);
+    addComponent<Collider>(entity, 32.f, 32.f).layer = CollisionLayer::NPC;
 
     // 生存组件
     addComponent<Health>(entity, 80.f);
@@ -163,75 +273,8 @@ entt::entity Registry::createNPC(const sf::Vector2f& position, const std::string
 }
 
 entt::entity Registry::createBuilding(const sf::Vector2f& position, Building::Type type) {
-    auto entity = createEntity();
-
-    addComponent<Transform>(entity, position);
-    addComponent<Sprite>(entity, "building_" + std::to_string(static_cast<int>(type)), 3);
-    addComponent<Collider>(entity, 64.f, 64.f);
-
-    auto& building = addComponent<Building>(entity);
-    building.type = type;
-    building.isComplete = false;
-    building.constructionProgress = 0.f;
-
-    // 根据建筑类型设置属性
-    switch (type) {
-        case Building::Type::Wall:
-            building.maxDurability = 200.f;
-            building.durability = 200.f;
-            break;
-
-        case Building::Type::Turret:
-            building.maxDurability = 100.f;
-            building.durability = 100.f;
-            addComponent<Turret>(entity);
-            addComponent<Combat>(entity).attackRange = 300.f;
-            break;
-
-        case Building::Type::Generator:
-            building.maxDurability = 150.f;
-            building.durability = 150.f;
-            addComponent<Producer>(entity).resourceType = "electricity";
-            break;
-
-        case Building::Type::Farm:
-            building.maxDurability = 80.f;
-            building.durability = 80.f;
-            {
-                auto& producer = addComponent<Producer>(entity);
-                producer.resourceType = "food";
-                producer.productionAmount = 2;
-                producer.productionInterval = 10.f;  // 每10秒生产2个食物
-            }
-            break;
-
-        case Building::Type::Storage:
-            building.maxDurability = 120.f;
-            building.durability = 120.f;
-            addComponent<Inventory>(entity).maxSlots = 50;
-            addComponent<Interactable>(entity).type = Interactable::Type::Container;
-            break;
-
-        case Building::Type::Workshop:
-            building.maxDurability = 100.f;
-            building.durability = 100.f;
-            {
-                auto& producer = addComponent<Producer>(entity);
-                producer.resourceType = "metal";
-                producer.productionAmount = 1;
-                producer.productionInterval = 15.f;  // 每15秒生产1个金属
-            }
-            addComponent<Interactable>(entity).type = Interactable::Type::Workbench;
-            break;
-
-        default:
-            building.maxDurability = 100.f;
-            building.durability = 100.f;
-            break;
-    }
-
-    addComponent<Static>(entity);
-    addComponent<Destructible>(entity);
+    entt::entity entity = entt::null;
+    spawnBatch(m_archetypes.getBuilding(type), &position, 1, &entity);
 
     NF_INFO("创建建筑: {} (类型: {})", static_cast<uint32_t>(entity), static_cast<int>(type));
     return entity;
@@ -242,7 +285,10 @@ entt::entity Registry::createDroppedItem(const sf::Vector2f& position, const std
 
     addComponent<Transform>(entity, position);
     addComponent<Sprite>(entity, "item_" + itemId, 2);
-    addComponent<Collider>(entity, 16.f, 16.f).isTrigger = true;
+    auto& collider = addComponent<Collider>(entity, 16.f, 16.f);
+    collider.isTrigger = true;
+    collider.layer = CollisionLayer::Item;
+    addComponent<Static>(entity);  // 掉落物不移动：进入静态索引，作为触发器产生事件
 
     auto& dropped = addComponent<Dropped>(entity);
     dropped.itemId = itemId;
@@ -293,13 +339,13 @@ entt::entity Registry::createResourceNode(const sf::Vector2f& position, const st
     // 根据资源类型设置不同的外观
     if (resourceType == "wood") {
         addComponent<Sprite>(entity, "tree", 4);  // 树木，层级4（在地面上方）
-        addComponent<Collider>(entity, 48.f, 48.f);
+        addComponent<Collider>(entity, 48.f, 48.f).layer = CollisionLayer::Resource;
     } else if (resourceType == "metal") {
         addComponent<Sprite>(entity, "ore", 4);  // 矿石
-        addComponent<Collider>(entity, 40.f, 40.f);
+        addComponent<Collider>(entity, 40.f, 40.f).layer = CollisionLayer::Resource;
     } else {
         addComponent<Sprite>(entity, "resource_" + resourceType, 4);
-        addComponent<Collider>(entity, 40.f, 40.f);
+        addComponent<Collider>(entity, 40.f, 40.f).layer = CollisionLayer::Resource;
     }
 
     auto& node = addComponent<ResourceNode>(entity);
@@ -2,14 +2,30 @@
 
 #include <entt/entt.hpp>
 #include "Components.h"
+#include "SpatialGrid.h"
+#include "CommandBuffer.h"
+#include "Archetype.h"
+#include "../core/JobSystem.h"
 
 namespace Nightfall {
 
+/// 对象池统计（每次停放、复用时更新）
+struct EntityPoolStats {
+    std::string archetype;
+    size_t capacity{0};        // 最多停放的实体数
+    size_t parked{0};          // 当前停放的实体数
+    size_t peakParked{0};      // 停放数峰值
+    size_t created{0};         // 池空时新建的实体（累计）
+    size_t revived{0};         // 从池中复用的实体（累计）
+    size_t recycled{0};        // 回收停放的实体（累计）
+    size_t discarded{0};       // 池满时直接销毁的实体（累计）
+};
+
 /// ECS 注册表封装
 /// 封装 EnTT 的核心功能，提供更简洁的接口
 class Registry {
 public:
-    Registry() = default;
+    Registry();
     ~Registry() = default;
 
     // 禁止拷贝
@@ -28,9 +44,20 @@ public:
         }
     }
 
-    /// 检查实体是否有效
+    /// 检查实体是否有效（停放在对象池中的实体视为无效）
     bool isValid(entt::entity entity) const {
-        return m_registry.valid(entity);
+        return m_registry.valid(entity) && !m_registry.all_of<Disabled>(entity);
+    }
+
+    /// 对象池实体的复用代数（不属于对象池的实体恒为 0）；跨帧保存实体句柄时一并记下
+    std::uint32_t getGeneration(entt::entity entity) const {
+        const auto* pooled = m_registry.valid(entity) ? m_registry.try_get<Pooled>(entity) : nullptr;
+        return pooled ? pooled->generation : 0;
+    }
+
+    /// 检查实体有效且没有在记下代数之后被回收复用
+    bool isValid(entt::entity entity, std::uint32_t generation) const {
+        return isValid(entity) && getGeneration(entity) == generation;
     }
 
     /// 添加组件
@@ -91,10 +118,17 @@ public:
         return m_registry.get_or_emplace<Component>(entity, std::forward<Args>(args)...);
     }
 
-    /// 遍历所有拥有指定组件的实体
+    /// 修改组件并发出 on_update 信号
+    /// 静态物体的 Transform/Collider 必须通过此函数修改，静态碰撞体索引才会同步
+    template<typename Component, typename... Func>
+    Component& patchComponent(entt::entity entity, Func&&... func) {
+        return m_registry.patch<Component>(entity, std::forward<Func>(func)...);
+    }
+
+    /// 遍历所有拥有指定组件的实体（跳过对象池中停放的实体，下同）
     template<typename... Components, typename Func>
     void each(Func&& func) {
-        auto view = m_registry.view<Components...>();
+        auto view = m_registry.view<Components...>(entt::exclude<Disabled>);
         for (auto entity : view) {
             func(entity, view.get<Components>(entity)...);
         }
@@ -103,21 +137,70 @@ public:
     /// 遍历所有拥有指定组件的实体（const 版本）
     template<typename... Components, typename Func>
     void each(Func&& func) const {
-        auto view = m_registry.view<Components...>();
+        auto view = m_registry.view<Components...>(entt::exclude<Disabled>);
         for (auto entity : view) {
             func(entity, view.get<Components>(entity)...);
         }
     }
 
-    /// 获取视图（用于更复杂的查询）
-    template<typename... Components>
-    auto view() {
-        return m_registry.view<Components...>();
+    /**
+     * @brief 并行遍历：把视图主存储的紧凑实体数组切成按缓存行对齐的区间，交给任务系统并发执行
+     *
+     * func(entity, components&...) 只能读写传入实体自身的组件，不能增删组件、创建或销毁实体。
+     * 区间长度是每缓存行实体数的整数倍，相邻任务不会写同一缓存行；未设置任务系统时顺序执行。
+     * 可选排除组件：parallel_each<Transform, Velocity>(func, entt::exclude<Asleep>)
+     */
+    template<typename... Components, typename Func, typename... Exclude>
+    void parallel_each(Func&& func, entt::exclude_t<Exclude...> = {}) {
+        auto view = m_registry.view<Components...>(entt::exclude<Disabled, Exclude...>);
+        const auto* storage = view.handle();
+        if (!storage || storage->size() == 0) return;
+
+        // 主存储的紧凑数组里可能有不满足其他组件或排除条件的实体，逐个检查
+        const entt::entity* entities = storage->data();
+        auto body = [&view, &func, entities](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const entt::entity entity = entities[i];
+                if (view.contains(entity)) {
+                    func(entity, view.template get<Components>(entity)...);
+                }
+            }
+        };
+
+        if (!m_jobSystem) {
+            body(0, storage->size());
+            return;
+        }
+        m_jobSystem->parallelFor(storage->size(), kParallelMinRange, body);
     }
 
-    template<typename... Components>
-    auto view() const {
-        return m_registry.view<Components...>();
+    /// 设置并行遍历使用的任务系统（同时为它的每个线程准备一个命令缓冲）
+    void setJobSystem(JobSystem* jobSystem);
+
+    /**
+     * @brief 当前线程的命令缓冲
+     *
+     * 非独占系统（以及它们调用的战斗结算等）不能直接创建 / 销毁实体或增删组件，
+     * 改为记录到这里，由调度器在同步点回放。只能在主线程或任务系统的线程上调用。
+     */
+    CommandBuffer& commands();
+
+    /// 是否有尚未回放的命令
+    bool hasPendingCommands() const;
+
+    /// 回放所有线程的命令缓冲（只能在主线程、没有系统执行时调用）
+    void flushCommands();
+
+    /// 获取视图（用于更复杂的查询），总是排除对象池中停放的实体
+    /// 可选排除组件：view<Transform, Collider>(entt::exclude<Static>)
+    template<typename... Components, typename... Exclude>
+    auto view(entt::exclude_t<Exclude...> = {}) {
+        return m_registry.view<Components...>(entt::exclude<Disabled, Exclude...>);
+    }
+
+    template<typename... Components, typename... Exclude>
+    auto view(entt::exclude_t<Exclude...> = {}) const {
+        return m_registry.view<Components...>(entt::exclude<Disabled, Exclude...>);
     }
 
     /// 清除所有实体
@@ -125,7 +208,7 @@ public:
         m_registry.clear();
     }
 
-    /// 获取实体数量
+    /// 获取实体数量（包括对象池中停放的实体）
     size_t getEntityCount() const {
         // 使用 storage 获取所有实体
         const auto* storage = m_registry.storage<entt::entity>();
@@ -136,6 +219,52 @@ public:
     entt::registry& raw() { return m_registry; }
     const entt::registry& raw() const { return m_registry; }
 
+    /// 静态碰撞体索引（Static + Transform + Collider）
+    /// 通过 EnTT 的 construct/destroy/update 信号增量维护，只在静态物体放置、移动或销毁时变化
+    const SpatialGrid& getStaticIndex() const { return m_staticIndex; }
+
+    // ==================== 实体原型 ====================
+
+    /// 载入敌人、建筑原型（文件中的字段覆盖内置默认值；文件缺失时保留默认值）
+    void loadArchetypes(const std::string& enemiesPath, const std::string& buildingsPath);
+
+    const ArchetypeLibrary& getArchetypes() const { return m_archetypes; }
+
+    /// 按名字查找原型（没有时返回 nullptr）
+    const Archetype* findArchetype(const std::string& name) const {
+        return m_archetypes.find(name);
+    }
+
+    /**
+     * @brief 批量生成：在 positions[0..count) 处生成 count 个同一原型的实体
+     *
+     * 每种组件的存储只预留一次，再整段插入，适合一次生成整波敌人。
+     * 原型启用了对象池时先复用池中停放的实体（组件原地恢复为模板值），不够的再新建。
+     * 会直接修改注册表，只能在主线程、没有系统并行执行时调用（非独占系统请用 commands()）。
+     * @param out 可选，写入生成的实体（长度至少为 count）
+     */
+    void spawnBatch(const Archetype& archetype, const sf::Vector2f* positions, size_t count, entt::entity* out = nullptr);
+
+    // ==================== 对象池 ====================
+
+    /**
+     * @brief 为原型启用对象池，最多停放 capacity 个实体
+     *
+     * 之后由该原型生成的实体带 Pooled 组件。回收时不销毁，而是移除原型以外的组件、
+     * 加上 Disabled 标记停放；再次生成时复用，避免存储反复增长收缩和稀疏集的交换移除。
+     * 应在载入原型之后调用。
+     */
+    void enablePooling(const Archetype& archetype, size_t capacity);
+
+    /**
+     * @brief 回收实体：属于对象池且池未满时停放，否则销毁
+     *
+     * 会直接修改注册表，只能在主线程、没有系统并行执行时调用（非独占系统请用 commands().recycle）。
+     */
+    void recycle(entt::entity entity);
+
+    const std::vector<EntityPoolStats>& getPoolStats() const { return m_poolStats; }
+
     // ==================== 便捷创建函数 ====================
 
     /// 创建玩家实体
@@ -163,7 +292,39 @@ public:
     entt::entity createResourceNode(const sf::Vector2f& position, const std::string& resourceType, int amount = 10);
 
 private:
+    /// 并行遍历的最小区间（实体数）：16 个缓存行的实体
+    static constexpr size_t kParallelMinRange = 64 / sizeof(entt::entity) * 16;
+
+    /// 静态碰撞体相关组件被添加或 patch 时同步索引
+    void onStaticColliderChanged(entt::registry& registry, entt::entity entity);
+
+    /// 静态碰撞体相关组件被移除或实体被销毁时同步索引
+    void onStaticColliderRemoved(entt::registry& registry, entt::entity entity);
+
+    /// 实体离开对象池（Disabled 被移除）时重新加入静态碰撞体索引
+    void onEntityEnabled(entt::registry& registry, entt::entity entity);
+
+    void updateStaticIndex(entt::entity entity);
+
+    /// 停放的实体（按 Pooled::pool 编号）
+    struct EntityPool {
+        const Archetype* archetype{nullptr};
+        std::vector<entt::id_type> keep;         // 停放时保留的组件类型（已排序）
+        std::vector<entt::entity> parked;
+    };
+
     entt::registry m_registry;
+    SpatialGrid m_staticIndex;
+    ArchetypeLibrary m_archetypes;
+    std::vector<EntityPool> m_pools;
+    std::vector<EntityPoolStats> m_poolStats;
+    std::unordered_map<const Archetype*, std::uint32_t> m_poolIndex;
+    std::vector<entt::entity> m_spawned;        // 批量生成时新建的实体（复用）
+    std::vector<entt::entity> m_recycleList;    // 回放命令缓冲得到的待回收实体
+    std::vector<entt::sparse_set*> m_stripList;  // 停放时要移除的组件存储
+    JobSystem* m_jobSystem{nullptr};
+    std::vector<std::unique_ptr<CommandBuffer>> m_commandBuffers;   // 按任务系统的线程编号
+    std::vector<CommandBuffer*> m_flushList;
 };
 
 } // namespace Nightfall
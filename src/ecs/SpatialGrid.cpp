@@ -0,0 +1,98 @@
+﻿#include "SpatialGrid.h"
+
+namespace Nightfall {
+
+void SpatialGrid::insertOrUpdate(entt::entity entity, const sf::FloatRect& bounds) {
+    Record record;
+    record.bounds = bounds;
+    record.minX = toCell(bounds.position.x);
+    record.minY = toCell(bounds.position.y);
+    record.maxX = toCell(bounds.position.x + bounds.size.x);
+    record.maxY = toCell(bounds.position.y + bounds.size.y);
+
+    auto it = m_records.find(entity);
+    if (it != m_records.end()) {
+        const Record& old = it->second;
+        if (old.bounds.position == bounds.position && old.bounds.size == bounds.size) {
+            return;
+        }
+        if (old.minX == record.minX && old.minY == record.minY &&
+            old.maxX == record.maxX && old.maxY == record.maxY) {
+            // 仍在同一组格子里（移动物体的常见情况）：原地更新包围盒
+            it->second.bounds = bounds;
+            updateInCells(entity, record);
+            ++m_version;
+            return;
+        }
+        removeFromCells(entity, old);
+        it->second = record;
+    } else {
+        m_records.emplace(entity, record);
+    }
+
+    addToCells(entity, record);
+    ++m_version;
+}
+
+void SpatialGrid::remove(entt::entity entity) {
+    auto it = m_records.find(entity);
+    if (it == m_records.end()) return;
+
+    removeFromCells(entity, it->second);
+    m_records.erase(it);
+    ++m_version;
+}
+
+void SpatialGrid::clear() {
+    m_cells.clear();
+    m_records.clear();
+    ++m_version;
+}
+
+void SpatialGrid::addToCells(entt::entity entity, const Record& record) {
+    for (int cy = record.minY; cy <= record.maxY; ++cy) {
+        for (int cx = record.minX; cx <= record.maxX; ++cx) {
+            m_cells[makeKey(cx, cy)].push_back({entity, record.bounds, record.minX, record.minY});
+        }
+    }
+}
+
+void SpatialGrid::updateInCells(entt::entity entity, const Record& record) {
+    for (int cy = record.minY; cy <= record.maxY; ++cy) {
+        for (int cx = record.minX; cx <= record.maxX; ++cx) {
+            auto cell = m_cells.find(makeKey(cx, cy));
+            if (cell == m_cells.end()) continue;
+
+            for (Item& item : cell->second) {
+                if (item.entity == entity) {
+                    item.bounds = record.bounds;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void SpatialGrid::removeFromCells(entt::entity entity, const Record& record) {
+    for (int cy = record.minY; cy <= record.maxY; ++cy) {
+        for (int cx = record.minX; cx <= record.maxX; ++cx) {
+            auto cell = m_cells.find(makeKey(cx, cy));
+            if (cell == m_cells.end()) continue;
+
+            auto& items = cell->second;
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (items[i].entity == entity) {
+                    items[i] = items.back();
+                    items.pop_back();
+                    break;
+                }
+            }
+
+            if (items.empty()) {
+                m_cells.erase(cell);
+            }
+        }
+    }
+}
+
+} // namespace Nightfall
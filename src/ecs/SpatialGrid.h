@@ -0,0 +1,164 @@
+﻿#pragma once
+
+#include <entt/entt.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Nightfall {
+
+/// 持久化空间网格（增量维护）
+/// 以实体为键保存包围盒，按覆盖的格子分桶存放；
+/// 只有在实体插入、移动或删除时才改动对应格子的桶，查询不需要读取组件。
+class SpatialGrid {
+public:
+    explicit SpatialGrid(float cellSize = 128.f) : m_cellSize(cellSize) {}
+
+    /// 插入实体，或在包围盒变化时更新它所在的格子
+    void insertOrUpdate(entt::entity entity, const sf::FloatRect& bounds);
+
+    /// 移除实体（不存在时忽略）
+    void remove(entt::entity entity);
+
+    /// 清空索引
+    void clear();
+
+    /// 是否包含实体
+    bool contains(entt::entity entity) const { return m_records.count(entity) != 0; }
+
+    /// 获取实体的包围盒（不存在时返回 nullptr）
+    const sf::FloatRect* getBounds(entt::entity entity) const {
+        auto it = m_records.find(entity);
+        return it != m_records.end() ? &it->second.bounds : nullptr;
+    }
+
+    /// 实体数量
+    size_t size() const { return m_records.size(); }
+
+    /// 内容版本号，每次插入/移动/删除后递增
+    std::uint32_t getVersion() const { return m_version; }
+
+    float getCellSize() const { return m_cellSize; }
+
+    /// 遍历与区域所在格子重叠的实体，每个实体只报告一次
+    /// @param func void(entt::entity entity, const sf::FloatRect& bounds)
+    template<typename Func>
+    void query(const sf::FloatRect& area, Func&& func) const {
+        const int minX = toCell(area.position.x);
+        const int minY = toCell(area.position.y);
+        const int maxX = toCell(area.position.x + area.size.x);
+        const int maxY = toCell(area.position.y + area.size.y);
+
+        for (int cy = minY; cy <= maxY; ++cy) {
+            for (int cx = minX; cx <= maxX; ++cx) {
+                auto it = m_cells.find(makeKey(cx, cy));
+                if (it == m_cells.end()) continue;
+
+                for (const Item& item : it->second) {
+                    // 跨越多个格子的实体只在与查询区域重叠部分的左上角格子里报告
+                    if (std::max(item.minX, minX) != cx || std::max(item.minY, minY) != cy) {
+                        continue;
+                    }
+                    func(item.entity, item.bounds);
+                }
+            }
+        }
+    }
+
+    /// 查找离 center 最近的至多 k 个实体（按包围盒中心距离），结果按距离升序写入 out
+    /// 从中心格子逐圈向外搜索，已找到 k 个且第 k 个不可能被更外圈超过时提前结束
+    /// @param filter bool(entt::entity entity)，返回 false 的实体被跳过
+    template<typename Filter>
+    void nearestK(const sf::Vector2f& center, float maxRadius, size_t k, Filter&& filter,
+                  std::vector<std::pair<float, entt::entity>>& out) const {
+        out.clear();
+        if (k == 0 || m_records.empty()) return;
+
+        const float maxRadiusSq = maxRadius * maxRadius;
+        const int centerX = toCell(center.x);
+        const int centerY = toCell(center.y);
+        const int maxRing = static_cast<int>(std::ceil(maxRadius / m_cellSize)) + 1;
+
+        auto visitCell = [&](int cx, int cy) {
+            auto it = m_cells.find(makeKey(cx, cy));
+            if (it == m_cells.end()) return;
+
+            for (const Item& item : it->second) {
+                const sf::Vector2f itemCenter = item.bounds.position + item.bounds.size / 2.f;
+                const float dx = itemCenter.x - center.x;
+                const float dy = itemCenter.y - center.y;
+                const float distSq = dx * dx + dy * dy;
+                if (distSq > maxRadiusSq) continue;
+                if (out.size() == k && distSq >= out.back().first) continue;
+
+                // 跨格子的实体可能被多次访问
+                bool seen = false;
+                for (const auto& entry : out) {
+                    if (entry.second == item.entity) { seen = true; break; }
+                }
+                if (seen || !filter(item.entity)) continue;
+
+                auto pos = std::upper_bound(out.begin(), out.end(), distSq,
+                    [](float d, const std::pair<float, entt::entity>& entry) { return d < entry.first; });
+                out.insert(pos, {distSq, item.entity});
+                if (out.size() > k) out.pop_back();
+            }
+        };
+
+        for (int ring = 0; ring <= maxRing; ++ring) {
+            if (ring == 0) {
+                visitCell(centerX, centerY);
+            } else {
+                for (int i = -ring; i <= ring; ++i) {
+                    visitCell(centerX + i, centerY - ring);
+                    visitCell(centerX + i, centerY + ring);
+                }
+                for (int i = -ring + 1; i <= ring - 1; ++i) {
+                    visitCell(centerX - ring, centerY + i);
+                    visitCell(centerX + ring, centerY + i);
+                }
+            }
+
+            // 更外圈的实体中心距离至少为 ring * cellSize
+            const float ringDist = static_cast<float>(ring) * m_cellSize;
+            if (out.size() == k && out.back().first <= ringDist * ringDist) break;
+        }
+    }
+
+private:
+    /// 格子桶中的条目（内联包围盒，查询时无需再查表）
+    struct Item {
+        entt::entity entity;
+        sf::FloatRect bounds;
+        int minX, minY;
+    };
+
+    /// 实体记录：覆盖的格子范围
+    struct Record {
+        sf::FloatRect bounds;
+        int minX, minY, maxX, maxY;
+    };
+
+    int toCell(float coord) const {
+        return static_cast<int>(std::floor(coord / m_cellSize));
+    }
+
+    static std::uint64_t makeKey(int cellX, int cellY) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellY)) << 32) |
+               static_cast<std::uint32_t>(cellX);
+    }
+
+    void addToCells(entt::entity entity, const Record& record);
+    void updateInCells(entt::entity entity, const Record& record);
+    void removeFromCells(entt::entity entity, const Record& record);
+
+    float m_cellSize;
+    std::unordered_map<std::uint64_t, std::vector<Item>> m_cells;
+    std::unordered_map<entt::entity, Record> m_records;
+    std::uint32_t m_version{0};
+};
+
+} // namespace Nightfall
@@ -1 +1,197 @@
-﻿
\ No newline at end of file
+﻿#include "Systems.h"
+#include "../core/Logger.h"
+#include <algorithm>
+
+namespace Nightfall {
+
+namespace {
+
+bool intersects(const std::vector<entt::id_type>& a, const std::vector<entt::id_type>& b) {
+    for (entt::id_type id : a) {
+        if (std::find(b.begin(), b.end(), id) != b.end()) return true;
+    }
+    return false;
+}
+
+float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+// ========== SystemAccess ==========
+
+bool SystemAccess::conflictsWith(const SystemAccess& other) const {
+    if (m_exclusive || other.m_exclusive) return true;
+
+    // 读读不冲突；写写、读写冲突
+    return intersects(m_writes, other.m_writes)
+        || intersects(m_writes, other.m_reads)
+        || intersects(m_reads, other.m_writes);
+}
+
+void SystemAccess::prepareStorage(entt::registry& registry) const {
+    for (StorageFunction assure : m_storages) {
+        assure(registry);
+    }
+}
+
+// ========== SystemScheduler ==========
+
+void SystemScheduler::addSystem(const std::string& name, const SystemAccess& access, SystemFunction function) {
+    Node node;
+    node.name = name;
+    node.access = access;
+    node.function = std::move(function);
+    m_nodes.push_back(std::move(node));
+    m_built = false;
+}
+
+void SystemScheduler::addSyncPoint(const std::string& name, SyncFunction function) {
+    Node node;
+    node.name = name;
+    node.sync = std::move(function);
+    node.syncPoint = true;
+    m_nodes.push_back(std::move(node));
+    m_built = false;
+}
+
+void SystemScheduler::build(Registry& registry) {
+    m_stages.clear();
+    m_stats = SchedulerStats{};
+    m_registry = &registry;
+
+    for (auto& node : m_nodes) {
+        node.dependents.clear();
+        node.dependencyCount = 0;
+        node.access.prepareStorage(registry.raw());
+    }
+
+    // 同步点、独占系统各自成一个阶段，其余连续的系统归入同一阶段
+    size_t begin = 0;
+    auto closeStage = [this, &begin](size_t end) {
+        if (end > begin) {
+            m_stages.push_back({begin, end, end - begin > 1});
+        }
+        begin = end;
+    };
+
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        const Node& node = m_nodes[i];
+        if (!node.syncPoint) ++m_stats.systems;
+        if (node.syncPoint || node.access.isExclusive()) {
+            closeStage(i);
+            closeStage(i + 1);
+            continue;
+        }
+
+        // 后注册的系统依赖同阶段内所有与它冲突的先注册系统
+        for (size_t j = begin; j < i; ++j) {
+            if (m_nodes[j].access.conflictsWith(node.access)) {
+                m_nodes[j].dependents.push_back(i);
+                ++m_nodes[i].dependencyCount;
+                ++m_stats.dependencies;
+            }
+        }
+    }
+    closeStage(m_nodes.size());
+
+    m_stats.stages = m_stages.size();
+    for (const Stage& stage : m_stages) {
+        // 阶段内全是链式依赖时实际不会并发
+        size_t roots = 0;
+        for (size_t i = stage.begin; i < stage.end; ++i) {
+            if (m_nodes[i].dependencyCount == 0) ++roots;
+        }
+        if (stage.parallel && roots > 1) ++m_stats.parallelStages;
+    }
+
+    m_timings.assign(m_nodes.size(), SystemTiming{});
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        m_timings[i].name = m_nodes[i].name;
+    }
+    m_remaining = std::make_unique<std::atomic<int>[]>(m_nodes.size());
+    m_built = true;
+
+    NF_INFO("System scheduler built: {} systems, {} stages ({} parallel), {} dependencies",
+            m_stats.systems, m_stats.stages, m_stats.parallelStages, m_stats.dependencies);
+}
+
+void SystemScheduler::run(float deltaTime) {
+    if (!m_built) {
+        NF_WARN("System scheduler run before build");
+        return;
+    }
+
+    const auto start = Clock::now();
+    m_deltaTime = deltaTime;
+
+    m_stats.flushes = 0;
+    for (const Stage& stage : m_stages) {
+        runStage(stage);
+
+        // 同步点：本阶段记录的结构性修改对后续阶段可见
+        if (m_registry->hasPendingCommands()) {
+            m_registry->flushCommands();
+            ++m_stats.flushes;
+        }
+    }
+
+    m_stats.tickMs = elapsedMs(start);
+    m_stats.systemMs = 0.f;
+    for (const SystemTiming& timing : m_timings) {
+        m_stats.systemMs += timing.milliseconds;
+    }
+}
+
+void SystemScheduler::runStage(const Stage& stage) {
+    if (!stage.parallel || !m_jobSystem || m_jobSystem->getWorkerCount() == 0) {
+        // 注册顺序本身就是合法的拓扑序
+        for (size_t i = stage.begin; i < stage.end; ++i) {
+            runNode(i);
+        }
+        return;
+    }
+
+    // 每个系统任务完成后计数减 1；后继系统在前驱的任务里提交，计数不会提前归零
+    m_unfinished.store(static_cast<int>(stage.end - stage.begin), std::memory_order_relaxed);
+    for (size_t i = stage.begin; i < stage.end; ++i) {
+        m_remaining[i].store(m_nodes[i].dependencyCount, std::memory_order_relaxed);
+    }
+    for (size_t i = stage.begin; i < stage.end; ++i) {
+        if (m_nodes[i].dependencyCount == 0) {
+            submitNode(i);
+        }
+    }
+
+    // 主线程也执行系统任务，直到整个阶段完成
+    m_jobSystem->wait(m_unfinished);
+}
+
+void SystemScheduler::runNode(size_t index) {
+    const Node& node = m_nodes[index];
+    const auto start = Clock::now();
+    if (node.syncPoint) {
+        if (node.sync) node.sync();
+    } else {
+        node.function(m_deltaTime);
+    }
+    m_timings[index].milliseconds = elapsedMs(start);
+}
+
+void SystemScheduler::submitNode(size_t index) {
+    m_jobSystem->submit(Job{&SystemScheduler::nodeJob, this, index, 0, &m_unfinished});
+}
+
+void SystemScheduler::nodeJob(void* context, size_t index, size_t) {
+    auto* scheduler = static_cast<SystemScheduler*>(context);
+    scheduler->runNode(index);
+
+    for (size_t dependent : scheduler->m_nodes[index].dependents) {
+        if (scheduler->m_remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            scheduler->submitNode(dependent);
+        }
+    }
+}
+
+} // namespace Nightfall
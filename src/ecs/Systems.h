@@ -1 +1,184 @@
-﻿
\ No newline at end of file
+﻿#pragma once
+
+#include "Registry.h"
+#include "../core/JobSystem.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Nightfall {
+
+/**
+ * @brief 系统的访问声明：读哪些组件、写哪些组件，以及用到的共享资源（其他系统对象、服务）
+ *
+ * 两个系统只要有一方写了另一方读或写的对象就视为冲突，调度器按注册顺序给它们连一条依赖边。
+ * 非独占系统创建 / 销毁实体、或增删未声明为写入的组件时，必须记录到 Registry::commands()，
+ * 在阶段结束时统一回放；需要立即看到修改结果的系统声明 exclusive：
+ * 它独占一个阶段，在主线程上执行，可以直接修改注册表，前后的系统都要等它。
+ *
+ * 用法：SystemAccess().read<Transform, Hostile>().write<Velocity>().writeResource<CrowdSystem>()
+ */
+class SystemAccess {
+public:
+    template<typename... Components>
+    SystemAccess& read() {
+        (addComponent<Components>(m_reads), ...);
+        return *this;
+    }
+
+    template<typename... Components>
+    SystemAccess& write() {
+        (addComponent<Components>(m_writes), ...);
+        return *this;
+    }
+
+    /// 非组件的共享对象（系统、服务），按类型区分
+    template<typename... Resources>
+    SystemAccess& readResource() {
+        (m_reads.push_back(entt::type_hash<Resources>::value()), ...);
+        return *this;
+    }
+
+    template<typename... Resources>
+    SystemAccess& writeResource() {
+        (m_writes.push_back(entt::type_hash<Resources>::value()), ...);
+        return *this;
+    }
+
+    /// 结构性修改：独占执行
+    SystemAccess& exclusive() {
+        m_exclusive = true;
+        return *this;
+    }
+
+    bool isExclusive() const { return m_exclusive; }
+
+    /// 是否必须与 other 串行执行
+    bool conflictsWith(const SystemAccess& other) const;
+
+    /// 预先创建声明过的组件存储（并行阶段里首次访问存储会修改注册表，不是线程安全的）
+    void prepareStorage(entt::registry& registry) const;
+
+private:
+    using StorageFunction = void (*)(entt::registry&);
+
+    template<typename Component>
+    static void assureStorage(entt::registry& registry) {
+        registry.storage<Component>();
+    }
+
+    template<typename Component>
+    void addComponent(std::vector<entt::id_type>& ids) {
+        ids.push_back(entt::type_hash<Component>::value());
+        m_storages.push_back(&assureStorage<Component>);
+    }
+
+    std::vector<entt::id_type> m_reads;
+    std::vector<entt::id_type> m_writes;
+    std::vector<StorageFunction> m_storages;
+    bool m_exclusive{false};
+};
+
+/// 单个系统上一逻辑帧的耗时
+struct SystemTiming {
+    std::string name;
+    float milliseconds{0.f};
+};
+
+/// 调度统计（每次 run 更新）
+struct SchedulerStats {
+    size_t systems{0};
+    size_t stages{0};             // 阶段数（同步点、独占系统把系统表分成若干阶段）
+    size_t parallelStages{0};     // 含两个以上可并发系统的阶段
+    size_t dependencies{0};       // 阶段内的依赖边
+    size_t flushes{0};            // 本帧回放命令缓冲的次数
+    float tickMs{0.f};            // 本帧调度总耗时
+    float systemMs{0.f};          // 各系统耗时之和（单线程执行的估计耗时）
+};
+
+/**
+ * @brief 系统调度器 - 按声明的组件访问构建依赖图，在任务系统上并发执行互不冲突的系统
+ *
+ * - 系统按注册顺序排列，注册顺序就是单线程时的执行顺序
+ * - 同一阶段内，后注册的系统依赖所有与它冲突的先注册系统；无依赖的系统同时执行
+ * - 同步点把系统表切成阶段：之前的系统全部完成后在主线程执行回调（如寻路服务的 sync），再开始下一阶段
+ * - 独占系统自成一个阶段，在主线程上执行
+ * - 每个阶段结束后在主线程回放各线程记录的命令缓冲
+ *
+ * 系统作为任务提交给任务系统，系统内部还可以用 Registry::parallel_each 继续拆分，
+ * 等待的线程会帮忙执行。addSystem / addSyncPoint 之后调用 build 建图；
+ * 未设置任务系统或没有工作线程时，所有系统在主线程按注册顺序执行。
+ */
+class SystemScheduler {
+public:
+    using SystemFunction = std::function<void(float)>;
+    using SyncFunction = std::function<void()>;
+
+    SystemScheduler() = default;
+    ~SystemScheduler() = default;
+
+    void setJobSystem(JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+
+    void addSystem(const std::string& name, const SystemAccess& access, SystemFunction function);
+
+    /// 同步点：之前的系统全部完成后在主线程执行 function（可为空，只作屏障）
+    void addSyncPoint(const std::string& name, SyncFunction function = {});
+
+    /// 划分阶段、连依赖边，并预先创建声明过的组件存储（run 时回放这个注册表的命令缓冲）
+    void build(Registry& registry);
+
+    /// 推进一个逻辑帧（只能在主线程调用）
+    void run(float deltaTime);
+
+    const SchedulerStats& getStats() const { return m_stats; }
+    const std::vector<SystemTiming>& getTimings() const { return m_timings; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Node {
+        std::string name;
+        SystemAccess access;
+        SystemFunction function;
+        SyncFunction sync;                 // 同步点回调（同步点节点没有 function）
+        bool syncPoint{false};
+        std::vector<size_t> dependents;    // 阶段内依赖本系统的系统
+        int dependencyCount{0};
+    };
+
+    /// 一段连续的节点 [begin, end)
+    struct Stage {
+        size_t begin{0};
+        size_t end{0};
+        bool parallel{false};
+    };
+
+    void runStage(const Stage& stage);
+    void runNode(size_t index);
+    void submitNode(size_t index);
+
+    /// 任务入口：执行一个系统，再提交依赖已全部完成的后继系统
+    static void nodeJob(void* context, size_t index, size_t);
+
+    JobSystem* m_jobSystem{nullptr};
+    Registry* m_registry{nullptr};
+
+    std::vector<Node> m_nodes;
+    std::vector<Stage> m_stages;
+    bool m_built{false};
+
+    float m_deltaTime{0.f};
+
+    // 当前阶段的执行状态
+    std::unique_ptr<std::atomic<int>[]> m_remaining;   // 各系统尚未完成的依赖数
+    std::atomic<int> m_unfinished{0};                  // 本阶段尚未完成的系统数
+
+    std::vector<SystemTiming> m_timings;   // 与 m_nodes 对应（同步点的耗时为回调耗时）
+    SchedulerStats m_stats;
+};
+
+} // namespace Nightfall
@@ -23,7 +23,14 @@ int main() {
         int height = Nightfall::Config::getInt("window.height", 720);
         
         Nightfall::Application app(title, width, height);
-        app.run();
+        
+        // headless_ticks > 0：不渲染，直接推进固定数量的逻辑帧（性能测试、自动化运行）
+        int headlessTicks = Nightfall::Config::getInt("simulation.headless_ticks", 0);
+        if (headlessTicks > 0) {
+            app.runHeadless(headlessTicks);
+        } else {
+            app.run();
+        }
         
         // 保存配置
         Nightfall::Config::save();
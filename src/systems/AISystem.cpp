@@ -1,11 +1,36 @@
 ﻿#include "AISystem.h"
 #include "CombatSystem.h"
+#include "PhysicsSystem.h"
+#include "../ai/Pathfinding.h"
+#include "../ai/PathService.h"
+#include "../ai/NPCController.h"
 #include "../ecs/Components.h"
 #include "../core/Logger.h"
+#include "../utils/Config.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <utility>
 
 namespace Nightfall {
 
+namespace {
+
+/// NPC 职业对应的行为树原型名（behaviors.json 的 archetypes）
+const char* getProfessionArchetype(NPC::Profession profession) {
+    switch (profession) {
+        case NPC::Profession::Farmer:    return "farmer";
+        case NPC::Profession::Builder:   return "builder";
+        case NPC::Profession::Soldier:   return "soldier";
+        case NPC::Profession::Doctor:    return "doctor";
+        case NPC::Profession::Scientist: return "scientist";
+        case NPC::Profession::Engineer:  return "engineer";
+        default:                         return "default";
+    }
+}
+
+} // namespace
+
 AISystem::AISystem() {
 }
 
@@ -13,13 +38,60 @@ AISystem::~AISystem() {
     NF_INFO("AI system shutdown");
 }
 
-void AISystem::init() {
+void AISystem::init(Registry& registry) {
+    m_random = Random::createStream(RandomStreamId::AI);
+    registerBehaviorLeaves();
+    m_behaviorTrees.loadFromFile(Config::getString("ai.behavior_trees", "assets/data/behaviors.json"));
+    m_behaviorTrees.init(registry);
+    
+    // 僵尸死亡或回收进实体池时放弃未取回的寻路请求
+    registry.raw().on_destroy<PathFollow>().connect<&AISystem::onPathFollowDestroyed>(*this);
+    
     NF_INFO("AI system initialized");
 }
 
+void AISystem::onPathFollowDestroyed(entt::registry& registry, entt::entity entity) {
+    if (m_pathService) {
+        m_pathService->release(registry.get<PathFollow>(entity).handle);
+    }
+}
+
+void AISystem::setLodSettings(float nearDistance, float midDistance, int midInterval, int farInterval) {
+    m_lodNearDistance = nearDistance;
+    m_lodMidDistance = std::max(nearDistance, midDistance);
+    m_lodIntervals[static_cast<size_t>(AILodTier::Mid)] = static_cast<std::uint32_t>(std::max(1, midInterval));
+    m_lodIntervals[static_cast<size_t>(AILodTier::Far)] = static_cast<std::uint32_t>(std::max(1, farInterval));
+}
+
 void AISystem::update(float deltaTime, Registry& registry, entt::entity player) {
+    collectBlockingBuildings(registry);
     updateZombieAI(deltaTime, registry, player);
-    updateNPCAI(deltaTime, registry);
+    updateNPCAI(deltaTime, registry, player);
+}
+
+void AISystem::collectBlockingBuildings(Registry& registry) {
+    m_blockingBuildings.clear();
+    if (!m_physicsSystem) return;
+    
+    // 物理系统在每次更新后批量发布接触事件，仍在接触的配对每次都会以 Begin/Persist 出现，
+    // 因此每帧重建一次即可，不需要处理 End。AI 在物理之前运行，读到的是上一个 tick 的接触
+    using Phase = PhysicsSystem::ContactEvent::Phase;
+    for (const auto& contact : m_physicsSystem->getContactEvents()) {
+        if (contact.isTrigger || contact.phase == Phase::End) continue;
+        if (!registry.isValid(contact.a) || !registry.isValid(contact.b)) continue;
+        
+        entt::entity zombie = contact.a;
+        entt::entity other = contact.b;
+        if (!registry.hasComponent<Zombie>(zombie)) {
+            std::swap(zombie, other);
+            if (!registry.hasComponent<Zombie>(zombie)) continue;
+        }
+        
+        const auto* building = registry.tryGetComponent<Building>(other);
+        if (building && building->isComplete) {
+            m_blockingBuildings[zombie] = other;
+        }
+    }
 }
 
 void AISystem::updateZombieAI(float deltaTime, Registry& registry, entt::entity player) {
@@ -28,147 +100,396 @@ void AISystem::updateZombieAI(float deltaTime, Registry& registry, entt::entity
     auto* playerTransform = registry.tryGetComponent<Transform>(player);
     if (!playerTransform) return;
     
-    // 更新所有僵尸AI
-    auto view = registry.view<Transform, AI, Zombie, Hostile>();
+    // 玩家所在格子变化时重算流场（与僵尸数量无关），否则只修复被建筑改动的区域
+    if (m_pathfinder) {
+        m_attractors.clear();
+        m_attractors.push_back(playerTransform->position);
+        m_pathfinder->update(registry, m_attractors);
+    }
+    
+    const auto updateStart = std::chrono::steady_clock::now();
+    ++m_tick;
+    m_lodStats = AILodStats{};
+    
+    // 补上缺少状态标签的僵尸（新生成的实体）
+    syncStateTags(registry, playerTransform->position);
+    
+    // 每个状态一个紧凑的循环，状态切换先记下来，全部循环结束后统一换标签
+    const sf::Vector2f playerPosition = playerTransform->position;
+    updateIdle(deltaTime, registry, playerPosition);
+    updatePatrol(deltaTime, registry, playerPosition);
+    updateChase(deltaTime, registry, player, playerPosition);
+    updateAttack(deltaTime, registry, playerPosition);
+    updateFlee(deltaTime, registry, playerPosition);
+    applyTransitions(registry);
+    
+    m_lodStats.updateMs =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
+}
+
+void AISystem::syncStateTags(Registry& registry, const sf::Vector2f& playerPosition) {
+    m_untagged.clear();
+    auto view = registry.view<AI, Zombie, Hostile>(
+        entt::exclude<IdleState, PatrolState, ChaseState, AttackState, FleeState>);
     for (auto entity : view) {
-        auto& transform = view.get<Transform>(entity);
+        if (view.get<AI>(entity).state != AIState::Dead) {
+            m_untagged.push_back(entity);
+        }
+    }
+    
+    for (auto entity : m_untagged) {
+        setStateTag(registry, entity, registry.getComponent<AI>(entity).state);
+        
+        // 新生成（或从池中复用）的僵尸在营地（玩家当前位置）和出生点之间巡逻，路径向寻路服务请求
+        const auto* transform = registry.tryGetComponent<Transform>(entity);
+        if (transform && !registry.hasComponent<Patrol>(entity)) {
+            auto& patrol = registry.addComponent<Patrol>(entity);
+            patrol.waypoints = {playerPosition, transform->position};
+        }
+    }
+}
+
+void AISystem::setStateTag(Registry& registry, entt::entity entity, AIState state) {
+    registry.raw().remove<IdleState, PatrolState, ChaseState, AttackState, FleeState>(entity);
+    
+    switch (state) {
+        case AIState::Idle:   registry.addComponent<IdleState>(entity); break;
+        case AIState::Patrol: registry.addComponent<PatrolState>(entity); break;
+        case AIState::Chase:  registry.addComponent<ChaseState>(entity); break;
+        case AIState::Attack: registry.addComponent<AttackState>(entity); break;
+        case AIState::Flee:   registry.addComponent<FleeState>(entity); break;
+        case AIState::Dead:   break;
+    }
+}
+
+void AISystem::requestTransition(entt::entity entity, AIState state, entt::entity target) {
+    m_transitions.push_back({entity, state, target});
+}
+
+void AISystem::applyTransitions(Registry& registry) {
+    for (const auto& transition : m_transitions) {
+        auto* ai = registry.tryGetComponent<AI>(transition.entity);
+        if (!ai) continue;
+        
+        ai->state = transition.state;
+        ai->target = transition.target;
+        ai->stateTimer = 0.f;
+        setStateTag(registry, transition.entity, transition.state);
+    }
+    m_transitions.clear();
+}
+
+bool AISystem::beginAgentUpdate(entt::entity entity, AI& ai, const sf::Vector2f& position, float distSq,
+                                float deltaTime) {
+    // LOD：降频的档位只在轮到自己的桶时更新，并一次补上跳过的时间（速度保持上次的值）
+    ai.lodTier = classifyLod(position, distSq);
+    const size_t tier = static_cast<size_t>(ai.lodTier);
+    ++m_lodStats.agents[tier];
+    
+    ai.lodDeltaTime += deltaTime;
+    const std::uint32_t interval = m_lodIntervals[tier];
+    if (interval > 1 && (entt::to_entity(entity) + m_tick) % interval != 0) return false;
+    ++m_lodStats.updated[tier];
+    
+    // 更新AI计时器
+    ai.stateTimer += ai.lodDeltaTime;
+    ai.lodDeltaTime = 0.f;
+    return true;
+}
+
+void AISystem::updateIdle(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition) {
+    auto view = registry.view<Transform, AI, IdleState>();
+    for (auto entity : view) {
+        const auto& transform = view.get<Transform>(entity);
         auto& ai = view.get<AI>(entity);
-        auto& zombie = view.get<Zombie>(entity);
-        
-        // 更新AI计时器
-        ai.stateTimer += deltaTime;
-        
-        // 计算与玩家的距离
-        float distSq = getDistanceSquared(transform.position, playerTransform->position);
-        float detectionRange = ai.detectionRange * ai.detectionRange;
-        float attackRange = ai.attackRange * ai.attackRange;
-        
-        // 检查附近是否有建筑物阻挡
-        entt::entity nearestBuilding = findNearestBuilding(transform.position, registry, 100.f);
-        bool hasBlockingBuilding = (nearestBuilding != entt::null);
-        
-        // 状态机
-        switch (ai.state) {
-            case AIState::Idle:
-                // 如果玩家进入检测范围，切换到追击
-                if (distSq < detectionRange) {
-                    ai.state = AIState::Chase;
-                    ai.stateTimer = 0.f;
-                } else if (ai.stateTimer > 3.f) {
-                    // 闲置太久，开始巡逻
-                    ai.state = AIState::Patrol;
-                    ai.stateTimer = 0.f;
-                }
-                break;
-                
-            case AIState::Patrol:
-                patrol(entity, registry);
-                // 如果玩家进入检测范围，切换到追击
-                if (distSq < detectionRange) {
-                    ai.state = AIState::Chase;
-                    ai.stateTimer = 0.f;
-                }
-                break;
-                
-            case AIState::Chase:
-                // 追击玩家
-                if (distSq < attackRange) {
-                    // 进入攻击范围
-                    ai.state = AIState::Attack;
-                    ai.target = player;
-                    ai.stateTimer = 0.f;
-                } else if (hasBlockingBuilding && distSq > 150.f * 150.f) {
-                    // 有建筑物阻挡且玩家较远，转为攻击建筑
-                    ai.state = AIState::Attack;
-                    ai.target = nearestBuilding;
-                    ai.stateTimer = 0.f;
-                } else if (distSq > detectionRange * 1.5f) {
-                    // 玩家逃出范围，回到闲置
-                    ai.state = AIState::Idle;
-                    ai.target = entt::null;
-                    ai.stateTimer = 0.f;
-                    // 停止移动
-                    if (auto* velocity = registry.tryGetComponent<Velocity>(entity)) {
-                        velocity->velocity = sf::Vector2f(0.f, 0.f);
-                    }
-                } else {
-                    // 继续追击
-                    chaseTarget(entity, playerTransform->position, registry);
-                }
-                break;
-                
-            case AIState::Attack: {
-                // 攻击状态
-                if (!registry.isValid(ai.target)) {
-                    // 目标消失，返回追击状态
-                    ai.state = AIState::Chase;
-                    ai.target = entt::null;
-                    ai.stateTimer = 0.f;
-                    break;
-                }
-                
-                // 计算与目标的距离
-                auto* targetTransform = registry.tryGetComponent<Transform>(ai.target);
-                if (!targetTransform) {
-                    ai.state = AIState::Chase;
-                    ai.target = entt::null;
-                    break;
-                }
-                
-                float targetDistSq = getDistanceSquared(transform.position, targetTransform->position);
-                
-                if (targetDistSq > attackRange * 1.5f) {
-                    // 目标离开攻击范围，继续追击
-                    if (ai.target == player) {
-                        ai.state = AIState::Chase;
-                        ai.target = entt::null;
-                    } else {
-                        // 建筑被摧毁或离开，返回追击玩家
-                        ai.state = AIState::Chase;
-                        ai.target = entt::null;
-                    }
-                    ai.stateTimer = 0.f;
-                } else {
-                    // 执行攻击
-                    if (ai.stateTimer >= ai.attackCooldown) {
-                        attackTarget(entity, ai.target, registry);
-                        ai.stateTimer = 0.f;
-                    }
-                    // 攻击时停止移动
-                    if (auto* velocity = registry.tryGetComponent<Velocity>(entity)) {
-                        velocity->velocity = sf::Vector2f(0.f, 0.f);
-                    }
-                }
-                break;
-            }
-                
-            case AIState::Flee:
-                // 逃跑（未实现）
-                break;
+        
+        const float distSq = getDistanceSquared(transform.position, playerPosition);
+        if (!beginAgentUpdate(entity, ai, transform.position, distSq, deltaTime)) continue;
+        
+        if (distSq < ai.detectionRange * ai.detectionRange) {
+            // 玩家进入检测范围，切换到追击
+            requestTransition(entity, AIState::Chase);
+        } else if (ai.stateTimer > 3.f) {
+            // 闲置太久，开始巡逻
+            requestTransition(entity, AIState::Patrol);
         }
     }
 }
 
-void AISystem::updateNPCAI(float deltaTime, Registry& registry) {
-    // TODO: 实现友好NPC的AI
-    // 例如：
-    // - 自动采集资源
-    // - 自动建造
-    // - 跟随玩家等
+void AISystem::updatePatrol(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition) {
+    auto view = registry.view<Transform, AI, PatrolState>();
+    for (auto entity : view) {
+        const auto& transform = view.get<Transform>(entity);
+        auto& ai = view.get<AI>(entity);
+        
+        const float distSq = getDistanceSquared(transform.position, playerPosition);
+        if (!beginAgentUpdate(entity, ai, transform.position, distSq, deltaTime)) continue;
+        
+        patrol(entity, registry);
+        // 如果玩家进入检测范围，切换到追击
+        if (distSq < ai.detectionRange * ai.detectionRange) {
+            requestTransition(entity, AIState::Chase);
+        }
+    }
 }
 
-void AISystem::chaseTarget(entt::entity entity, const sf::Vector2f& targetPos, Registry& registry) {
-    auto* transform = registry.tryGetComponent<Transform>(entity);
-    auto* velocity = registry.tryGetComponent<Velocity>(entity);
-    auto* ai = registry.tryGetComponent<AI>(entity);
+void AISystem::updateChase(float deltaTime, Registry& registry, entt::entity player,
+                           const sf::Vector2f& playerPosition) {
+    m_chaseEntities.clear();
+    m_chaseX.clear();
+    m_chaseY.clear();
+    m_chaseTargetX.clear();
+    m_chaseTargetY.clear();
+    m_chaseSpeed.clear();
     
-    if (!transform || !velocity || !ai) return;
+    // 第一遍：状态判定，继续追击的僵尸把位置、目标点、速度收集成连续数组
+    auto view = registry.view<Transform, AI, Velocity, ChaseState>();
+    for (auto entity : view) {
+        const auto& transform = view.get<Transform>(entity);
+        auto& ai = view.get<AI>(entity);
+        
+        const float distSq = getDistanceSquared(transform.position, playerPosition);
+        if (!beginAgentUpdate(entity, ai, transform.position, distSq, deltaTime)) continue;
+        
+        const float detectionRange = ai.detectionRange * ai.detectionRange;
+        if (distSq < ai.attackRange * ai.attackRange) {
+            // 进入攻击范围
+            requestTransition(entity, AIState::Attack, player);
+            continue;
+        }
+        
+        // 检查是否正顶着建筑物（来自物理接触，而不是每帧做范围查询）
+        auto blocking = m_blockingBuildings.find(entity);
+        if (blocking != m_blockingBuildings.end() && distSq > 150.f * 150.f) {
+            // 有建筑物阻挡且玩家较远，转为攻击建筑
+            requestTransition(entity, AIState::Attack, blocking->second);
+            continue;
+        }
+        
+        if (distSq > detectionRange * 1.5f) {
+            // 玩家逃出范围，回到闲置并停止移动
+            requestTransition(entity, AIState::Idle);
+            view.get<Velocity>(entity).velocity = sf::Vector2f(0.f, 0.f);
+            continue;
+        }
+        
+        // 目标点：流场的下一格中心（绕开建筑）；在目标格子或不可达时直接朝向玩家
+        // （被围住时会顶到墙上转为攻击建筑）
+        sf::Vector2f waypoint;
+        if (!m_pathfinder || !m_pathfinder->sampleWaypoint(transform.position, waypoint)) {
+            waypoint = playerPosition;
+        }
+        
+        m_chaseEntities.push_back(entity);
+        m_chaseX.push_back(transform.position.x);
+        m_chaseY.push_back(transform.position.y);
+        m_chaseTargetX.push_back(waypoint.x);
+        m_chaseTargetY.push_back(waypoint.y);
+        m_chaseSpeed.push_back(ai.moveSpeed);
+    }
     
-    // 计算朝向目标的方向
-    sf::Vector2f direction = getNormalizedDirection(transform->position, targetPos);
+    // 第二遍：无分支的 SoA 循环（编译器可自动向量化），朝目标点的单位方向乘以速度，结果写回目标点数组
+    // 加上极小的平方长度避免除零：目标点与位置重合时分子为 0，速度也为 0
+    const size_t count = m_chaseEntities.size();
+    const float* x = m_chaseX.data();
+    const float* y = m_chaseY.data();
+    const float* speed = m_chaseSpeed.data();
+    float* outX = m_chaseTargetX.data();
+    float* outY = m_chaseTargetY.data();
+    for (size_t i = 0; i < count; ++i) {
+        const float dx = outX[i] - x[i];
+        const float dy = outY[i] - y[i];
+        const float scale = speed[i] / std::sqrt(dx * dx + dy * dy + 1e-12f);
+        outX[i] = dx * scale;
+        outY[i] = dy * scale;
+    }
     
-    // 设置速度
-    velocity->velocity = direction * ai->moveSpeed;
+    // 第三遍：写回速度
+    for (size_t i = 0; i < count; ++i) {
+        view.get<Velocity>(m_chaseEntities[i]).velocity = sf::Vector2f(outX[i], outY[i]);
+    }
+}
+
+void AISystem::updateAttack(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition) {
+    auto view = registry.view<Transform, AI, AttackState>();
+    for (auto entity : view) {
+        const auto& transform = view.get<Transform>(entity);
+        auto& ai = view.get<AI>(entity);
+        
+        const float distSq = getDistanceSquared(transform.position, playerPosition);
+        if (!beginAgentUpdate(entity, ai, transform.position, distSq, deltaTime)) continue;
+        
+        // 目标消失，返回追击状态
+        auto* targetTransform = registry.isValid(ai.target)
+            ? registry.tryGetComponent<Transform>(ai.target) : nullptr;
+        if (!targetTransform) {
+            requestTransition(entity, AIState::Chase);
+            continue;
+        }
+        
+        const float attackRange = ai.attackRange * ai.attackRange;
+        if (getDistanceSquared(transform.position, targetTransform->position) > attackRange * 1.5f) {
+            // 目标离开攻击范围（或建筑被摧毁），继续追击玩家
+            requestTransition(entity, AIState::Chase);
+            continue;
+        }
+        
+        // 执行攻击
+        if (ai.stateTimer >= ai.attackCooldown) {
+            attackTarget(entity, ai.target, registry);
+            ai.stateTimer = 0.f;
+        }
+        // 攻击时停止移动
+        if (auto* velocity = registry.tryGetComponent<Velocity>(entity)) {
+            velocity->velocity = sf::Vector2f(0.f, 0.f);
+        }
+    }
+}
+
+void AISystem::updateFlee(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition) {
+    // 逃跑行为尚未实现，只推进计时与 LOD 统计
+    auto view = registry.view<Transform, AI, FleeState>();
+    for (auto entity : view) {
+        const auto& transform = view.get<Transform>(entity);
+        auto& ai = view.get<AI>(entity);
+        beginAgentUpdate(entity, ai, transform.position, getDistanceSquared(transform.position, playerPosition),
+                         deltaTime);
+    }
+}
+
+AILodTier AISystem::classifyLod(const sf::Vector2f& position, float distanceSquaredToPlayer) const {
+    if (distanceSquaredToPlayer < m_lodNearDistance * m_lodNearDistance || m_cameraView.contains(position)) {
+        return AILodTier::Near;
+    }
+    if (distanceSquaredToPlayer < m_lodMidDistance * m_lodMidDistance) {
+        return AILodTier::Mid;
+    }
+    return AILodTier::Far;
+}
+
+void AISystem::updateNPCAI(float deltaTime, Registry& registry, entt::entity player) {
+    if (auto* transform = registry.tryGetComponent<Transform>(player)) {
+        m_playerPosition = transform->position;
+    }
+    
+    // 新出现（或行军结束）的 NPC 按职业挂上行为树
+    auto view = registry.view<NPC, Transform, Velocity>(entt::exclude<BehaviorAgent, SquadMember>);
+    m_newAgents.assign(view.begin(), view.end());
+    for (auto entity : m_newAgents) {
+        const int tree = m_behaviorTrees.findArchetype(getProfessionArchetype(view.get<NPC>(entity).profession));
+        if (tree >= 0) {
+            m_behaviorTrees.attach(registry, entity, tree);
+        }
+    }
+    
+    m_behaviorTrees.tick(registry, deltaTime);
+}
+
+void AISystem::registerBehaviorLeaves() {
+    // 停下，总是成功
+    m_behaviorTrees.registerLeaf("stop", [](BehaviorBatch& batch) {
+        for (size_t i = 0; i < batch.count; ++i) {
+            if (auto* velocity = batch.registry.tryGetComponent<Velocity>(batch.entities[i])) {
+                velocity->velocity = {0.f, 0.f};
+            }
+            batch.results[i] = BehaviorStatus::Success;
+        }
+    });
+    
+    // 随机方向慢走 value 秒（剩余时间放在 slot 里）
+    m_behaviorTrees.registerLeaf("wander", [this](BehaviorBatch& batch) {
+        const int slot = batch.node.slot;
+        for (size_t i = 0; i < batch.count; ++i) {
+            auto* velocity = batch.registry.tryGetComponent<Velocity>(batch.entities[i]);
+            if (!velocity) {
+                batch.results[i] = BehaviorStatus::Failure;
+                continue;
+            }
+            
+            float& remaining = batch.blackboards[i][slot];
+            if (remaining <= 0.f) {
+                float angle = m_random.angle();
+                velocity->velocity = sf::Vector2f(std::cos(angle), std::sin(angle)) * (velocity->maxSpeed * 0.5f);
+                remaining = batch.node.value;
+            }
+            
+            remaining -= batch.deltaTime;
+            if (remaining <= 0.f) {
+                remaining = 0.f;
+                batch.results[i] = BehaviorStatus::Success;
+            } else {
+                batch.results[i] = BehaviorStatus::Running;
+            }
+        }
+    }, true);
+    
+    // 走向玩家，进入 value 范围内成功
+    m_behaviorTrees.registerLeaf("follow_player", [this](BehaviorBatch& batch) {
+        const float arriveDistSq = batch.node.value * batch.node.value;
+        for (size_t i = 0; i < batch.count; ++i) {
+            auto* transform = batch.registry.tryGetComponent<Transform>(batch.entities[i]);
+            auto* velocity = batch.registry.tryGetComponent<Velocity>(batch.entities[i]);
+            if (!transform || !velocity) {
+                batch.results[i] = BehaviorStatus::Failure;
+                continue;
+            }
+            
+            if (getDistanceSquared(transform->position, m_playerPosition) <= arriveDistSq) {
+                velocity->velocity = {0.f, 0.f};
+                batch.results[i] = BehaviorStatus::Success;
+            } else {
+                velocity->velocity = getNormalizedDirection(transform->position, m_playerPosition) * velocity->maxSpeed;
+                batch.results[i] = BehaviorStatus::Running;
+            }
+        }
+    });
+    
+    // 条件：离玩家超过 value
+    m_behaviorTrees.registerLeaf("is_player_far", [this](BehaviorBatch& batch) {
+        const float farDistSq = batch.node.value * batch.node.value;
+        for (size_t i = 0; i < batch.count; ++i) {
+            auto* transform = batch.registry.tryGetComponent<Transform>(batch.entities[i]);
+            batch.results[i] = transform && getDistanceSquared(transform->position, m_playerPosition) > farDistSq
+                ? BehaviorStatus::Success
+                : BehaviorStatus::Failure;
+        }
+    });
+    
+    // 条件：任务板给这个 NPC 分配了工作
+    m_behaviorTrees.registerLeaf("has_job", [](BehaviorBatch& batch) {
+        for (size_t i = 0; i < batch.count; ++i) {
+            auto* worker = batch.registry.tryGetComponent<Worker>(batch.entities[i]);
+            batch.results[i] = worker && worker->job != entt::null ? BehaviorStatus::Success : BehaviorStatus::Failure;
+        }
+    });
+    
+    // 走向并完成分配的工作
+    m_behaviorTrees.registerLeaf("work_job", [this](BehaviorBatch& batch) {
+        if (m_npcController) {
+            m_npcController->work(batch);
+        } else {
+            std::fill_n(batch.results, batch.count, BehaviorStatus::Failure);
+        }
+    });
+    
+    // 回营地吃饭，饱食度回满
+    m_behaviorTrees.registerLeaf("eat", [this](BehaviorBatch& batch) {
+        if (m_npcController) {
+            m_npcController->eat(batch);
+        } else {
+            std::fill_n(batch.results, batch.count, BehaviorStatus::Failure);
+        }
+    });
+    
+    // 条件：饱食度比例低于 value
+    m_behaviorTrees.registerLeaf("is_hungry", [](BehaviorBatch& batch) {
+        for (size_t i = 0; i < batch.count; ++i) {
+            auto* hunger = batch.registry.tryGetComponent<Hunger>(batch.entities[i]);
+            batch.results[i] = hunger && hunger->getPercentage() < batch.node.value
+                ? BehaviorStatus::Success
+                : BehaviorStatus::Failure;
+        }
+    });
 }
 
 void AISystem::patrol(entt::entity entity, Registry& registry) {
@@ -183,7 +504,7 @@ void AISystem::patrol(entt::entity entity, Registry& registry) {
         // 没有巡逻点，随机游荡
         if (ai->stateTimer > 2.f) {
             // 每2秒改变方向
-            float angle = static_cast<float>(rand()) / RAND_MAX * 2.f * 3.14159f;
+            float angle = m_random.angle();
             velocity->velocity = sf::Vector2f(std::cos(angle), std::sin(angle)) * (ai->moveSpeed * 0.5f);
             ai->stateTimer = 0.f;
         }
@@ -200,8 +521,8 @@ void AISystem::patrol(entt::entity entity, Registry& registry) {
         targetPos = patrol->waypoints[patrol->currentWaypoint];
     }
     
-    // 朝目标移动
-    sf::Vector2f direction = getNormalizedDirection(transform->position, targetPos);
+    // 朝目标移动（绕开建筑）
+    sf::Vector2f direction = followPath(entity, transform->position, targetPos, registry);
     velocity->velocity = direction * (ai->moveSpeed * 0.5f); // 巡逻时速度减半
 }
 
@@ -213,6 +534,45 @@ void AISystem::attackTarget(entt::entity entity, entt::entity target, Registry&
     m_combatSystem->applyDamage(entity, target, combat->attackDamage, registry);
 }
 
+sf::Vector2f AISystem::followPath(entt::entity entity, const sf::Vector2f& position, const sf::Vector2f& destination,
+                                  Registry& registry) {
+    if (!m_pathService) return getNormalizedDirection(position, destination);
+    
+    auto* follow = registry.tryGetComponent<PathFollow>(entity);
+    if (!follow) {
+        follow = &registry.addComponent<PathFollow>(entity);
+    }
+    
+    // 尚未请求或目的地变化：放弃旧请求，重新排队（本帧先直接朝目的地走）
+    if (!follow->requested || getDistanceSquared(follow->destination, destination) > 1.f) {
+        m_pathService->release(follow->handle);
+        follow->handle = m_pathService->request(position, destination);
+        follow->destination = destination;
+        follow->waypoints.clear();
+        follow->currentWaypoint = 0;
+        
+        // 请求队列已满时下一帧重试
+        follow->requested = follow->handle != InvalidPathHandle;
+    }
+    
+    // 结果在 sync 时发布，这里只是取回；不可达时 waypoints 为空
+    if (follow->handle != InvalidPathHandle &&
+        m_pathService->takeResult(follow->handle, follow->waypoints)) {
+        follow->handle = InvalidPathHandle;
+        follow->currentWaypoint = 0;
+    }
+    
+    while (follow->currentWaypoint < follow->waypoints.size() &&
+           getDistanceSquared(position, follow->waypoints[follow->currentWaypoint]) < 100.f) {
+        ++follow->currentWaypoint;
+    }
+    
+    if (follow->currentWaypoint < follow->waypoints.size()) {
+        return getNormalizedDirection(position, follow->waypoints[follow->currentWaypoint]);
+    }
+    return getNormalizedDirection(position, destination);
+}
+
 float AISystem::getDistanceSquared(const sf::Vector2f& a, const sf::Vector2f& b) {
     float dx = b.x - a.x;
     float dy = b.y - a.y;
@@ -230,26 +590,4 @@ sf::Vector2f AISystem::getNormalizedDirection(const sf::Vector2f& from, const sf
     return direction;
 }
 
-entt::entity AISystem::findNearestBuilding(const sf::Vector2f& position, Registry& registry, float maxRange) {
-    entt::entity nearest = entt::null;
-    float nearestDistSq = maxRange * maxRange;
-    
-    auto view = registry.view<Transform, Building, Collider>();
-    for (auto entity : view) {
-        const auto& transform = view.get<Transform>(entity);
-        const auto& building = view.get<Building>(entity);
-        
-        // 跳过未完成的建筑
-        if (!building.isComplete) continue;
-        
-        float distSq = getDistanceSquared(position, transform.position);
-        if (distSq < nearestDistSq) {
-            nearestDistSq = distSq;
-            nearest = entity;
-        }
-    }
-    
-    return nearest;
-}
-
 } // namespace Nightfall
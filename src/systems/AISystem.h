@@ -1,46 +1,155 @@
 ﻿#pragma once
 
 #include "../ecs/Registry.h"
+#include "../ai/BehaviorTree.h"
+#include "../utils/Random.h"
+#include <SFML/Graphics/Rect.hpp>
 #include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 namespace Nightfall {
 
 class CombatSystem;
+class PhysicsSystem;
+class Pathfinder;
+class PathService;
+class NPCController;
+enum class AILodTier : std::uint8_t;
+enum class AIState;
+struct AI;
+
+constexpr size_t kAILodTierCount = 3;   // AILodTier 的档位数（近/中/远）
+
+/// AI LOD 统计（每个逻辑帧更新）
+struct AILodStats {
+    size_t agents[kAILodTierCount]{};    // 各档的僵尸数（按 AILodTier 下标）
+    size_t updated[kAILodTierCount]{};   // 各档本帧实际运行状态机的数量
+    float updateMs{0.f};                 // 本帧僵尸 AI 的总耗时
+};
 
 /**
  * @brief AI系统 - 处理敌人的AI行为
  * 
  * 功能：
- * - 僵尸寻路（追踪玩家）
- * - 巡逻行为
- * - 攻击判定
- * - 状态机更新
+ * - 僵尸寻路（沿流场追踪玩家，绕开建筑）
+ * - 巡逻行为（新僵尸在营地和出生点之间巡逻，巡逻点之间的路径异步向寻路服务请求）
+ * - 攻击判定（阻挡的建筑来自物理系统的接触事件）
+ * - 状态机更新：每个状态一个标签组件（IdleState/ChaseState...），每个状态一个只处理本状态的循环，
+ *   状态切换先记录下来，全部循环结束后统一换标签；追击按连续数组批量计算速度
+ * - LOD：按与玩家和相机的距离分为近/中/远三档，中远档每 N 帧更新一次并补上累积的时间，
+ *   同档的僵尸按实体编号分散到 N 个轮转桶里，每帧只更新其中一个桶，开销在帧间均摊
+ * - NPC：由数据驱动的行为树控制（按职业选原型，见 BehaviorTreeEngine），叶子在 init 中注册
  */
 class AISystem {
 public:
     AISystem();
     ~AISystem();
 
-    void init();
+    void init(Registry& registry);
     void update(float deltaTime, Registry& registry, entt::entity player);
     
     void setCombatSystem(CombatSystem* combatSystem) { m_combatSystem = combatSystem; }
+    void setPhysicsSystem(const PhysicsSystem* physicsSystem) { m_physicsSystem = physicsSystem; }
+    void setPathfinder(Pathfinder* pathfinder) { m_pathfinder = pathfinder; }
+    void setPathService(PathService* pathService) { m_pathService = pathService; }
+    void setNPCController(NPCController* npcController) { m_npcController = npcController; }
+
+    /// 相机可见区域（世界坐标），区域内的僵尸总是按近档更新
+    void setCameraView(const sf::FloatRect& view) { m_cameraView = view; }
+
+    /**
+     * @brief 设置 LOD 参数
+     * @param nearDistance 近档半径（到玩家的距离）
+     * @param midDistance 中档半径，之外为远档
+     * @param midInterval 中档的更新间隔（逻辑帧数）
+     * @param farInterval 远档的更新间隔（逻辑帧数）
+     */
+    void setLodSettings(float nearDistance, float midDistance, int midInterval, int farInterval);
+
+    const AILodStats& getLodStats() const { return m_lodStats; }
+    const BehaviorTreeStats& getBehaviorStats() const { return m_behaviorTrees.getStats(); }
 
 private:
+    /// 从上一次物理更新的接触事件中收集正在顶着已完成建筑的僵尸
+    void collectBlockingBuildings(Registry& registry);
     void updateZombieAI(float deltaTime, Registry& registry, entt::entity player);
-    void updateNPCAI(float deltaTime, Registry& registry);
+    void updateNPCAI(float deltaTime, Registry& registry, entt::entity player);
+    
+    /// 注册 NPC 行为树的叶子（移动、跟随、条件判断、执行任务板分配的工作、进食）
+    void registerBehaviorLeaves();
+    
+    // 按状态分开的更新循环
+    void updateIdle(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition);
+    void updatePatrol(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition);
+    void updateChase(float deltaTime, Registry& registry, entt::entity player, const sf::Vector2f& playerPosition);
+    void updateAttack(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition);
+    void updateFlee(float deltaTime, Registry& registry, const sf::Vector2f& playerPosition);
+    
+    /// LOD 门控：本帧轮到该僵尸更新时把累积的时间计入状态计时器并返回 true
+    bool beginAgentUpdate(entt::entity entity, AI& ai, const sf::Vector2f& position, float distSq, float deltaTime);
+    AILodTier classifyLod(const sf::Vector2f& position, float distanceSquaredToPlayer) const;
+    
+    // 状态标签
+    /// 给缺少状态标签的僵尸（新生成的实体）挂上标签和巡逻路线
+    void syncStateTags(Registry& registry, const sf::Vector2f& playerPosition);
+    static void setStateTag(Registry& registry, entt::entity entity, AIState state);
+    void requestTransition(entt::entity entity, AIState state, entt::entity target = entt::null);
+    void applyTransitions(Registry& registry);
     
     // AI行为
-    void chaseTarget(entt::entity entity, const sf::Vector2f& targetPos, Registry& registry);
     void patrol(entt::entity entity, Registry& registry);
     void attackTarget(entt::entity entity, entt::entity target, Registry& registry);
     
+    /// 沿寻路服务给出的路径走向目的地，结果未到或不可达时直接朝目的地移动；返回移动方向
+    sf::Vector2f followPath(entt::entity entity, const sf::Vector2f& position, const sf::Vector2f& destination,
+                            Registry& registry);
+    void onPathFollowDestroyed(entt::registry& registry, entt::entity entity);
+    
     // 辅助函数
     float getDistanceSquared(const sf::Vector2f& a, const sf::Vector2f& b);
     sf::Vector2f getNormalizedDirection(const sf::Vector2f& from, const sf::Vector2f& to);
-    entt::entity findNearestBuilding(const sf::Vector2f& position, Registry& registry, float maxRange);
     
     CombatSystem* m_combatSystem{nullptr};
+    const PhysicsSystem* m_physicsSystem{nullptr};
+    Pathfinder* m_pathfinder{nullptr};
+    PathService* m_pathService{nullptr};
+    NPCController* m_npcController{nullptr};
+    std::vector<sf::Vector2f> m_attractors;   // 流场目标（每帧重建）
+    RandomStream m_random;
+    
+    // LOD
+    sf::FloatRect m_cameraView;
+    float m_lodNearDistance{600.f};
+    float m_lodMidDistance{1200.f};
+    std::uint32_t m_lodIntervals[kAILodTierCount]{1, 2, 8};   // 各档的更新间隔（逻辑帧）
+    std::uint32_t m_tick{0};
+    AILodStats m_lodStats;
+    
+    // NPC 行为树
+    BehaviorTreeEngine m_behaviorTrees;
+    sf::Vector2f m_playerPosition;         // 本帧玩家位置（叶子读取）
+    std::vector<entt::entity> m_newAgents; // 本帧需要挂行为树的 NPC
+    
+    std::unordered_map<entt::entity, entt::entity> m_blockingBuildings;   // 僵尸 -> 接触中的建筑
+    
+    // 延迟的状态切换（所有状态循环结束后统一换标签）
+    struct StateTransition {
+        entt::entity entity;
+        AIState state;
+        entt::entity target;
+    };
+    std::vector<StateTransition> m_transitions;
+    std::vector<entt::entity> m_untagged;
+    
+    // 追击批处理的连续数组（每帧复用）
+    std::vector<entt::entity> m_chaseEntities;
+    std::vector<float> m_chaseX;
+    std::vector<float> m_chaseY;
+    std::vector<float> m_chaseTargetX;
+    std::vector<float> m_chaseTargetY;
+    std::vector<float> m_chaseSpeed;
 };
 
 } // namespace Nightfall
@@ -1,5 +1,7 @@
 ﻿#include "BuildingSystem.h"
 #include "ResourceSystem.h"
+#include "PhysicsSystem.h"
+#include "../ai/Pathfinding.h"
 #include "../ecs/Components.h"
 #include "../core/Logger.h"
 #include <cmath>
@@ -88,6 +90,17 @@ bool BuildingSystem::tryPlaceBuilding(const sf::Vector2f& position, Registry& re
     // 创建建筑实体
     entt::entity building = registry.createBuilding(position, m_currentBuildingType);
     
+    // 新建筑阻挡通行：只重算它覆盖的导航区域，并唤醒压在下面的休眠物体，让物理把它们推出去
+    const auto& transform = registry.getComponent<Transform>(building);
+    const auto& collider = registry.getComponent<Collider>(building);
+    const sf::FloatRect footprint(transform.position - collider.size / 2.f, collider.size);
+    if (m_pathfinder) {
+        m_pathfinder->markDirty(footprint);
+    }
+    if (m_physicsSystem) {
+        m_physicsSystem->wakeRegion(footprint);
+    }
+    
     NF_INFO("Building placed at ({}, {}), type: {}", 
             position.x, position.y, static_cast<int>(m_currentBuildingType));
     
@@ -140,17 +153,24 @@ bool BuildingSystem::isValidPlacement(const sf::Vector2f& position, Registry& re
         buildingSize
     );
     
-    // 检查是否与其他建筑或墙壁重叠
-    auto view = registry.view<Transform, Collider>();
+    // 检查是否与其他建筑、墙壁、资源节点或掉落物品重叠（静态碰撞体索引）
+    bool blocked = false;
+    registry.getStaticIndex().query(buildingBounds, [&](entt::entity, const sf::FloatRect& entityBounds) {
+        if (!blocked && buildingBounds.findIntersection(entityBounds).has_value()) {
+            blocked = true;
+        }
+    });
+    
+    if (blocked) {
+        return false;
+    }
+    
+    // NPC 数量很少，直接遍历
+    auto view = registry.view<Transform, Collider, NPC>(entt::exclude<Static>);
     for (auto entity : view) {
         const auto& transform = view.get<Transform>(entity);
         const auto& collider = view.get<Collider>(entity);
         
-        // 跳过玩家和僵尸
-        if (registry.hasComponent<Player>(entity) || registry.hasComponent<Zombie>(entity)) {
-            continue;
-        }
-        
         sf::FloatRect entityBounds(
             sf::Vector2f(transform.position.x - collider.size.x / 2.f,
                         transform.position.y - collider.size.y / 2.f),
@@ -7,6 +7,8 @@
 namespace Nightfall {
 
 class ResourceSystem;
+class Pathfinder;
+class PhysicsSystem;
 
 /// 建筑系统 - 处理建筑放置、建造、升级
 class BuildingSystem {
@@ -18,6 +20,8 @@ public:
     void update(float deltaTime, Registry& registry);
     
     void setResourceSystem(ResourceSystem* resources) { m_resourceSystem = resources; }
+    void setPathfinder(Pathfinder* pathfinder) { m_pathfinder = pathfinder; }
+    void setPhysicsSystem(PhysicsSystem* physics) { m_physicsSystem = physics; }
 
     /// 开始放置建筑
     void startPlacement(Building::Type buildingType);
@@ -67,6 +71,8 @@ private:
     sf::RectangleShape m_previewShape;
     
     ResourceSystem* m_resourceSystem{nullptr};
+    Pathfinder* m_pathfinder{nullptr};
+    PhysicsSystem* m_physicsSystem{nullptr};
 };
 
 } // namespace Nightfall
@@ -0,0 +1,217 @@
+﻿#include "CollisionKernel.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define NF_COLLISION_SSE2 1
+#endif
+
+#if defined(NIGHTFALL_COLLISION_AVX2) && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace Nightfall {
+
+namespace {
+
+#if defined(NIGHTFALL_COLLISION_AVX2)
+/// True when both the CPU and the OS (YMM state saving) support AVX2
+bool cpuSupportsAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+#endif
+
+} // namespace
+
+void AABBPairBatch::clear() {
+    aMinX.clear(); aMinY.clear(); aMaxX.clear(); aMaxY.clear();
+    bMinX.clear(); bMinY.clear(); bMaxX.clear(); bMaxY.clear();
+}
+
+void AABBPairBatch::reserve(size_t count) {
+    aMinX.reserve(count); aMinY.reserve(count); aMaxX.reserve(count); aMaxY.reserve(count);
+    bMinX.reserve(count); bMinY.reserve(count); bMaxX.reserve(count); bMaxY.reserve(count);
+}
+
+void AABBPairBatch::push(const sf::FloatRect& a, const sf::FloatRect& b) {
+    aMinX.push_back(a.position.x);
+    aMinY.push_back(a.position.y);
+    aMaxX.push_back(a.position.x + a.size.x);
+    aMaxY.push_back(a.position.y + a.size.y);
+    bMinX.push_back(b.position.x);
+    bMinY.push_back(b.position.y);
+    bMaxX.push_back(b.position.x + b.size.x);
+    bMaxY.push_back(b.position.y + b.size.y);
+}
+
+CollisionKernel::Path CollisionKernel::getActivePath() {
+#if defined(NIGHTFALL_COLLISION_AVX2)
+    static const bool hasAVX2 = cpuSupportsAVX2();
+    if (hasAVX2) return Path::AVX2;
+#endif
+#if defined(NF_COLLISION_SSE2)
+    return Path::SSE2;
+#else
+    return Path::Scalar;
+#endif
+}
+
+const char* CollisionKernel::getActivePathName() {
+    switch (getActivePath()) {
+        case Path::AVX2: return "AVX2";
+        case Path::SSE2: return "SSE2";
+        default:         return "Scalar";
+    }
+}
+
+// ==================== Overlap test ====================
+
+void CollisionKernel::findOverlapsRange(const AABBPairBatch& batch, size_t begin, size_t end,
+                                        std::vector<std::uint32_t>& hits) {
+    for (size_t i = begin; i < end; ++i) {
+        if (batch.aMinX[i] < batch.bMaxX[i] && batch.aMaxX[i] > batch.bMinX[i] &&
+            batch.aMinY[i] < batch.bMaxY[i] && batch.aMaxY[i] > batch.bMinY[i]) {
+            hits.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+}
+
+void CollisionKernel::findOverlapsScalar(const AABBPairBatch& batch, std::vector<std::uint32_t>& hits) {
+    findOverlapsRange(batch, 0, batch.size(), hits);
+}
+
+void CollisionKernel::findOverlaps(const AABBPairBatch& batch, std::vector<std::uint32_t>& hits) {
+    const size_t count = batch.size();
+    size_t i = 0;
+
+    [[maybe_unused]] const Path path = getActivePath();
+
+#if defined(NIGHTFALL_COLLISION_AVX2)
+    if (path == Path::AVX2) {
+        i = findOverlapsAVX2(batch, hits);
+    }
+#endif
+#if defined(NF_COLLISION_SSE2)
+    if (path == Path::SSE2) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 overlap = _mm_and_ps(
+                _mm_and_ps(
+                    _mm_cmplt_ps(_mm_loadu_ps(&batch.aMinX[i]), _mm_loadu_ps(&batch.bMaxX[i])),
+                    _mm_cmpgt_ps(_mm_loadu_ps(&batch.aMaxX[i]), _mm_loadu_ps(&batch.bMinX[i]))),
+                _mm_and_ps(
+                    _mm_cmplt_ps(_mm_loadu_ps(&batch.aMinY[i]), _mm_loadu_ps(&batch.bMaxY[i])),
+                    _mm_cmpgt_ps(_mm_loadu_ps(&batch.aMaxY[i]), _mm_loadu_ps(&batch.bMinY[i]))));
+
+            int mask = _mm_movemask_ps(overlap);
+            for (int lane = 0; lane < 4; ++lane) {
+                if (mask & (1 << lane)) {
+                    hits.push_back(static_cast<std::uint32_t>(i + lane));
+                }
+            }
+        }
+    }
+#endif
+
+    // Remaining pairs (and the whole batch on the scalar path)
+    findOverlapsRange(batch, i, count, hits);
+}
+
+// ==================== Push-out vectors ====================
+
+void CollisionKernel::computePushOutRange(const AABBPairBatch& batch, size_t begin, size_t end,
+                                          float* pushX, float* pushY) {
+    for (size_t i = begin; i < end; ++i) {
+        float deltaX = (batch.aMinX[i] + batch.aMaxX[i]) * 0.5f - (batch.bMinX[i] + batch.bMaxX[i]) * 0.5f;
+        float deltaY = (batch.aMinY[i] + batch.aMaxY[i]) * 0.5f - (batch.bMinY[i] + batch.bMaxY[i]) * 0.5f;
+
+        float overlapX = ((batch.aMaxX[i] - batch.aMinX[i]) + (batch.bMaxX[i] - batch.bMinX[i])) * 0.5f - std::abs(deltaX);
+        float overlapY = ((batch.aMaxY[i] - batch.aMinY[i]) + (batch.bMaxY[i] - batch.bMinY[i])) * 0.5f - std::abs(deltaY);
+
+        // Push out on the axis with smallest overlap
+        if (overlapX < overlapY) {
+            pushX[i] = deltaX > 0.f ? overlapX : -overlapX;
+            pushY[i] = 0.f;
+        } else {
+            pushX[i] = 0.f;
+            pushY[i] = deltaY > 0.f ? overlapY : -overlapY;
+        }
+    }
+}
+
+void CollisionKernel::computePushOutScalar(const AABBPairBatch& batch, std::vector<float>& pushX, std::vector<float>& pushY) {
+    pushX.resize(batch.size());
+    pushY.resize(batch.size());
+    computePushOutRange(batch, 0, batch.size(), pushX.data(), pushY.data());
+}
+
+void CollisionKernel::computePushOut(const AABBPairBatch& batch, std::vector<float>& pushX, std::vector<float>& pushY) {
+    const size_t count = batch.size();
+    pushX.resize(count);
+    pushY.resize(count);
+    size_t i = 0;
+
+    [[maybe_unused]] const Path path = getActivePath();
+
+#if defined(NIGHTFALL_COLLISION_AVX2)
+    if (path == Path::AVX2) {
+        i = computePushOutAVX2(batch, pushX.data(), pushY.data());
+    }
+#endif
+#if defined(NF_COLLISION_SSE2)
+    if (path == Path::SSE2) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 signMask = _mm_set1_ps(-0.f);
+        for (; i + 4 <= count; i += 4) {
+            __m128 aMinX = _mm_loadu_ps(&batch.aMinX[i]), aMaxX = _mm_loadu_ps(&batch.aMaxX[i]);
+            __m128 aMinY = _mm_loadu_ps(&batch.aMinY[i]), aMaxY = _mm_loadu_ps(&batch.aMaxY[i]);
+            __m128 bMinX = _mm_loadu_ps(&batch.bMinX[i]), bMaxX = _mm_loadu_ps(&batch.bMaxX[i]);
+            __m128 bMinY = _mm_loadu_ps(&batch.bMinY[i]), bMaxY = _mm_loadu_ps(&batch.bMaxY[i]);
+
+            __m128 deltaX = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(aMinX, aMaxX), half),
+                                       _mm_mul_ps(_mm_add_ps(bMinX, bMaxX), half));
+            __m128 deltaY = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(aMinY, aMaxY), half),
+                                       _mm_mul_ps(_mm_add_ps(bMinY, bMaxY), half));
+
+            __m128 overlapX = _mm_sub_ps(
+                _mm_mul_ps(_mm_add_ps(_mm_sub_ps(aMaxX, aMinX), _mm_sub_ps(bMaxX, bMinX)), half),
+                _mm_andnot_ps(signMask, deltaX));
+            __m128 overlapY = _mm_sub_ps(
+                _mm_mul_ps(_mm_add_ps(_mm_sub_ps(aMaxY, aMinY), _mm_sub_ps(bMaxY, bMinY)), half),
+                _mm_andnot_ps(signMask, deltaY));
+
+            // Signed overlap: +overlap when delta > 0, otherwise -overlap (SSE2 has no blendv)
+            __m128 positiveX = _mm_cmpgt_ps(deltaX, zero);
+            __m128 positiveY = _mm_cmpgt_ps(deltaY, zero);
+            __m128 signedX = _mm_or_ps(_mm_and_ps(positiveX, overlapX),
+                                       _mm_andnot_ps(positiveX, _mm_xor_ps(overlapX, signMask)));
+            __m128 signedY = _mm_or_ps(_mm_and_ps(positiveY, overlapY),
+                                       _mm_andnot_ps(positiveY, _mm_xor_ps(overlapY, signMask)));
+
+            __m128 useX = _mm_cmplt_ps(overlapX, overlapY);
+            _mm_storeu_ps(&pushX[i], _mm_and_ps(useX, signedX));
+            _mm_storeu_ps(&pushY[i], _mm_andnot_ps(useX, signedY));
+        }
+    }
+#endif
+
+    computePushOutRange(batch, i, count, pushX.data(), pushY.data());
+}
+
+} // namespace Nightfall
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Nightfall {
+
+/// Structure-of-arrays buffer of candidate collision pairs (A = moving, B = other)
+struct AABBPairBatch {
+    std::vector<float> aMinX, aMinY, aMaxX, aMaxY;
+    std::vector<float> bMinX, bMinY, bMaxX, bMaxY;
+
+    void clear();
+    void reserve(size_t count);
+    void push(const sf::FloatRect& a, const sf::FloatRect& b);
+    size_t size() const { return aMinX.size(); }
+};
+
+/// Batched AABB narrowphase kernels
+/// The SIMD path is chosen at runtime: AVX2 (8 lanes) when built with NIGHTFALL_ENABLE_AVX2 and the
+/// CPU supports it, SSE2 (4 lanes) on x86/x64, scalar otherwise. Results match the scalar versions exactly.
+class CollisionKernel {
+public:
+    enum class Path {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    static Path getActivePath();
+    static const char* getActivePathName();
+
+    /// Append the indices of overlapping pairs to hits (same test as PhysicsSystem::checkAABBCollision)
+    static void findOverlaps(const AABBPairBatch& batch, std::vector<std::uint32_t>& hits);
+    static void findOverlapsScalar(const AABBPairBatch& batch, std::vector<std::uint32_t>& hits);
+
+    /// Push-out vector that moves A out of B along the axis of least overlap, for every pair
+    /// (same rule as PhysicsSystem::resolveCollision; only meaningful for overlapping pairs)
+    static void computePushOut(const AABBPairBatch& batch, std::vector<float>& pushX, std::vector<float>& pushY);
+    static void computePushOutScalar(const AABBPairBatch& batch, std::vector<float>& pushX, std::vector<float>& pushY);
+
+private:
+    /// AVX2 kernels (CollisionKernelAVX2.cpp, the only file built with AVX2 enabled);
+    /// they process whole groups of 8 pairs and return how many pairs they handled
+    static size_t findOverlapsAVX2(const AABBPairBatch& batch, std::vector<std::uint32_t>& hits);
+    static size_t computePushOutAVX2(const AABBPairBatch& batch, float* pushX, float* pushY);
+
+    static void findOverlapsRange(const AABBPairBatch& batch, size_t begin, size_t end,
+                                  std::vector<std::uint32_t>& hits);
+    static void computePushOutRange(const AABBPairBatch& batch, size_t begin, size_t end,
+                                    float* pushX, float* pushY);
+};
+
+} // namespace Nightfall
@@ -0,0 +1,74 @@
+﻿#include "CollisionKernel.h"
+
+// This is the only file built with AVX2 enabled (see NIGHTFALL_ENABLE_AVX2 in CMakeLists.txt);
+// its kernels must only run when getActivePath() reports AVX2
+#if defined(NIGHTFALL_COLLISION_AVX2)
+#include <immintrin.h>
+
+namespace Nightfall {
+
+size_t CollisionKernel::findOverlapsAVX2(const AABBPairBatch& batch, std::vector<std::uint32_t>& hits) {
+    const size_t count = batch.size();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 overlap = _mm256_and_ps(
+            _mm256_and_ps(
+                _mm256_cmp_ps(_mm256_loadu_ps(&batch.aMinX[i]), _mm256_loadu_ps(&batch.bMaxX[i]), _CMP_LT_OQ),
+                _mm256_cmp_ps(_mm256_loadu_ps(&batch.aMaxX[i]), _mm256_loadu_ps(&batch.bMinX[i]), _CMP_GT_OQ)),
+            _mm256_and_ps(
+                _mm256_cmp_ps(_mm256_loadu_ps(&batch.aMinY[i]), _mm256_loadu_ps(&batch.bMaxY[i]), _CMP_LT_OQ),
+                _mm256_cmp_ps(_mm256_loadu_ps(&batch.aMaxY[i]), _mm256_loadu_ps(&batch.bMinY[i]), _CMP_GT_OQ)));
+
+        int mask = _mm256_movemask_ps(overlap);
+        while (mask) {
+            int lane = 0;
+            while (!(mask & (1 << lane))) ++lane;
+            hits.push_back(static_cast<std::uint32_t>(i + lane));
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+
+size_t CollisionKernel::computePushOutAVX2(const AABBPairBatch& batch, float* pushX, float* pushY) {
+    const size_t count = batch.size();
+    size_t i = 0;
+
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signMask = _mm256_set1_ps(-0.f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 aMinX = _mm256_loadu_ps(&batch.aMinX[i]), aMaxX = _mm256_loadu_ps(&batch.aMaxX[i]);
+        __m256 aMinY = _mm256_loadu_ps(&batch.aMinY[i]), aMaxY = _mm256_loadu_ps(&batch.aMaxY[i]);
+        __m256 bMinX = _mm256_loadu_ps(&batch.bMinX[i]), bMaxX = _mm256_loadu_ps(&batch.bMaxX[i]);
+        __m256 bMinY = _mm256_loadu_ps(&batch.bMinY[i]), bMaxY = _mm256_loadu_ps(&batch.bMaxY[i]);
+
+        __m256 deltaX = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(aMinX, aMaxX), half),
+                                      _mm256_mul_ps(_mm256_add_ps(bMinX, bMaxX), half));
+        __m256 deltaY = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(aMinY, aMaxY), half),
+                                      _mm256_mul_ps(_mm256_add_ps(bMinY, bMaxY), half));
+
+        __m256 overlapX = _mm256_sub_ps(
+            _mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(aMaxX, aMinX), _mm256_sub_ps(bMaxX, bMinX)), half),
+            _mm256_andnot_ps(signMask, deltaX));
+        __m256 overlapY = _mm256_sub_ps(
+            _mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(aMaxY, aMinY), _mm256_sub_ps(bMaxY, bMinY)), half),
+            _mm256_andnot_ps(signMask, deltaY));
+
+        // Signed overlap: +overlap when delta > 0, otherwise -overlap
+        __m256 signedX = _mm256_blendv_ps(_mm256_xor_ps(overlapX, signMask), overlapX,
+                                          _mm256_cmp_ps(deltaX, zero, _CMP_GT_OQ));
+        __m256 signedY = _mm256_blendv_ps(_mm256_xor_ps(overlapY, signMask), overlapY,
+                                          _mm256_cmp_ps(deltaY, zero, _CMP_GT_OQ));
+
+        __m256 useX = _mm256_cmp_ps(overlapX, overlapY, _CMP_LT_OQ);
+        _mm256_storeu_ps(pushX + i, _mm256_and_ps(useX, signedX));
+        _mm256_storeu_ps(pushY + i, _mm256_andnot_ps(useX, signedY));
+    }
+    return i;
+}
+
+} // namespace Nightfall
+
+#endif
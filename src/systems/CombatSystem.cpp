@@ -1,6 +1,7 @@
 ﻿#include "CombatSystem.h"
 #include "VisualEffectsSystem.h"
 #include "ResourceSystem.h"
+#include "../ai/Pathfinding.h"
 #include "../ecs/Components.h"
 #include "../core/Logger.h"
 
@@ -14,6 +15,7 @@ CombatSystem::~CombatSystem() {
 }
 
 void CombatSystem::init() {
+    m_random = Random::createStream(RandomStreamId::Combat);
     NF_INFO("Combat system initialized");
 }
 
@@ -27,7 +29,8 @@ void CombatSystem::applyDamage(entt::entity attacker, entt::entity target, float
     // 检查是否是建筑物
     auto* building = registry.tryGetComponent<Building>(target);
     if (building) {
-        // 对建筑造成伤害
+        // 对建筑造成伤害（销毁是延迟的，只在耐久刚降到 0 时结算一次）
+        const bool wasStanding = building->durability > 0.f;
         building->durability -= damage;
         
         // 显示伤害数字
@@ -46,7 +49,7 @@ void CombatSystem::applyDamage(entt::entity attacker, entt::entity target, float
                  building->maxDurability);
         
         // 建筑被摧毁
-        if (building->durability <= 0.f) {
+        if (wasStanding && building->durability <= 0.f) {
             handleBuildingDestruction(target, registry);
         }
         return;
@@ -55,6 +58,7 @@ void CombatSystem::applyDamage(entt::entity attacker, entt::entity target, float
     auto* health = registry.tryGetComponent<Health>(target);
     if (!health || health->invincible) return;
     
+    const bool wasAlive = !health->isDead();
     health->current -= damage;
     
     // 确保生命值不低于0
@@ -77,8 +81,9 @@ void CombatSystem::applyDamage(entt::entity attacker, entt::entity target, float
              health->current,
              health->maximum);
     
-    // 如果目标死亡，处理死亡逻辑
-    if (health->isDead()) {
+    // 死亡结算（特效、掉落、销毁）统一在 update 的清理中进行，同一实体只结算一次；
+    // 玩家不会被清理，在这里发出死亡通知
+    if (wasAlive && health->isDead() && registry.hasComponent<Player>(target)) {
         handleDeath(target, registry);
     }
 }
@@ -107,15 +112,15 @@ void CombatSystem::handleDeath(entt::entity entity, Registry& registry) {
         
         // 掉落资源
         if (m_resourceSystem) {
-            m_resourceSystem->addResource("scrap", 1 + rand() % 3); // 1-3 scrap
+            m_resourceSystem->addResource("scrap", m_random.rangeInt(1, 3)); // 1-3 scrap
         }
         
         // TODO: 掉落物品逻辑
         // TODO: 播放死亡音效
     }
     
-    // 销毁实体
-    registry.destroyEntity(entity);
+    // 回收实体（僵尸停放到对象池复用，其他实体销毁；延迟到同步点，避免使其他系统正在遍历的视图失效）
+    registry.commands().recycle(entity);
 }
 
 void CombatSystem::handleBuildingDestruction(entt::entity entity, Registry& registry) {
@@ -131,8 +136,17 @@ void CombatSystem::handleBuildingDestruction(entt::entity entity, Registry& regi
         }
     }
     
-    // 销毁建筑实体
-    registry.destroyEntity(entity);
+    // 建筑消失后重新开放它覆盖的导航区域
+    if (m_pathfinder) {
+        auto* transform = registry.tryGetComponent<Transform>(entity);
+        auto* collider = registry.tryGetComponent<Collider>(entity);
+        if (transform && collider) {
+            m_pathfinder->markDirty(sf::FloatRect(transform->position - collider->size / 2.f, collider->size));
+        }
+    }
+    
+    // 销毁建筑实体（延迟到同步点）
+    registry.commands().destroy(entity);
 }
 
 void CombatSystem::cleanupDeadEntities(Registry& registry) {
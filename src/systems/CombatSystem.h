@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "../ecs/Registry.h"
+#include "../utils/Random.h"
 #include <SFML/Graphics.hpp>
 #include <entt/entt.hpp>
 
@@ -8,6 +9,7 @@ namespace Nightfall {
 
 class VisualEffectsSystem;
 class ResourceSystem;
+class Pathfinder;
 
 /// 战斗系统 - 处理伤害、死亡、战斗逻辑
 class CombatSystem {
@@ -20,6 +22,7 @@ public:
     
     void setVisualEffectsSystem(VisualEffectsSystem* vfx) { m_visualEffects = vfx; }
     void setResourceSystem(ResourceSystem* resources) { m_resourceSystem = resources; }
+    void setPathfinder(Pathfinder* pathfinder) { m_pathfinder = pathfinder; }
 
     /// 处理实体死亡
     void handleDeath(entt::entity entity, Registry& registry);
@@ -27,7 +30,7 @@ public:
     /// 处理建筑被摧毁
     void handleBuildingDestruction(entt::entity entity, Registry& registry);
 
-    /// 应用伤害到目标
+    /// 应用伤害到目标（不直接销毁实体，可在非独占系统中调用）
     void applyDamage(entt::entity attacker, entt::entity target, float damage, Registry& registry);
 
 private:
@@ -36,6 +39,8 @@ private:
     
     VisualEffectsSystem* m_visualEffects{nullptr};
     ResourceSystem* m_resourceSystem{nullptr};
+    Pathfinder* m_pathfinder{nullptr};
+    RandomStream m_random;
 };
 
 } // namespace Nightfall
@@ -0,0 +1,158 @@
+﻿#include "CrowdSystem.h"
+#include "../ecs/Components.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Nightfall {
+
+CrowdSystem::~CrowdSystem() {
+    NF_INFO("Crowd system shutdown");
+}
+
+void CrowdSystem::init() {
+    m_grid.setCellSize(m_neighborRadius);
+    NF_INFO("Crowd system initialized (radius: {}, max neighbors: {})", m_neighborRadius, m_maxNeighbors);
+}
+
+void CrowdSystem::setNeighborRadius(float radius) {
+    m_neighborRadius = radius > 1.f ? radius : 1.f;
+    m_grid.setCellSize(m_neighborRadius);
+}
+
+void CrowdSystem::setWeights(float separation, float alignment, float cohesion) {
+    m_separationWeight = separation;
+    m_alignmentWeight = alignment;
+    m_cohesionWeight = cohesion;
+}
+
+void CrowdSystem::update(float, Registry& registry) {
+    if (!m_enabled) return;
+
+    m_grid.clear();
+    m_agents.clear();
+    m_posX.clear();
+    m_posY.clear();
+    m_velX.clear();
+    m_velY.clear();
+    m_maxSpeed.clear();
+    m_steerable.clear();
+
+    // 收集所有敌对单位；休眠或静止的单位只作为邻居，不被转向
+    auto view = registry.view<Transform, Velocity, Hostile>();
+    for (auto entity : view) {
+        const auto& transform = view.get<Transform>(entity);
+        const auto& velocity = view.get<Velocity>(entity);
+
+        const auto id = static_cast<std::uint32_t>(m_agents.size());
+        m_grid.insert(id, sf::FloatRect(transform.position, sf::Vector2f(0.f, 0.f)));
+        m_agents.push_back(entity);
+        m_posX.push_back(transform.position.x);
+        m_posY.push_back(transform.position.y);
+        m_velX.push_back(velocity.velocity.x);
+        m_velY.push_back(velocity.velocity.y);
+        m_maxSpeed.push_back(velocity.maxSpeed);
+
+        const bool moving = velocity.velocity.x != 0.f || velocity.velocity.y != 0.f;
+        m_steerable.push_back(moving && !registry.hasComponent<Asleep>(entity) ? 1 : 0);
+    }
+
+    if (m_agents.empty()) return;
+    m_grid.build();
+
+    const size_t count = m_agents.size();
+    m_steerX.assign(count, 0.f);
+    m_steerY.assign(count, 0.f);
+
+    const float radius = m_neighborRadius;
+    const float radiusSq = radius * radius;
+    const sf::Vector2f queryExtent(radius * 2.f, radius * 2.f);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!m_steerable[i]) continue;
+
+        const float x = m_posX[i];
+        const float y = m_posY[i];
+
+        // 先收集半径内的全部邻居，超过上限时只保留最近的 m_maxNeighbors 个
+        // （与网格桶的遍历顺序无关；距离相同时按下标取舍）
+        m_neighbors.clear();
+        m_grid.query(sf::FloatRect(sf::Vector2f(x - radius, y - radius), queryExtent),
+                     [&](std::uint32_t id, const sf::FloatRect&) {
+            if (id == i) return;
+
+            const float dx = x - m_posX[id];
+            const float dy = y - m_posY[id];
+            const float distSq = dx * dx + dy * dy;
+            if (distSq < radiusSq) {
+                m_neighbors.emplace_back(distSq, id);
+            }
+        });
+
+        const size_t maxNeighbors = static_cast<size_t>(m_maxNeighbors);
+        if (m_neighbors.size() > maxNeighbors) {
+            std::nth_element(m_neighbors.begin(), m_neighbors.begin() + (maxNeighbors - 1), m_neighbors.end());
+            m_neighbors.resize(maxNeighbors);
+        }
+
+        float separationX = 0.f, separationY = 0.f;
+        float velocitySumX = 0.f, velocitySumY = 0.f;
+        float centerSumX = 0.f, centerSumY = 0.f;
+        const int neighbors = static_cast<int>(m_neighbors.size());
+
+        for (const auto& [neighborDistSq, id] : m_neighbors) {
+            float dx = x - m_posX[id];
+            float dy = y - m_posY[id];
+            float distSq = neighborDistSq;
+
+            if (distSq < 1e-6f) {
+                // 完全重合：按下标错开，保证两个单位向相反方向分开
+                dx = id < i ? 1.f : -1.f;
+                dy = 0.f;
+                distSq = 1.f;
+            }
+
+            // 越近排斥越强（线性衰减到半径处为 0）
+            float dist = std::sqrt(distSq);
+            float falloff = 1.f - dist / radius;
+            separationX += dx / dist * falloff;
+            separationY += dy / dist * falloff;
+
+            velocitySumX += m_velX[id];
+            velocitySumY += m_velY[id];
+            centerSumX += m_posX[id];
+            centerSumY += m_posY[id];
+        }
+
+        if (neighbors == 0) continue;
+
+        const float inverse = 1.f / static_cast<float>(neighbors);
+        const float maxSpeed = m_maxSpeed[i];
+
+        // 分离：按最大速度缩放；对齐：趋向邻居平均速度；聚合：趋向邻居中心（按半径归一化）
+        m_steerX[i] = separationX * maxSpeed * m_separationWeight
+                    + (velocitySumX * inverse - m_velX[i]) * m_alignmentWeight
+                    + (centerSumX * inverse - x) / radius * maxSpeed * m_cohesionWeight;
+        m_steerY[i] = separationY * maxSpeed * m_separationWeight
+                    + (velocitySumY * inverse - m_velY[i]) * m_alignmentWeight
+                    + (centerSumY * inverse - y) / radius * maxSpeed * m_cohesionWeight;
+    }
+
+    // 写回速度（不超过最大速度，移动系统负责积分）
+    for (size_t i = 0; i < count; ++i) {
+        if (!m_steerable[i] || (m_steerX[i] == 0.f && m_steerY[i] == 0.f)) continue;
+
+        float vx = m_velX[i] + m_steerX[i];
+        float vy = m_velY[i] + m_steerY[i];
+        float speed = std::sqrt(vx * vx + vy * vy);
+        if (speed > m_maxSpeed[i] && speed > 0.f) {
+            float scale = m_maxSpeed[i] / speed;
+            vx *= scale;
+            vy *= scale;
+        }
+
+        registry.getComponent<Velocity>(m_agents[i]).velocity = sf::Vector2f(vx, vy);
+    }
+}
+
+} // namespace Nightfall
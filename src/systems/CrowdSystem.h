@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include "../ecs/Registry.h"
+#include "../utils/SpatialHash.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Nightfall {
+
+/**
+ * @brief 群体转向系统 - 让成群的僵尸在物理碰撞之前就互相避让
+ *
+ * 功能：
+ * - 每帧把所有敌对单位放进均匀邻居网格（格子边长 = 邻居半径）
+ * - 每个单位最多参考固定数量的邻居，计算分离、对齐、聚合三个转向分量
+ * - 在 AI 写入期望速度之后、移动系统积分之前修正 Velocity，
+ *   密集尸群大多在进入物理系统前已经分开，减少推挤解算的接触数
+ */
+class CrowdSystem {
+public:
+    CrowdSystem() = default;
+    ~CrowdSystem();
+
+    void init();
+    void update(float deltaTime, Registry& registry);
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+
+    /// 设置邻居半径（像素），同时作为邻居网格的格子边长
+    void setNeighborRadius(float radius);
+
+    /// 设置每个单位参考的最大邻居数
+    void setMaxNeighbors(int maxNeighbors) { m_maxNeighbors = maxNeighbors > 0 ? maxNeighbors : 1; }
+
+    /// 设置分离、对齐、聚合的权重
+    void setWeights(float separation, float alignment, float cohesion);
+
+private:
+    bool m_enabled{true};
+    float m_neighborRadius{48.f};
+    int m_maxNeighbors{8};
+    float m_separationWeight{1.5f};
+    float m_alignmentWeight{0.3f};
+    float m_cohesionWeight{0.1f};
+
+    // 邻居网格（每帧重建），网格 id 即下面数组的下标
+    SpatialHash m_grid;
+    std::vector<entt::entity> m_agents;
+    std::vector<float> m_posX;
+    std::vector<float> m_posY;
+    std::vector<float> m_velX;
+    std::vector<float> m_velY;
+    std::vector<float> m_maxSpeed;
+    std::vector<std::uint8_t> m_steerable;   // 醒着且在移动的单位才被转向
+    std::vector<float> m_steerX;             // 先全部算完再写回，结果与遍历顺序无关
+    std::vector<float> m_steerY;
+    std::vector<std::pair<float, std::uint32_t>> m_neighbors;   // 当前单位半径内的邻居（距离平方, 下标）
+};
+
+} // namespace Nightfall
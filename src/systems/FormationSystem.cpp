@@ -0,0 +1,332 @@
+﻿#include "FormationSystem.h"
+#include "../ai/PathService.h"
+#include "../ecs/Components.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Nightfall {
+
+namespace {
+
+constexpr float kGroupCellSize = 512.f;   // 编组时按这个大小的格子排序，同一片区域的 NPC 分在同一队
+constexpr float kSlotGain = 2.f;          // 阵位误差的修正增益（1/秒）
+constexpr float kLeaderPace = 0.8f;       // 领队以最慢成员速度的这个比例行进，给成员留出追赶余量
+constexpr float kRegroupSlowdown = 0.25f; // 队形散开时领队的减速比例
+constexpr float kPi = 3.14159265f;
+
+float lengthOf(const sf::Vector2f& v) {
+    return std::sqrt(v.x * v.x + v.y * v.y);
+}
+
+/// 在第 ring 圈上均匀放置 count 个阵位（每圈最多 6 * ring 个）
+void placeRing(std::vector<entt::entity>& members, size_t& next, int ring, size_t count, float spacing,
+               Registry& registry) {
+    const float radius = static_cast<float>(ring) * spacing;
+    for (size_t i = 0; i < count; ++i) {
+        const float angle = 2.f * kPi * static_cast<float>(i) / static_cast<float>(count);
+        auto& member = registry.getComponent<SquadMember>(members[next++]);
+        member.slotOffset = sf::Vector2f(std::cos(angle), std::sin(angle)) * radius;
+    }
+}
+
+} // namespace
+
+FormationSystem::FormationSystem() {
+}
+
+FormationSystem::~FormationSystem() {
+    NF_INFO("Formation system shutdown");
+}
+
+void FormationSystem::init(Registry& registry) {
+    registry.raw().on_destroy<SquadMember>().connect<&FormationSystem::onMemberDestroyed>(*this);
+    NF_INFO("Formation system initialized (squad size: {}, spacing: {})", m_squadSize, m_spacing);
+}
+
+void FormationSystem::setSquadSettings(int squadSize, float spacing) {
+    m_squadSize = static_cast<size_t>(std::max(1, squadSize));
+    m_spacing = std::max(1.f, spacing);
+}
+
+void FormationSystem::setMarchSettings(float arriveDistance, float repathDistance) {
+    m_arriveDistance = std::max(1.f, arriveDistance);
+    m_repathDistance = std::max(1.f, repathDistance);
+}
+
+void FormationSystem::startMigration(Registry& registry, const sf::Vector2f& destination) {
+    disband(registry);
+    m_destination = destination;
+    m_stats = FormationStats{};
+
+    // 按所在区域排序后顺序切分，位置相近的 NPC 编入同一小队
+    m_recruits.clear();
+    auto view = registry.view<NPC, Friendly, Transform, Velocity>();
+    for (auto entity : view) {
+        const sf::Vector2f& position = view.get<Transform>(entity).position;
+        const auto cellX = static_cast<std::int32_t>(std::floor(position.x / kGroupCellSize));
+        const auto cellY = static_cast<std::int32_t>(std::floor(position.y / kGroupCellSize));
+        const std::uint64_t key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellY)) << 32) |
+                                  static_cast<std::uint32_t>(cellX);
+        m_recruits.emplace_back(key, entity);
+    }
+    std::sort(m_recruits.begin(), m_recruits.end());
+
+    for (size_t first = 0; first < m_recruits.size(); first += m_squadSize) {
+        const auto squadId = static_cast<std::uint32_t>(m_squads.size());
+        m_squads.emplace_back();
+        Squad& squad = m_squads.back();
+        squad.active = true;
+
+        const size_t last = std::min(first + m_squadSize, m_recruits.size());
+        for (size_t i = first; i < last; ++i) {
+            const entt::entity entity = m_recruits[i].second;
+            squad.members.push_back(entity);
+
+            // 放下手头的事：行为树和任务板的工作在解散后重新开始
+            registry.removeComponent<BehaviorAgent>(entity);
+            registry.getOrAddComponent<SquadMember>(entity).squad = squadId;
+        }
+
+        formSquad(registry, squadId);
+    }
+
+    m_leaderVelocity.assign(m_squads.size(), sf::Vector2f(0.f, 0.f));
+    NF_INFO("Mass migration: {} NPCs in {} squads", m_recruits.size(), m_squads.size());
+}
+
+void FormationSystem::disband(Registry& registry) {
+    m_disbanding = true;
+    for (auto& squad : m_squads) {
+        releaseLeader(registry, squad.leader);
+        for (auto entity : squad.members) {
+            if (registry.isValid(entity)) {
+                registry.removeComponent<SquadMember>(entity);
+            }
+        }
+    }
+    m_disbanding = false;
+
+    m_squads.clear();
+    m_leaderVelocity.clear();
+    m_stats.squads = 0;
+    m_stats.members = 0;
+}
+
+void FormationSystem::formSquad(Registry& registry, std::uint32_t squadId) {
+    Squad& squad = m_squads[squadId];
+    squad.members.erase(std::remove_if(squad.members.begin(), squad.members.end(),
+                                       [&](entt::entity e) {
+                                           return !registry.isValid(e) || !registry.hasComponent<SquadMember>(e);
+                                       }),
+                        squad.members.end());
+    squad.dirty = false;
+
+    if (squad.members.empty()) {
+        squad.active = false;
+        squad.leader = entt::null;
+        return;
+    }
+
+    // 非战斗人员在内圈，战斗人员在外圈
+    m_inner.clear();
+    m_outer.clear();
+    for (auto entity : squad.members) {
+        (registry.hasComponent<Combat>(entity) ? m_outer : m_inner).push_back(entity);
+    }
+
+    // 领队优先从非战斗人员中选（位于阵型中心）；领队不变时保留它已有的路径
+    const entt::entity leader = !m_inner.empty() ? m_inner.front() : m_outer.front();
+    if (leader != squad.leader) {
+        releaseLeader(registry, squad.leader);
+        squad.leader = leader;
+    }
+
+    squad.members.clear();
+    squad.members.insert(squad.members.end(), m_inner.begin(), m_inner.end());
+    squad.members.insert(squad.members.end(), m_outer.begin(), m_outer.end());
+
+    size_t next = 0;
+    if (!m_inner.empty()) {
+        auto& center = registry.getComponent<SquadMember>(squad.members[next++]);
+        center.slotOffset = sf::Vector2f(0.f, 0.f);
+    }
+
+    // 内圈依次填满，外圈从内圈之后的下一圈开始，保证战斗人员整圈在外
+    int ring = 1;
+    size_t remaining = m_inner.empty() ? 0 : m_inner.size() - 1;
+    while (remaining > 0) {
+        const size_t count = std::min(remaining, static_cast<size_t>(6 * ring));
+        placeRing(squad.members, next, ring, count, m_spacing, registry);
+        remaining -= count;
+        ++ring;
+    }
+
+    remaining = m_outer.size();
+    if (m_inner.empty()) {
+        // 全是战斗人员：领队也是战斗人员，居中
+        registry.getComponent<SquadMember>(squad.members[next++]).slotOffset = sf::Vector2f(0.f, 0.f);
+        --remaining;
+    }
+    while (remaining > 0) {
+        const size_t count = std::min(remaining, static_cast<size_t>(6 * ring));
+        placeRing(squad.members, next, ring, count, m_spacing, registry);
+        remaining -= count;
+        ++ring;
+    }
+
+    squad.speed = 0.f;
+    for (auto entity : squad.members) {
+        auto& member = registry.getComponent<SquadMember>(entity);
+        member.leader = (entity == squad.leader);
+
+        const float maxSpeed = registry.getComponent<Velocity>(entity).maxSpeed;
+        squad.speed = squad.speed > 0.f ? std::min(squad.speed, maxSpeed) : maxSpeed;
+    }
+    squad.speed *= kLeaderPace;
+}
+
+void FormationSystem::update(float, Registry& registry, entt::entity player) {
+    if (m_squads.empty()) return;
+
+    if (auto* transform = registry.tryGetComponent<Transform>(player)) {
+        m_destination = transform->position;
+    }
+
+    // 1. 成员离队的小队重新列阵，然后移动领队
+    size_t activeSquads = 0;
+    size_t members = 0;
+    for (std::uint32_t id = 0; id < m_squads.size(); ++id) {
+        Squad& squad = m_squads[id];
+        if (squad.dirty) {
+            formSquad(registry, id);
+            ++m_stats.reforms;
+        }
+        if (!squad.active) {
+            m_leaderVelocity[id] = sf::Vector2f(0.f, 0.f);
+            continue;
+        }
+
+        m_leaderVelocity[id] = moveLeader(squad, registry);
+        squad.maxSlotError = 0.f;
+        ++activeSquads;
+        members += squad.members.size();
+    }
+    m_stats.squads = activeSquads;
+    m_stats.members = members;
+
+    // 2. 成员向阵位转向：跟随领队速度，加上与阵位误差成正比的修正
+    auto view = registry.view<SquadMember, Transform, Velocity>();
+    for (auto entity : view) {
+        auto& member = view.get<SquadMember>(entity);
+        if (member.leader) continue;
+
+        Squad& squad = m_squads[member.squad];
+        const sf::Vector2f& leaderPosition = registry.getComponent<Transform>(squad.leader).position;
+        const sf::Vector2f& position = view.get<Transform>(entity).position;
+        auto& velocity = view.get<Velocity>(entity);
+
+        const sf::Vector2f error = leaderPosition + member.slotOffset - position;
+        sf::Vector2f desired = m_leaderVelocity[member.squad] + error * kSlotGain;
+        const float speed = lengthOf(desired);
+        if (speed > velocity.maxSpeed) {
+            desired *= velocity.maxSpeed / speed;
+        }
+        velocity.velocity = desired;
+        squad.maxSlotError = std::max(squad.maxSlotError, lengthOf(error));
+    }
+
+    // 3. 所有小队到达后解散
+    bool arrived = true;
+    for (const auto& squad : m_squads) {
+        if (!squad.active) continue;
+        const sf::Vector2f offset = registry.getComponent<Transform>(squad.leader).position - m_destination;
+        if (lengthOf(offset) > m_arriveDistance) {
+            arrived = false;
+            break;
+        }
+    }
+    if (arrived) {
+        NF_INFO("Mass migration complete ({} path requests, {} reforms)", m_stats.pathRequests, m_stats.reforms);
+        disband(registry);
+    }
+}
+
+sf::Vector2f FormationSystem::moveLeader(Squad& squad, Registry& registry) {
+    const sf::Vector2f& position = registry.getComponent<Transform>(squad.leader).position;
+    auto& velocity = registry.getComponent<Velocity>(squad.leader);
+
+    sf::Vector2f toDestination = m_destination - position;
+    if (lengthOf(toDestination) <= m_arriveDistance) {
+        velocity.velocity = sf::Vector2f(0.f, 0.f);
+        return velocity.velocity;
+    }
+
+    // 新领队、上次请求未被接受或目标移动较远：重新请求路径（请求期间直接朝目标走）
+    auto* follow = registry.tryGetComponent<PathFollow>(squad.leader);
+    if (m_pathService &&
+        (!follow || !follow->requested || lengthOf(follow->destination - m_destination) > m_repathDistance)) {
+        if (!follow) {
+            follow = &registry.addComponent<PathFollow>(squad.leader);
+        }
+        m_pathService->release(follow->handle);
+        follow->handle = m_pathService->request(position, m_destination);
+        follow->destination = m_destination;
+        follow->waypoints.clear();
+        follow->currentWaypoint = 0;
+
+        // 请求队列已满时下一帧重试
+        follow->requested = follow->handle != InvalidPathHandle;
+        if (follow->requested) {
+            ++m_stats.pathRequests;
+        }
+    }
+
+    sf::Vector2f target = m_destination;
+    if (follow) {
+        if (follow->handle != InvalidPathHandle && m_pathService->takeResult(follow->handle, follow->waypoints)) {
+            follow->handle = InvalidPathHandle;
+            follow->currentWaypoint = 0;
+        }
+        while (follow->currentWaypoint < follow->waypoints.size() &&
+               lengthOf(follow->waypoints[follow->currentWaypoint] - position) < 10.f) {
+            ++follow->currentWaypoint;
+        }
+        if (follow->currentWaypoint < follow->waypoints.size()) {
+            target = follow->waypoints[follow->currentWaypoint];
+        }
+    }
+
+    // 队形散开时放慢脚步等成员归位
+    float speed = squad.speed;
+    if (squad.maxSlotError > m_spacing * 4.f) {
+        speed *= kRegroupSlowdown;
+    }
+
+    const sf::Vector2f direction = target - position;
+    const float distance = lengthOf(direction);
+    velocity.velocity = distance > 0.f ? direction / distance * speed : sf::Vector2f(0.f, 0.f);
+    return velocity.velocity;
+}
+
+void FormationSystem::releaseLeader(Registry& registry, entt::entity leader) {
+    if (!registry.isValid(leader)) return;
+
+    if (auto* follow = registry.tryGetComponent<PathFollow>(leader)) {
+        if (m_pathService) {
+            m_pathService->release(follow->handle);
+        }
+        registry.removeComponent<PathFollow>(leader);
+    }
+}
+
+void FormationSystem::onMemberDestroyed(entt::registry& registry, entt::entity entity) {
+    if (m_disbanding) return;
+
+    const auto squadId = registry.get<SquadMember>(entity).squad;
+    if (squadId < m_squads.size()) {
+        m_squads[squadId].dirty = true;
+    }
+}
+
+} // namespace Nightfall
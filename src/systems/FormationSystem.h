@@ -0,0 +1,107 @@
+﻿#pragma once
+
+#include "../ecs/Registry.h"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Nightfall {
+
+class PathService;
+
+/// 行军统计
+struct FormationStats {
+    size_t squads{0};          // 行军中的小队
+    size_t members{0};         // 行军中的 NPC
+    size_t pathRequests{0};    // 本次迁移累计发出的寻路请求（只有领队请求）
+    size_t reforms{0};         // 本次迁移累计的重新列阵次数（成员死亡或领队更换）
+};
+
+/**
+ * @brief 阵型系统 - 全员迁移时让 NPC 以小队为单位结阵行军
+ *
+ * 功能：
+ * - 迁移指令把所有已招募的 NPC 按位置分成若干小队，每队一个领队
+ * - 只有领队经由寻路服务请求路径，寻路请求数随小队数而不是 NPC 数增长
+ * - 阵型为以领队为中心的同心圆：非战斗人员在内圈，战斗人员（带 Combat）在外圈
+ * - 其余成员只做局部转向：跟随领队速度，并向自己的阵位修正
+ * - 成员死亡时小队在下一次更新里自动重新列阵，领队死亡时由其他成员接替并重新请求路径
+ * - 行军期间成员没有行为树、不接任务板的工作；领队到达后小队解散，NPC 回到自动模式
+ *
+ * 在 AI 之后、移动系统之前更新，覆盖行为树写入的速度。
+ */
+class FormationSystem {
+public:
+    FormationSystem();
+    ~FormationSystem();
+
+    /// 监听成员的销毁以触发重新列阵（只能绑定一个 Registry）
+    void init(Registry& registry);
+    void update(float deltaTime, Registry& registry, entt::entity player);
+
+    void setPathService(PathService* pathService) { m_pathService = pathService; }
+
+    /**
+     * @brief 设置编队参数
+     * @param squadSize 每个小队的最大人数
+     * @param spacing 阵型中相邻两圈的间距（像素）
+     */
+    void setSquadSettings(int squadSize, float spacing);
+
+    /**
+     * @brief 设置行军参数
+     * @param arriveDistance 领队离目的地小于此距离时解散
+     * @param repathDistance 目标（玩家）移动超过此距离时领队重新请求路径
+     */
+    void setMarchSettings(float arriveDistance, float repathDistance);
+
+    /// 全员迁移：所有已招募的 NPC 结阵前往 destination（已在行军的小队重新编组）
+    void startMigration(Registry& registry, const sf::Vector2f& destination);
+
+    /// 解散所有小队
+    void disband(Registry& registry);
+
+    bool isMigrating() const { return !m_squads.empty(); }
+    const FormationStats& getStats() const { return m_stats; }
+
+private:
+    struct Squad {
+        entt::entity leader{entt::null};
+        std::vector<entt::entity> members;   // 含领队
+        float speed{0.f};                    // 领队行进速度（全队最慢成员决定）
+        float maxSlotError{0.f};             // 上一帧成员离阵位的最大距离
+        bool active{false};
+        bool dirty{false};                   // 有成员离队，需要重新列阵
+    };
+
+    /// 为小队选领队并重新分配阵位
+    void formSquad(Registry& registry, std::uint32_t squadId);
+
+    /// 领队沿路径走向目的地，返回领队速度
+    sf::Vector2f moveLeader(Squad& squad, Registry& registry);
+
+    void releaseLeader(Registry& registry, entt::entity leader);
+
+    void onMemberDestroyed(entt::registry& registry, entt::entity entity);
+
+    PathService* m_pathService{nullptr};
+
+    size_t m_squadSize{16};
+    float m_spacing{40.f};
+    float m_arriveDistance{150.f};
+    float m_repathDistance{256.f};
+
+    sf::Vector2f m_destination;
+    std::vector<Squad> m_squads;
+    std::vector<sf::Vector2f> m_leaderVelocity;   // 本帧各小队领队的速度（按小队编号）
+    bool m_disbanding{false};
+
+    // 列阵用的缓冲
+    std::vector<std::pair<std::uint64_t, entt::entity>> m_recruits;
+    std::vector<entt::entity> m_inner;
+    std::vector<entt::entity> m_outer;
+
+    FormationStats m_stats;
+};
+
+} // namespace Nightfall
@@ -9,14 +9,14 @@ void MovementSystem::init() {
 }
 
 void MovementSystem::update(float deltaTime, Registry& registry) {
-    // 遍历所有有 Transform 和 Velocity 组件的实体
-    registry.each<Transform, Velocity>([&](entt::entity entity, Transform& transform, Velocity& velocity) {
+    // 遍历所有有 Transform 和 Velocity 组件的实体（跳过休眠的实体），各实体互不影响，分区间并行
+    registry.parallel_each<Transform, Velocity>([this, deltaTime](entt::entity, Transform& transform, Velocity& velocity) {
         // 限制速度
         clampVelocity(velocity);
 
         // 更新位置
         transform.position += velocity.velocity * deltaTime;
-    });
+    }, entt::exclude<Asleep>);
 }
 
 void MovementSystem::clampVelocity(Velocity& velocity) const {
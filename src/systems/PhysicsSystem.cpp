@@ -1,4 +1,5 @@
 ﻿#include "PhysicsSystem.h"
+#include "CollisionKernel.h"
 #include "../ecs/Components.h"
 #include "../core/Logger.h"
 #include <cmath>
@@ -7,7 +8,8 @@ namespace Nightfall {
 
 PhysicsSystem::PhysicsSystem() 
     : m_worldBounds(sf::Vector2f(0.f, 0.f), sf::Vector2f(1280.f, 720.f)) {
-    NF_INFO("Physics system initialized");
+    m_layerMatrix.fill(CollisionLayer::All);
+    NF_INFO("Physics system initialized (narrowphase kernel: {})", CollisionKernel::getActivePathName());
 }
 
 PhysicsSystem::~PhysicsSystem() {
@@ -15,125 +17,452 @@ PhysicsSystem::~PhysicsSystem() {
 }
 
 void PhysicsSystem::update(float deltaTime, Registry& registry) {
-    updatePhysics(registry);
+    wakeMovingBodies(registry);
+    updatePhysics(deltaTime, registry);
     resolveCollisions(registry);
+    updateSleep(registry);
     enforceWorldBounds(registry);
 }
 
-void PhysicsSystem::updatePhysics(Registry& registry) {
-    // Apply gravity and physics forces if needed
-    // For now, basic velocity damping
-    auto view = registry.view<Transform, Velocity>();
+void PhysicsSystem::setSleepParameters(int sleepTicks, float sleepVelocity) {
+    m_sleepTicks = sleepTicks;
+    m_sleepVelocity = sleepVelocity;
+}
+
+void PhysicsSystem::wakeMovingBodies(Registry& registry) {
+    // Velocity is written directly by AI/input, so scan the sleepers for a non-zero velocity.
+    // Only sleeping bodies are visited, which is the cheap side of the partition.
+    // Sleepers under a newly placed static collider wake too, otherwise nothing would push them out.
+    m_sleepChanges.clear();
+    auto view = registry.view<Velocity, Asleep>();
     for (auto entity : view) {
-        auto& velocity = view.get<Velocity>(entity);
+        const auto& velocity = view.get<Velocity>(entity);
+        if (!m_sleepEnabled || velocity.velocity.x != 0.f || velocity.velocity.y != 0.f) {
+            m_sleepChanges.push_back(entity);
+            continue;
+        }
+        
+        if (!m_wakeRegions.empty()) {
+            const auto* transform = registry.tryGetComponent<Transform>(entity);
+            const auto* collider = registry.tryGetComponent<Collider>(entity);
+            if (!transform || !collider) continue;
+            
+            const sf::FloatRect bounds = getBounds(*transform, *collider);
+            for (const auto& region : m_wakeRegions) {
+                if (checkAABBCollision(bounds, region)) {
+                    m_sleepChanges.push_back(entity);
+                    break;
+                }
+            }
+        }
+    }
+    m_wakeRegions.clear();
+    
+    for (auto entity : m_sleepChanges) {
+        wakeBody(registry, entity);
+    }
+}
+
+void PhysicsSystem::updateSleep(Registry& registry) {
+    m_sleepChanges.clear();
+    
+    if (m_sleepEnabled) {
+        const float sleepVelocitySq = m_sleepVelocity * m_sleepVelocity;
+        auto view = registry.view<Velocity>(entt::exclude<Asleep>);
+        for (auto entity : view) {
+            auto& velocity = view.get<Velocity>(entity);
+            float speedSq = velocity.velocity.x * velocity.velocity.x + velocity.velocity.y * velocity.velocity.y;
+            
+            if (speedSq >= sleepVelocitySq) {
+                velocity.restTicks = 0;
+            } else if (++velocity.restTicks >= m_sleepTicks) {
+                m_sleepChanges.push_back(entity);
+            }
+        }
         
+        for (auto entity : m_sleepChanges) {
+            // Zero the residual velocity so the wake scan only reacts to new writes
+            registry.getComponent<Velocity>(entity).velocity = sf::Vector2f(0.f, 0.f);
+            registry.addComponent<Asleep>(entity);
+        }
+    }
+    
+    m_sleepingCount = registry.view<Asleep>().size();
+}
+
+void PhysicsSystem::wakeBody(Registry& registry, entt::entity entity) {
+    if (!registry.hasComponent<Asleep>(entity)) return;
+    
+    registry.removeComponent<Asleep>(entity);
+    registry.getComponent<Velocity>(entity).restTicks = 0;
+}
+
+void PhysicsSystem::updatePhysics(float deltaTime, Registry& registry) {
+    // Apply gravity and physics forces if needed
+    // For now, basic velocity damping: 0.95 per 1/60 s, scaled so the result
+    // does not depend on the tick rate
+    const float damping = std::pow(0.95f, deltaTime * 60.f);
+    
+    // Each body only touches its own velocity, so the ranges run in parallel
+    registry.parallel_each<Transform, Velocity>([damping](entt::entity, Transform&, Velocity& velocity) {
         // Apply friction/damping
-        const float damping = 0.95f;
         velocity.velocity.x *= damping;
         velocity.velocity.y *= damping;
         
         // Stop very slow movement
         if (std::abs(velocity.velocity.x) < 0.1f) velocity.velocity.x = 0.f;
         if (std::abs(velocity.velocity.y) < 0.1f) velocity.velocity.y = 0.f;
-    }
+    }, entt::exclude<Asleep>);
+}
+
+void PhysicsSystem::setCellSize(float cellSize) {
+    m_dynamicHash.setCellSize(cellSize);
 }
 
 void PhysicsSystem::resolveCollisions(Registry& registry) {
+    ++m_tick;
+    m_contactEvents.clear();
+    
+    if (m_broadphase == Broadphase::BruteForce) {
+        resolveCollisionsBruteForce(registry);
+    } else {
+        resolveCollisionsSpatialHash(registry);
+    }
+    
+    publishContactEvents(registry);
+}
+
+void PhysicsSystem::setLayerCollision(std::uint32_t layerA, std::uint32_t layerB, bool collide) {
+    int indexA = layerIndex(layerA);
+    int indexB = layerIndex(layerB);
+    if (collide) {
+        m_layerMatrix[indexA] |= layerB;
+        m_layerMatrix[indexB] |= layerA;
+    } else {
+        m_layerMatrix[indexA] &= ~layerB;
+        m_layerMatrix[indexB] &= ~layerA;
+    }
+}
+
+bool PhysicsSystem::layersCollide(std::uint32_t layerA, std::uint32_t layerB) const {
+    return (m_layerMatrix[layerIndex(layerA)] & layerB) != 0;
+}
+
+std::uint32_t PhysicsSystem::layerFromName(const std::string& name) {
+    if (name == "default")  return CollisionLayer::Default;
+    if (name == "player")   return CollisionLayer::Player;
+    if (name == "hostile")  return CollisionLayer::Hostile;
+    if (name == "npc")      return CollisionLayer::NPC;
+    if (name == "building") return CollisionLayer::Building;
+    if (name == "resource") return CollisionLayer::Resource;
+    if (name == "item")     return CollisionLayer::Item;
+    if (name == "trap")     return CollisionLayer::Trap;
+    return 0;
+}
+
+int PhysicsSystem::layerIndex(std::uint32_t layer) {
+    // Layers are single bits; an empty layer maps to bit 0
+    int index = 0;
+    while (index < 31 && !(layer & (1u << index))) {
+        ++index;
+    }
+    return index;
+}
+
+bool PhysicsSystem::shouldCollide(const Collider& a, const Collider& b) const {
+    return (a.mask & b.layer) && (b.mask & a.layer) && (m_layerMatrix[layerIndex(a.layer)] & b.layer);
+}
+
+void PhysicsSystem::recordContact(entt::entity entityA, const Collider& colliderA,
+                                  entt::entity entityB, const Collider& colliderB) {
+    const bool isTrigger = colliderA.isTrigger || colliderB.isTrigger;
+    
+    // a = the trigger side for trigger contacts, otherwise the lower id
+    entt::entity a = entityA;
+    entt::entity b = entityB;
+    if (isTrigger ? (!colliderA.isTrigger || (colliderB.isTrigger && entityB < entityA)) : entityB < entityA) {
+        std::swap(a, b);
+    }
+    
+    auto low = static_cast<std::uint64_t>(entt::to_integral(std::min(entityA, entityB)));
+    auto high = static_cast<std::uint64_t>(entt::to_integral(std::max(entityA, entityB)));
+    std::uint64_t key = (low << 32) | high;
+    
+    auto it = m_contactPairs.find(key);
+    if (it == m_contactPairs.end()) {
+        m_contactPairs.emplace(key, ContactPair{a, b, m_tick, isTrigger});
+        m_contactEvents.push_back({a, b, ContactEvent::Phase::Begin, isTrigger});
+    } else if (it->second.stamp != m_tick) {
+        it->second.stamp = m_tick;
+        m_contactEvents.push_back({a, b, ContactEvent::Phase::Persist, isTrigger});
+    }
+}
+
+void PhysicsSystem::publishContactEvents(Registry& registry) {
+    // Pairs not seen this tick have ended, unless neither side could have moved: pairs of
+    // sleeping/static bodies are skipped by the broadphase but are still touching
+    auto isResting = [&](entt::entity entity) {
+        return registry.isValid(entity) &&
+               (registry.hasComponent<Asleep>(entity) || registry.hasComponent<Static>(entity));
+    };
+    
+    for (auto it = m_contactPairs.begin(); it != m_contactPairs.end();) {
+        ContactPair& pair = it->second;
+        if (pair.stamp == m_tick) {
+            ++it;
+            continue;
+        }
+        
+        if (isResting(pair.a) && isResting(pair.b)) {
+            pair.stamp = m_tick;
+            m_contactEvents.push_back({pair.a, pair.b, ContactEvent::Phase::Persist, pair.isTrigger});
+            ++it;
+        } else {
+            m_contactEvents.push_back({pair.a, pair.b, ContactEvent::Phase::End, pair.isTrigger});
+            it = m_contactPairs.erase(it);
+        }
+    }
+}
+
+void PhysicsSystem::resolveCollisionsBruteForce(Registry& registry) {
     // Get all entities with collision boxes
     auto movingView = registry.view<Transform, Collider, Velocity>();
+    auto awakeView = registry.view<Transform, Collider, Velocity>(entt::exclude<Asleep>);
     auto staticView = registry.view<Transform, Collider, Static>();
     
-    // Check moving entities against static entities
-    for (auto movingEntity : movingView) {
-        auto& movingTransform = movingView.get<Transform>(movingEntity);
-        auto& movingCollider = movingView.get<Collider>(movingEntity);
-        
-        sf::FloatRect movingRect(
-            movingTransform.position - movingCollider.size / 2.f,
-            movingCollider.size
-        );
+    // Check moving entities against static entities (sleeping bodies have not moved)
+    for (auto movingEntity : awakeView) {
+        auto& movingTransform = awakeView.get<Transform>(movingEntity);
+        const auto& movingCollider = awakeView.get<Collider>(movingEntity);
+        sf::FloatRect movingRect = getBounds(movingTransform, movingCollider);
         
         for (auto staticEntity : staticView) {
             if (movingEntity == staticEntity) continue;
             
-            auto& staticTransform = staticView.get<Transform>(staticEntity);
-            auto& staticCollider = staticView.get<Collider>(staticEntity);
-            
-            sf::FloatRect staticRect(
-                staticTransform.position - staticCollider.size / 2.f,
-                staticCollider.size
-            );
+            const auto& staticCollider = staticView.get<Collider>(staticEntity);
+            if (!shouldCollide(movingCollider, staticCollider)) continue;
             
-            if (checkAABBCollision(movingRect, staticRect)) {
-                // Resolve collision by pushing moving entity out
-                sf::Vector2f correction = resolveCollision(movingRect, staticRect);
-                movingTransform.position += correction;
-                
-                // Stop velocity in collision direction
-                auto& velocity = movingView.get<Velocity>(movingEntity);
-                if (std::abs(correction.x) > std::abs(correction.y)) {
-                    velocity.velocity.x = 0.f;
-                } else {
-                    velocity.velocity.y = 0.f;
+            sf::FloatRect staticRect = getBounds(staticView.get<Transform>(staticEntity), staticCollider);
+            if (movingCollider.isTrigger || staticCollider.isTrigger) {
+                if (checkAABBCollision(movingRect, staticRect)) {
+                    recordContact(movingEntity, movingCollider, staticEntity, staticCollider);
                 }
+                continue;
+            }
+            if (resolveStaticContact(movingRect, staticRect, movingTransform, awakeView.get<Velocity>(movingEntity))) {
+                recordContact(movingEntity, movingCollider, staticEntity, staticCollider);
             }
         }
     }
     
     // Check moving entities against other moving entities
-    std::vector<entt::entity> movingEntities(movingView.begin(), movingView.end());
-    for (size_t i = 0; i < movingEntities.size(); ++i) {
-        for (size_t j = i + 1; j < movingEntities.size(); ++j) {
-            auto entityA = movingEntities[i];
-            auto entityB = movingEntities[j];
-            
-            auto& transformA = movingView.get<Transform>(entityA);
-            auto& colliderA = movingView.get<Collider>(entityA);
-            auto& velocityA = movingView.get<Velocity>(entityA);
-            
-            auto& transformB = movingView.get<Transform>(entityB);
-            auto& colliderB = movingView.get<Collider>(entityB);
-            auto& velocityB = movingView.get<Velocity>(entityB);
+    m_movingEntities.assign(movingView.begin(), movingView.end());
+    m_movingAsleep.clear();
+    for (auto entity : m_movingEntities) {
+        m_movingAsleep.push_back(registry.hasComponent<Asleep>(entity) ? 1 : 0);
+    }
+    
+    for (size_t i = 0; i < m_movingEntities.size(); ++i) {
+        for (size_t j = i + 1; j < m_movingEntities.size(); ++j) {
+            // Two sleeping bodies cannot have started touching
+            if (m_movingAsleep[i] && m_movingAsleep[j]) continue;
             
-            sf::FloatRect rectA(
-                transformA.position - colliderA.size / 2.f,
-                colliderA.size
-            );
+            auto entityA = m_movingEntities[i];
+            auto entityB = m_movingEntities[j];
+            const auto& colliderA = movingView.get<Collider>(entityA);
+            const auto& colliderB = movingView.get<Collider>(entityB);
+            if (!shouldCollide(colliderA, colliderB)) continue;
             
-            sf::FloatRect rectB(
-                transformB.position - colliderB.size / 2.f,
-                colliderB.size
-            );
+            if (colliderA.isTrigger || colliderB.isTrigger) {
+                if (checkAABBCollision(getBounds(movingView.get<Transform>(entityA), colliderA),
+                                       getBounds(movingView.get<Transform>(entityB), colliderB))) {
+                    recordContact(entityA, colliderA, entityB, colliderB);
+                }
+                continue;
+            }
             
-            if (checkAABBCollision(rectA, rectB)) {
-                // Simple elastic collision - push entities apart
-                sf::Vector2f delta = transformB.position - transformA.position;
-                float distance = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+            if (resolveDynamicPair(movingView.get<Transform>(entityA), colliderA, movingView.get<Velocity>(entityA),
+                                   movingView.get<Transform>(entityB), colliderB, movingView.get<Velocity>(entityB))) {
+                recordContact(entityA, colliderA, entityB, colliderB);
                 
-                if (distance > 0.f) {
-                    sf::Vector2f normal = delta / distance;
-                    float overlap = (colliderA.size.x + colliderB.size.x) / 2.f - distance;
-                    
-                    transformA.position -= normal * overlap * 0.5f;
-                    transformB.position += normal * overlap * 0.5f;
-                    
-                    // Exchange some velocity
-                    float relativeVelocity = (velocityB.velocity.x - velocityA.velocity.x) * normal.x + 
-                                            (velocityB.velocity.y - velocityA.velocity.y) * normal.y;
-                    
-                    if (relativeVelocity < 0.f) {
-                        float impulse = relativeVelocity * 0.5f;
-                        velocityA.velocity.x -= impulse * normal.x;
-                        velocityA.velocity.y -= impulse * normal.y;
-                        velocityB.velocity.x += impulse * normal.x;
-                        velocityB.velocity.y += impulse * normal.y;
-                    }
-                }
+                // A contact wakes the sleeping side
+                if (m_movingAsleep[i]) { wakeBody(registry, entityA); m_movingAsleep[i] = 0; }
+                if (m_movingAsleep[j]) { wakeBody(registry, entityB); m_movingAsleep[j] = 0; }
             }
         }
     }
 }
 
+void PhysicsSystem::resolveCollisionsSpatialHash(Registry& registry) {
+    auto movingView = registry.view<Transform, Collider, Velocity>();
+    auto awakeView = registry.view<Transform, Collider, Velocity>(entt::exclude<Asleep>);
+    const SpatialGrid& staticIndex = registry.getStaticIndex();
+    
+    // Statics live in the registry's persistent index; only query the cells each mover overlaps.
+    // Candidates are gathered into SoA buffers and tested/resolved by the batched kernel.
+    // Sleeping bodies have not moved, so they cannot have entered a static collider.
+    // Layer/mask filtering happens before a candidate enters the batch.
+    m_staticBatch.clear();
+    m_staticOwners.clear();
+    m_staticOthers.clear();
+    m_staticTrigger.clear();
+    for (auto movingEntity : awakeView) {
+        const auto& movingCollider = awakeView.get<Collider>(movingEntity);
+        sf::FloatRect movingRect = getBounds(awakeView.get<Transform>(movingEntity), movingCollider);
+        
+        staticIndex.query(movingRect, [&](entt::entity staticEntity, const sf::FloatRect& staticRect) {
+            if (staticEntity == movingEntity) return;
+            
+            const auto& staticCollider = registry.getComponent<Collider>(staticEntity);
+            if (!shouldCollide(movingCollider, staticCollider)) return;
+            
+            m_staticBatch.push(movingRect, staticRect);
+            m_staticOwners.push_back(movingEntity);
+            m_staticOthers.push_back(staticEntity);
+            m_staticTrigger.push_back(movingCollider.isTrigger || staticCollider.isTrigger ? 1 : 0);
+        });
+    }
+    
+    m_hits.clear();
+    CollisionKernel::findOverlaps(m_staticBatch, m_hits);
+    CollisionKernel::computePushOut(m_staticBatch, m_pushX, m_pushY);
+    
+    // Every push-out was computed from the mover's pre-correction bounds, exactly like the
+    // scalar path, so applying them in candidate order gives the same result
+    for (std::uint32_t index : m_hits) {
+        entt::entity movingEntity = m_staticOwners[index];
+        entt::entity staticEntity = m_staticOthers[index];
+        recordContact(movingEntity, movingView.get<Collider>(movingEntity),
+                      staticEntity, registry.getComponent<Collider>(staticEntity));
+        
+        // Trigger overlaps only produce contact events, no positional correction
+        if (m_staticTrigger[index]) continue;
+        
+        applyStaticCorrection(sf::Vector2f(m_pushX[index], m_pushY[index]),
+                              movingView.get<Transform>(movingEntity), movingView.get<Velocity>(movingEntity));
+    }
+    
+    // Rebuild the dynamic grid from post-correction positions; only pairs sharing a cell are tested.
+    // Sleeping bodies stay in the grid so awake bodies still collide with (and wake) them.
+    m_dynamicHash.clear();
+    m_movingEntities.clear();
+    m_movingAsleep.clear();
+    for (auto movingEntity : movingView) {
+        m_dynamicHash.insert(static_cast<std::uint32_t>(m_movingEntities.size()),
+                             getBounds(movingView.get<Transform>(movingEntity),
+                                       movingView.get<Collider>(movingEntity)));
+        m_movingEntities.push_back(movingEntity);
+        m_movingAsleep.push_back(registry.hasComponent<Asleep>(movingEntity) ? 1 : 0);
+    }
+    m_dynamicHash.build();
+    
+    m_dynamicBatch.clear();
+    m_dynamicPairs.clear();
+    m_dynamicPairIds.clear();
+    m_dynamicTrigger.clear();
+    m_dynamicHash.forEachPair([&](std::uint32_t idA, std::uint32_t idB) {
+        // Two sleeping bodies cannot have started touching
+        if (m_movingAsleep[idA] && m_movingAsleep[idB]) return;
+        
+        auto entityA = m_movingEntities[idA];
+        auto entityB = m_movingEntities[idB];
+        const auto& colliderA = movingView.get<Collider>(entityA);
+        const auto& colliderB = movingView.get<Collider>(entityB);
+        if (!shouldCollide(colliderA, colliderB)) return;
+        
+        m_dynamicBatch.push(getBounds(movingView.get<Transform>(entityA), colliderA),
+                            getBounds(movingView.get<Transform>(entityB), colliderB));
+        m_dynamicPairs.emplace_back(entityA, entityB);
+        m_dynamicPairIds.emplace_back(idA, idB);
+        m_dynamicTrigger.push_back(colliderA.isTrigger || colliderB.isTrigger ? 1 : 0);
+    });
+    
+    // The kernel rejects non-overlapping pairs in bulk; survivors are resolved in order and
+    // re-checked against current positions, since earlier pairs this tick may have separated them
+    m_hits.clear();
+    CollisionKernel::findOverlaps(m_dynamicBatch, m_hits);
+    for (std::uint32_t index : m_hits) {
+        auto entityA = m_dynamicPairs[index].first;
+        auto entityB = m_dynamicPairs[index].second;
+        
+        const auto& colliderA = movingView.get<Collider>(entityA);
+        const auto& colliderB = movingView.get<Collider>(entityB);
+        
+        if (m_dynamicTrigger[index]) {
+            recordContact(entityA, colliderA, entityB, colliderB);
+            continue;
+        }
+        
+        if (resolveDynamicPair(movingView.get<Transform>(entityA), colliderA, movingView.get<Velocity>(entityA),
+                               movingView.get<Transform>(entityB), colliderB, movingView.get<Velocity>(entityB))) {
+            recordContact(entityA, colliderA, entityB, colliderB);
+            
+            // A contact wakes the sleeping side
+            std::uint32_t idA = m_dynamicPairIds[index].first;
+            std::uint32_t idB = m_dynamicPairIds[index].second;
+            if (m_movingAsleep[idA]) { wakeBody(registry, entityA); m_movingAsleep[idA] = 0; }
+            if (m_movingAsleep[idB]) { wakeBody(registry, entityB); m_movingAsleep[idB] = 0; }
+        }
+    }
+}
+
+sf::FloatRect PhysicsSystem::getBounds(const Transform& transform, const Collider& collider) {
+    return sf::FloatRect(transform.position - collider.size / 2.f, collider.size);
+}
+
+bool PhysicsSystem::resolveStaticContact(const sf::FloatRect& movingRect, const sf::FloatRect& staticRect,
+                                         Transform& movingTransform, Velocity& velocity) {
+    if (!checkAABBCollision(movingRect, staticRect)) return false;
+    
+    // Resolve collision by pushing moving entity out
+    applyStaticCorrection(resolveCollision(movingRect, staticRect), movingTransform, velocity);
+    return true;
+}
+
+void PhysicsSystem::applyStaticCorrection(const sf::Vector2f& correction, Transform& movingTransform,
+                                          Velocity& velocity) {
+    movingTransform.position += correction;
+    
+    // Stop velocity in collision direction
+    if (std::abs(correction.x) > std::abs(correction.y)) {
+        velocity.velocity.x = 0.f;
+    } else {
+        velocity.velocity.y = 0.f;
+    }
+}
+
+bool PhysicsSystem::resolveDynamicPair(Transform& transformA, const Collider& colliderA, Velocity& velocityA,
+                                       Transform& transformB, const Collider& colliderB, Velocity& velocityB) {
+    // Bounds are rebuilt from current positions: earlier pairs this tick may have moved either entity
+    if (!checkAABBCollision(getBounds(transformA, colliderA), getBounds(transformB, colliderB))) return false;
+    
+    // Simple elastic collision - push entities apart
+    sf::Vector2f delta = transformB.position - transformA.position;
+    float distance = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+    
+    if (distance > 0.f) {
+        sf::Vector2f normal = delta / distance;
+        float overlap = (colliderA.size.x + colliderB.size.x) / 2.f - distance;
+        
+        transformA.position -= normal * overlap * 0.5f;
+        transformB.position += normal * overlap * 0.5f;
+        
+        // Exchange some velocity
+        float relativeVelocity = (velocityB.velocity.x - velocityA.velocity.x) * normal.x + 
+                                (velocityB.velocity.y - velocityA.velocity.y) * normal.y;
+        
+        if (relativeVelocity < 0.f) {
+            float impulse = relativeVelocity * 0.5f;
+            velocityA.velocity.x -= impulse * normal.x;
+            velocityA.velocity.y -= impulse * normal.y;
+            velocityB.velocity.x += impulse * normal.x;
+            velocityB.velocity.y += impulse * normal.y;
+        }
+    }
+    
+    return true;
+}
+
 void PhysicsSystem::enforceWorldBounds(Registry& registry) {
     auto view = registry.view<Transform, Collider>();
     
@@ -143,6 +472,7 @@ void PhysicsSystem::enforceWorldBounds(Registry& registry) {
         
         float halfWidth = collider.size.x / 2.f;
         float halfHeight = collider.size.y / 2.f;
+        const sf::Vector2f originalPosition = transform.position;
         
         // Clamp position to world bounds
         if (transform.position.x - halfWidth < m_worldBounds.position.x) {
@@ -169,6 +499,11 @@ void PhysicsSystem::enforceWorldBounds(Registry& registry) {
                 velocity->velocity.y = 0.f;
             }
         }
+        
+        // Static bodies that got clamped must notify the static index
+        if (transform.position != originalPosition && registry.hasComponent<Static>(entity)) {
+            registry.patchComponent<Transform>(entity);
+        }
     }
 }
 
@@ -1,12 +1,40 @@
 ﻿#pragma once
 
 #include "../ecs/Registry.h"
+#include "../utils/SpatialHash.h"
+#include "CollisionKernel.h"
 #include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace Nightfall {
 
 class PhysicsSystem {
 public:
+    /// Broadphase used to find candidate collision pairs
+    enum class Broadphase {
+        BruteForce,   // O(N²) reference path, kept for comparison
+        SpatialHash   // dynamic grid rebuilt every tick + persistent static index
+    };
+
+    /// Contact event from the persistent contact-pair table
+    struct ContactEvent {
+        enum class Phase {
+            Begin,     // started touching this tick
+            Persist,   // still touching
+            End        // stopped touching (or one side was destroyed)
+        };
+
+        entt::entity a;    // the trigger collider for trigger contacts, otherwise the lower id
+        entt::entity b;
+        Phase phase;
+        bool isTrigger;    // overlap with a trigger (no positional correction was applied)
+    };
+
     PhysicsSystem();
     ~PhysicsSystem();
 
@@ -24,12 +52,96 @@ public:
     void setWorldBounds(const sf::FloatRect& bounds) { m_worldBounds = bounds; }
     const sf::FloatRect& getWorldBounds() const { return m_worldBounds; }
 
+    // Broadphase selection
+    void setBroadphase(Broadphase broadphase) { m_broadphase = broadphase; }
+    Broadphase getBroadphase() const { return m_broadphase; }
+    void setCellSize(float cellSize);
+
+    // Sleeping: bodies below sleepVelocity for sleepTicks consecutive ticks get the Asleep tag
+    void setSleepEnabled(bool enabled) { m_sleepEnabled = enabled; }
+    void setSleepParameters(int sleepTicks, float sleepVelocity);
+    size_t getSleepingCount() const { return m_sleepingCount; }
+
+    /// Wake every sleeping body overlapping region at the start of the next update, so the
+    /// static pass pushes it out (call when a static collider is placed, e.g. a new building)
+    void wakeRegion(const sf::FloatRect& region) { m_wakeRegions.push_back(region); }
+
+    // Collision filtering: a pair is considered only if each collider's mask contains the
+    // other's layer and the layer matrix allows the layer pair (all pairs allowed by default)
+    void setLayerCollision(std::uint32_t layerA, std::uint32_t layerB, bool collide);
+    bool layersCollide(std::uint32_t layerA, std::uint32_t layerB) const;
+    static std::uint32_t layerFromName(const std::string& name);   // 0 if unknown
+
+    /// Contact events (solid and trigger) produced by the last update, in one batch.
+    /// Every touching pair appears once per update as Begin or Persist; read them before the
+    /// next physics update. Entities in End events may already be destroyed.
+    const std::vector<ContactEvent>& getContactEvents() const { return m_contactEvents; }
+
 private:
-    void updatePhysics(Registry& registry);
+    void wakeMovingBodies(Registry& registry);
+    void updateSleep(Registry& registry);
+    static void wakeBody(Registry& registry, entt::entity entity);
+    void updatePhysics(float deltaTime, Registry& registry);
     void resolveCollisions(Registry& registry);
+    void resolveCollisionsBruteForce(Registry& registry);
+    void resolveCollisionsSpatialHash(Registry& registry);
     void enforceWorldBounds(Registry& registry);
+
+    // Narrowphase shared by both broadphase paths
+    static sf::FloatRect getBounds(const Transform& transform, const Collider& collider);
+    static bool resolveStaticContact(const sf::FloatRect& movingRect, const sf::FloatRect& staticRect,
+                                     Transform& movingTransform, Velocity& velocity);
+    static void applyStaticCorrection(const sf::Vector2f& correction, Transform& movingTransform,
+                                      Velocity& velocity);
+    static bool resolveDynamicPair(Transform& transformA, const Collider& colliderA, Velocity& velocityA,
+                                   Transform& transformB, const Collider& colliderB, Velocity& velocityB);
+
+    // Filtering and contact tracking
+    bool shouldCollide(const Collider& a, const Collider& b) const;
+    static int layerIndex(std::uint32_t layer);
+    void recordContact(entt::entity entityA, const Collider& colliderA,
+                       entt::entity entityB, const Collider& colliderB);
+    void publishContactEvents(Registry& registry);
     
     sf::FloatRect m_worldBounds;
+
+    Broadphase m_broadphase{Broadphase::SpatialHash};
+    SpatialHash m_dynamicHash;
+    std::vector<entt::entity> m_movingEntities;   // m_dynamicHash id -> entity
+    std::vector<std::uint8_t> m_movingAsleep;     // m_dynamicHash id -> has Asleep
+
+    bool m_sleepEnabled{true};
+    int m_sleepTicks{30};
+    float m_sleepVelocity{1.f};
+    size_t m_sleepingCount{0};
+    std::vector<entt::entity> m_sleepChanges;     // deferred Asleep add/remove
+    std::vector<sf::FloatRect> m_wakeRegions;     // regions covered by new static colliders
+
+    std::array<std::uint32_t, 32> m_layerMatrix;  // layer index -> layers it collides with
+
+    // Persistent contact pairs, keyed by (lower entity id << 32 | higher entity id)
+    struct ContactPair {
+        entt::entity a;
+        entt::entity b;
+        std::uint32_t stamp;   // last tick the pair was seen touching
+        bool isTrigger;
+    };
+    std::unordered_map<std::uint64_t, ContactPair> m_contactPairs;
+    std::vector<ContactEvent> m_contactEvents;
+    std::uint32_t m_tick{0};
+
+    // Batched narrowphase scratch (reused every tick)
+    AABBPairBatch m_staticBatch;
+    std::vector<entt::entity> m_staticOwners;     // m_staticBatch index -> moving entity
+    std::vector<entt::entity> m_staticOthers;     // m_staticBatch index -> static entity
+    std::vector<std::uint8_t> m_staticTrigger;    // m_staticBatch index -> trigger pair
+    AABBPairBatch m_dynamicBatch;
+    std::vector<std::pair<entt::entity, entt::entity>> m_dynamicPairs;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> m_dynamicPairIds;   // m_dynamicPairs -> hash ids
+    std::vector<std::uint8_t> m_dynamicTrigger;   // m_dynamicPairs index -> trigger pair
+    std::vector<std::uint32_t> m_hits;
+    std::vector<float> m_pushX;
+    std::vector<float> m_pushY;
 };
 
 } // namespace Nightfall
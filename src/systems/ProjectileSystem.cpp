@@ -0,0 +1,226 @@
+﻿#include "ProjectileSystem.h"
+#include "CombatSystem.h"
+#include "../ecs/Components.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Nightfall {
+
+ProjectileSystem::ProjectileSystem()
+    : m_vertices(sf::PrimitiveType::Lines) {
+}
+
+ProjectileSystem::~ProjectileSystem() {
+    NF_INFO("Projectile system shutdown");
+}
+
+void ProjectileSystem::init() {
+    setCapacity(m_capacity);
+    NF_INFO("Projectile system initialized (capacity: {})", m_capacity);
+}
+
+void ProjectileSystem::setCapacity(size_t capacity) {
+    m_capacity = capacity;
+    m_posX.reserve(capacity);
+    m_posY.reserve(capacity);
+    m_prevX.reserve(capacity);
+    m_prevY.reserve(capacity);
+    m_velX.reserve(capacity);
+    m_velY.reserve(capacity);
+    m_damage.reserve(capacity);
+    m_lifetime.reserve(capacity);
+    m_owner.reserve(capacity);
+}
+
+bool ProjectileSystem::spawn(entt::entity owner, const sf::Vector2f& from, const sf::Vector2f& direction,
+                             float speed, float damage, float maxDistance) {
+    if (m_posX.size() >= m_capacity || speed <= 0.f) {
+        return false;
+    }
+
+    float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    if (length <= 0.f) {
+        return false;
+    }
+
+    m_posX.push_back(from.x);
+    m_posY.push_back(from.y);
+    m_prevX.push_back(from.x);
+    m_prevY.push_back(from.y);
+    m_velX.push_back(direction.x / length * speed);
+    m_velY.push_back(direction.y / length * speed);
+    m_damage.push_back(damage);
+    m_lifetime.push_back(maxDistance / speed);
+    m_owner.push_back(owner);
+    return true;
+}
+
+void ProjectileSystem::update(float deltaTime, Registry& registry) {
+    if (m_posX.empty()) return;
+
+    rebuildHostileGrid(registry);
+
+    const size_t count = m_posX.size();
+    m_hits.clear();
+    m_expired.assign(count, 0);
+
+    // 批量推进所有子弹：本帧的运动线段与网格中的敌对单位做扫掠检测
+    for (size_t i = 0; i < count; ++i) {
+        const float x0 = m_posX[i];
+        const float y0 = m_posY[i];
+        const float dx = m_velX[i] * deltaTime;
+        const float dy = m_velY[i] * deltaTime;
+
+        m_prevX[i] = x0;
+        m_prevY[i] = y0;
+
+        // 线段的包围盒
+        sf::FloatRect sweep(sf::Vector2f(std::min(x0, x0 + dx), std::min(y0, y0 + dy)),
+                            sf::Vector2f(std::abs(dx), std::abs(dy)));
+
+        float bestT = 2.f;
+        entt::entity bestTarget = entt::null;
+        m_hostileHash.query(sweep, [&](std::uint32_t id, const sf::FloatRect& bounds) {
+            float t;
+            if (segmentIntersectsAABB(x0, y0, dx, dy, bounds, t) && t < bestT) {
+                bestT = t;
+                bestTarget = m_hostileEntities[id];
+            }
+        });
+
+        if (bestTarget != entt::null) {
+            // 命中：停在命中点，遍历结束后结算伤害
+            m_posX[i] = x0 + dx * bestT;
+            m_posY[i] = y0 + dy * bestT;
+            m_hits.push_back({static_cast<std::uint32_t>(i), bestTarget});
+            m_expired[i] = 1;
+            continue;
+        }
+
+        m_posX[i] = x0 + dx;
+        m_posY[i] = y0 + dy;
+        m_lifetime[i] -= deltaTime;
+        if (m_lifetime[i] <= 0.f) {
+            m_expired[i] = 1;
+        }
+    }
+
+    // 结算伤害（同一目标可能在本帧被前面的子弹击杀）
+    if (m_combatSystem) {
+        for (const Hit& hit : m_hits) {
+            if (!registry.isValid(hit.target)) continue;
+
+            const auto* health = registry.tryGetComponent<Health>(hit.target);
+            if (health && health->isDead()) continue;
+
+            m_combatSystem->applyDamage(m_owner[hit.projectile], hit.target, m_damage[hit.projectile], registry);
+        }
+    }
+
+    // 从后往前交换删除命中或超出射程的子弹，保持池连续
+    for (size_t i = count; i-- > 0;) {
+        if (m_expired[i]) {
+            removeAt(i);
+        }
+    }
+}
+
+void ProjectileSystem::render(sf::RenderWindow& window, const sf::Vector2f& cameraPosition) {
+    if (m_posX.empty()) return;
+
+    // 所有子弹合并为一次绘制：从上一帧位置到当前位置的黄色拖尾
+    m_vertices.resize(m_posX.size() * 2);
+    for (size_t i = 0; i < m_posX.size(); ++i) {
+        m_vertices[i * 2].position = sf::Vector2f(m_prevX[i], m_prevY[i]);
+        m_vertices[i * 2].color = sf::Color(255, 255, 0, 120);
+        m_vertices[i * 2 + 1].position = sf::Vector2f(m_posX[i], m_posY[i]);
+        m_vertices[i * 2 + 1].color = sf::Color::Yellow;
+    }
+
+    // 子弹坐标是世界坐标，与精灵一样减去相机位置
+    sf::RenderStates states;
+    states.transform.translate(-cameraPosition);
+    window.draw(m_vertices, states);
+}
+
+void ProjectileSystem::rebuildHostileGrid(Registry& registry) {
+    m_hostileHash.clear();
+    m_hostileEntities.clear();
+
+    auto view = registry.view<Transform, Collider, Hostile>();
+    for (auto entity : view) {
+        const auto* health = registry.tryGetComponent<Health>(entity);
+        if (health && health->isDead()) continue;
+
+        const auto& transform = view.get<Transform>(entity);
+        const auto& collider = view.get<Collider>(entity);
+        m_hostileHash.insert(static_cast<std::uint32_t>(m_hostileEntities.size()),
+                             sf::FloatRect(transform.position - collider.size / 2.f, collider.size));
+        m_hostileEntities.push_back(entity);
+    }
+
+    m_hostileHash.build();
+}
+
+bool ProjectileSystem::segmentIntersectsAABB(float x0, float y0, float dx, float dy,
+                                             const sf::FloatRect& bounds, float& tHit) {
+    float tMin = 0.f;
+    float tMax = 1.f;
+
+    const float origin[2] = {x0, y0};
+    const float delta[2] = {dx, dy};
+    const float boxMin[2] = {bounds.position.x, bounds.position.y};
+    const float boxMax[2] = {bounds.position.x + bounds.size.x, bounds.position.y + bounds.size.y};
+
+    for (int axis = 0; axis < 2; ++axis) {
+        if (std::abs(delta[axis]) < 1e-8f) {
+            // 与该轴平行：起点必须在 slab 内
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) {
+                return false;
+            }
+            continue;
+        }
+
+        float invDelta = 1.f / delta[axis];
+        float t1 = (boxMin[axis] - origin[axis]) * invDelta;
+        float t2 = (boxMax[axis] - origin[axis]) * invDelta;
+        if (t1 > t2) std::swap(t1, t2);
+
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) {
+            return false;
+        }
+    }
+
+    tHit = tMin;
+    return true;
+}
+
+void ProjectileSystem::removeAt(size_t index) {
+    const size_t last = m_posX.size() - 1;
+    if (index != last) {
+        m_posX[index] = m_posX[last];
+        m_posY[index] = m_posY[last];
+        m_prevX[index] = m_prevX[last];
+        m_prevY[index] = m_prevY[last];
+        m_velX[index] = m_velX[last];
+        m_velY[index] = m_velY[last];
+        m_damage[index] = m_damage[last];
+        m_lifetime[index] = m_lifetime[last];
+        m_owner[index] = m_owner[last];
+    }
+
+    m_posX.pop_back();
+    m_posY.pop_back();
+    m_prevX.pop_back();
+    m_prevY.pop_back();
+    m_velX.pop_back();
+    m_velY.pop_back();
+    m_damage.pop_back();
+    m_lifetime.pop_back();
+    m_owner.pop_back();
+}
+
+} // namespace Nightfall
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include "../ecs/Registry.h"
+#include "../utils/SpatialHash.h"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Nightfall {
+
+class CombatSystem;
+
+/**
+ * @brief 弹道系统 - 模拟炮塔等发射的子弹
+ *
+ * 功能：
+ * - 子弹存放在连续的 SoA 池中，而不是完整的 ECS 实体
+ * - 每帧重建敌对单位的均匀网格，子弹按本帧的运动线段做扫掠检测，高速子弹不会穿透
+ * - 命中在一次批量遍历中收集，遍历结束后统一通过 CombatSystem 结算伤害
+ */
+class ProjectileSystem {
+public:
+    ProjectileSystem();
+    ~ProjectileSystem();
+
+    void init();
+    void update(float deltaTime, Registry& registry);
+    void render(sf::RenderWindow& window, const sf::Vector2f& cameraPosition);
+
+    void setCombatSystem(CombatSystem* combatSystem) { m_combatSystem = combatSystem; }
+
+    /// 设置敌对单位网格的格子边长（像素）
+    void setCellSize(float cellSize) { m_hostileHash.setCellSize(cellSize); }
+
+    /// 设置子弹池容量（池满时新的子弹被丢弃）
+    void setCapacity(size_t capacity);
+
+    /**
+     * @brief 发射一颗子弹
+     * @param owner 发射者（结算伤害时作为攻击者）
+     * @param from 起点
+     * @param direction 方向（不要求归一化）
+     * @param speed 速度（像素/秒）
+     * @param damage 命中伤害
+     * @param maxDistance 最大飞行距离，超过后消失
+     * @return 池已满时返回 false
+     */
+    bool spawn(entt::entity owner, const sf::Vector2f& from, const sf::Vector2f& direction,
+               float speed, float damage, float maxDistance);
+
+    /// 当前存活的子弹数量
+    size_t getActiveCount() const { return m_posX.size(); }
+
+private:
+    /// 命中记录（遍历结束后统一结算）
+    struct Hit {
+        std::uint32_t projectile;
+        entt::entity target;
+    };
+
+    /// 重建敌对单位网格
+    void rebuildHostileGrid(Registry& registry);
+
+    /// 线段 p0 + t * delta（t ∈ [0, 1]）与 AABB 的相交测试（slab 法），命中时写入最早的 t
+    static bool segmentIntersectsAABB(float x0, float y0, float dx, float dy,
+                                      const sf::FloatRect& bounds, float& tHit);
+
+    /// 交换删除第 index 颗子弹
+    void removeAt(size_t index);
+
+    CombatSystem* m_combatSystem{nullptr};
+
+    // 子弹池（SoA，下标一致）
+    std::vector<float> m_posX;
+    std::vector<float> m_posY;
+    std::vector<float> m_prevX;         // 上一帧位置（渲染拖尾）
+    std::vector<float> m_prevY;
+    std::vector<float> m_velX;
+    std::vector<float> m_velY;
+    std::vector<float> m_damage;
+    std::vector<float> m_lifetime;      // 剩余飞行时间（秒）
+    std::vector<entt::entity> m_owner;
+    size_t m_capacity{4096};
+
+    // 敌对单位网格（每帧重建）
+    SpatialHash m_hostileHash;
+    std::vector<entt::entity> m_hostileEntities;   // m_hostileHash id -> entity
+
+    std::vector<Hit> m_hits;
+    std::vector<std::uint8_t> m_expired;
+    sf::VertexArray m_vertices;
+};
+
+} // namespace Nightfall
@@ -10,7 +10,7 @@ void RenderingSystem::init() {
     NF_INFO("渲染系统初始化");
 }
 
-void RenderingSystem::render(sf::RenderWindow& window, Registry& registry) {
+void RenderingSystem::render(sf::RenderWindow& window, Registry& registry, float alpha) {
     // 收集所有需要渲染的实体
     struct RenderData {
         entt::entity entity;
@@ -50,8 +50,10 @@ void RenderingSystem::render(sf::RenderWindow& window, Registry& registry) {
         // 创建临时精灵对象
         sf::Sprite drawableSprite(*texture);
         
-        // 设置变换
-        drawableSprite.setPosition(data.transform->position - m_cameraPosition);
+        // 设置变换（位置在两个逻辑帧之间插值）
+        const sf::Vector2f& previous = data.transform->previousPosition;
+        sf::Vector2f position = previous + (data.transform->position - previous) * alpha;
+        drawableSprite.setPosition(position - m_cameraPosition);
         drawableSprite.setRotation(sf::degrees(data.transform->rotation));
         
         // 如果有碰撞体，根据碰撞体大小缩放精灵
@@ -18,7 +18,8 @@ public:
     /// 渲染所有实体
     /// @param window 渲染目标窗口
     /// @param registry ECS 注册表
-    void render(sf::RenderWindow& window, Registry& registry);
+    /// @param alpha 插值系数：在上一逻辑帧与当前逻辑帧的位置之间插值（0~1）
+    void render(sf::RenderWindow& window, Registry& registry, float alpha = 1.f);
 
     /// 设置相机位置（用于视角跟随）
     void setCameraPosition(const sf::Vector2f& position);
@@ -34,6 +34,11 @@ void ResourceSystem::update(float deltaTime, Registry& registry) {
                      static_cast<uint32_t>(entity),
                      producer.productionAmount,
                      producer.resourceType);
+            
+            // 料用完后停工
+            if (producer.refillCycles > 0 && ++producer.cyclesSinceRefill >= producer.refillCycles) {
+                producer.isActive = false;
+            }
         }
     }
     
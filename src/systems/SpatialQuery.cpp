@@ -0,0 +1,68 @@
+﻿#include "SpatialQuery.h"
+#include "../ecs/Components.h"
+#include "../core/Logger.h"
+
+namespace Nightfall {
+
+SpatialQuery::SpatialQuery() {
+}
+
+SpatialQuery::~SpatialQuery() {
+    NF_INFO("Spatial query shutdown");
+}
+
+void SpatialQuery::init(Registry& registry) {
+    auto& raw = registry.raw();
+    raw.on_destroy<Hostile>().connect<&SpatialQuery::onRemoved<SpatialCategory::Hostile>>(*this);
+    raw.on_destroy<Building>().connect<&SpatialQuery::onRemoved<SpatialCategory::Building>>(*this);
+    raw.on_destroy<ResourceNode>().connect<&SpatialQuery::onRemoved<SpatialCategory::ResourceNode>>(*this);
+    raw.on_destroy<Dropped>().connect<&SpatialQuery::onRemoved<SpatialCategory::Item>>(*this);
+    raw.on_construct<Disabled>().connect<&SpatialQuery::onDisabled>(*this);
+
+    NF_INFO("Spatial query initialized");
+}
+
+void SpatialQuery::update(Registry& registry) {
+    // 移动的分类每帧同步（格子不变时只原地更新包围盒）
+    syncCategory<Hostile>(SpatialCategory::Hostile, registry);
+
+    // 建筑、资源节点和掉落物都是静态碰撞体，只在静态索引变化时重新同步
+    std::uint32_t staticVersion = registry.getStaticIndex().getVersion();
+    if (!m_staticSynced || staticVersion != m_staticVersion) {
+        syncCategory<Building>(SpatialCategory::Building, registry);
+        syncCategory<ResourceNode>(SpatialCategory::ResourceNode, registry);
+        syncCategory<Dropped>(SpatialCategory::Item, registry);
+        m_staticVersion = staticVersion;
+        m_staticSynced = true;
+    }
+}
+
+template<typename Tag>
+void SpatialQuery::syncCategory(SpatialCategory category, Registry& registry) {
+    SpatialGrid& target = grid(category);
+
+    auto view = registry.view<Transform, Tag>();
+    for (auto entity : view) {
+        const auto& transform = view.template get<Transform>(entity);
+
+        // 有碰撞箱的用碰撞箱，否则按点处理
+        sf::Vector2f size(0.f, 0.f);
+        if (const auto* collider = registry.tryGetComponent<Collider>(entity)) {
+            size = collider->size;
+        }
+        target.insertOrUpdate(entity, sf::FloatRect(transform.position - size / 2.f, size));
+    }
+}
+
+template<SpatialCategory Category>
+void SpatialQuery::onRemoved(entt::registry&, entt::entity entity) {
+    grid(Category).remove(entity);
+}
+
+void SpatialQuery::onDisabled(entt::registry&, entt::entity entity) {
+    for (auto& categoryGrid : m_grids) {
+        categoryGrid.remove(entity);
+    }
+}
+
+} // namespace Nightfall
@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include "../ecs/Registry.h"
+#include "../ecs/SpatialGrid.h"
+#include <SFML/System/Vector2.hpp>
+#include <array>
+#include <vector>
+
+namespace Nightfall {
+
+/// 空间查询分类
+enum class SpatialCategory {
+    Hostile,        // 敌对单位（Hostile）
+    Building,       // 建筑（Building）
+    ResourceNode,   // 资源采集点（ResourceNode）
+    Item,           // 掉落物品（Dropped）
+    Count
+};
+
+/**
+ * @brief 空间查询服务 - 供各游戏系统共享的分类空间索引
+ *
+ * 功能：
+ * - 为敌对单位、建筑、资源节点、掉落物各维护一个 SpatialGrid
+ * - 半径查询、最近 K 个查询、AABB 查询，均支持过滤谓词
+ * - 实体或组件销毁时通过 EnTT 信号立即移出索引
+ *
+ * 移动的分类（敌对单位）每帧同步一次；
+ * 静态分类（建筑、资源节点、掉落物）只在静态碰撞体索引版本变化时同步。
+ */
+class SpatialQuery {
+public:
+    SpatialQuery();
+    ~SpatialQuery();
+
+    /// 连接组件销毁信号
+    void init(Registry& registry);
+
+    /// 同步索引（每帧在移动之后、查询之前调用）
+    void update(Registry& registry);
+
+    /// 半径查询：包围盒中心距离 center 不超过 radius 的实体，结果追加到 out
+    /// @param filter bool(entt::entity entity)
+    template<typename Filter>
+    void queryRadius(SpatialCategory category, const sf::Vector2f& center, float radius,
+                     std::vector<entt::entity>& out, Filter&& filter) const {
+        const float radiusSq = radius * radius;
+        sf::FloatRect area(center - sf::Vector2f(radius, radius), sf::Vector2f(radius, radius) * 2.f);
+        grid(category).query(area, [&](entt::entity entity, const sf::FloatRect& bounds) {
+            const sf::Vector2f entityCenter = bounds.position + bounds.size / 2.f;
+            const float dx = entityCenter.x - center.x;
+            const float dy = entityCenter.y - center.y;
+            if (dx * dx + dy * dy <= radiusSq && filter(entity)) {
+                out.push_back(entity);
+            }
+        });
+    }
+
+    /// 最近 K 个查询：结果按距离升序写入 out（至多 k 个）
+    template<typename Filter>
+    void nearestK(SpatialCategory category, const sf::Vector2f& center, float maxRadius, size_t k,
+                  std::vector<entt::entity>& out, Filter&& filter) const {
+        thread_local std::vector<std::pair<float, entt::entity>> scratch;
+        grid(category).nearestK(center, maxRadius, k, std::forward<Filter>(filter), scratch);
+        out.clear();
+        for (const auto& entry : scratch) {
+            out.push_back(entry.second);
+        }
+    }
+
+    /// 最近的一个实体（没有时返回 entt::null）
+    template<typename Filter>
+    entt::entity nearest(SpatialCategory category, const sf::Vector2f& center, float maxRadius,
+                         Filter&& filter) const {
+        thread_local std::vector<std::pair<float, entt::entity>> scratch;
+        grid(category).nearestK(center, maxRadius, 1, std::forward<Filter>(filter), scratch);
+        return scratch.empty() ? entt::null : scratch.front().second;
+    }
+
+    /// AABB 查询：遍历包围盒与区域所在格子重叠的实体
+    /// @param func void(entt::entity entity, const sf::FloatRect& bounds)
+    template<typename Func>
+    void queryAABB(SpatialCategory category, const sf::FloatRect& area, Func&& func) const {
+        grid(category).query(area, std::forward<Func>(func));
+    }
+
+    /// 分类中的实体数量
+    size_t getCount(SpatialCategory category) const { return grid(category).size(); }
+
+private:
+    const SpatialGrid& grid(SpatialCategory category) const { return m_grids[static_cast<size_t>(category)]; }
+    SpatialGrid& grid(SpatialCategory category) { return m_grids[static_cast<size_t>(category)]; }
+
+    /// 同步某个分类中带 Tag 组件的所有实体
+    template<typename Tag>
+    void syncCategory(SpatialCategory category, Registry& registry);
+
+    /// 组件被移除或实体被销毁
+    template<SpatialCategory Category>
+    void onRemoved(entt::registry& registry, entt::entity entity);
+
+    /// 实体停放到对象池（复用后由 syncCategory 重新加入）
+    void onDisabled(entt::registry& registry, entt::entity entity);
+
+    std::array<SpatialGrid, static_cast<size_t>(SpatialCategory::Count)> m_grids;
+    std::uint32_t m_staticVersion{0};   // 上次同步静态分类时的静态索引版本
+    bool m_staticSynced{false};
+};
+
+} // namespace Nightfall
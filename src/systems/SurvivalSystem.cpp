@@ -1 +1,37 @@
-﻿
\ No newline at end of file
+﻿#include "SurvivalSystem.h"
+#include "../core/Logger.h"
+#include <algorithm>
+
+namespace Nightfall {
+
+void SurvivalSystem::init() {
+    NF_INFO("生存系统初始化");
+}
+
+void SurvivalSystem::update(float deltaTime, Registry& registry) {
+    if (!m_enabled) return;
+
+    // 饱食度下降（NPC 由行为树的 eat 叶子补充），低于阈值后扣血
+    const bool starvationDamage = m_starvationDamage;
+    registry.parallel_each<Hunger, Health>([deltaTime, starvationDamage](entt::entity, Hunger& hunger, Health& health) {
+        hunger.current = std::max(0.f, hunger.current - hunger.drainRate * deltaTime);
+
+        if (starvationDamage && hunger.isStarving() && !health.invincible) {
+            health.current = std::max(0.f, health.current - hunger.damageRate * deltaTime);
+        }
+    });
+
+    // 耐力恢复
+    registry.parallel_each<Stamina>([deltaTime](entt::entity, Stamina& stamina) {
+        stamina.current = std::min(stamina.maximum, stamina.current + stamina.regeneration * deltaTime);
+    });
+
+    // 生命恢复（已死亡的实体不再恢复）
+    registry.parallel_each<Health>([deltaTime](entt::entity, Health& health) {
+        if (health.regeneration > 0.f && !health.isDead()) {
+            health.current = std::min(health.maximum, health.current + health.regeneration * deltaTime);
+        }
+    });
+}
+
+} // namespace Nightfall
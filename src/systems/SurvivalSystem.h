@@ -1 +1,34 @@
-﻿
\ No newline at end of file
+﻿#pragma once
+
+#include "../ecs/Registry.h"
+
+namespace Nightfall {
+
+/// 生存系统
+/// 每个逻辑帧消耗饱食度、恢复耐力和生命；开启饥饿伤害时，饥饿的实体按 Hunger::damageRate 扣血
+/// 死亡由战斗系统在下一逻辑帧统一清理，这里只改写已有组件，各实体互不影响，分区间并行
+class SurvivalSystem {
+public:
+    SurvivalSystem() = default;
+    ~SurvivalSystem() = default;
+
+    /// 初始化生存系统
+    void init();
+
+    /// 更新所有实体的生存状态
+    /// @param deltaTime 帧时间间隔（秒）
+    /// @param registry ECS 注册表
+    void update(float deltaTime, Registry& registry);
+
+    /// 是否启用（关闭后饱食度不再下降，耐力与生命也不再恢复）
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+
+    /// 饥饿时是否扣血
+    void setStarvationDamage(bool enabled) { m_starvationDamage = enabled; }
+
+private:
+    bool m_enabled{true};
+    bool m_starvationDamage{false};
+};
+
+} // namespace Nightfall
@@ -1,6 +1,8 @@
 ﻿#include "TurretSystem.h"
 #include "CombatSystem.h"
 #include "VisualEffectsSystem.h"
+#include "SpatialQuery.h"
+#include "ProjectileSystem.h"
 #include "../ecs/Components.h"
 #include "../core/Logger.h"
 #include <cmath>
@@ -40,8 +42,10 @@ void TurretSystem::updateTurret(entt::entity turretEntity, float deltaTime, Regi
         turret.attackCooldown -= deltaTime;
     }
     
-    // 如果有当前目标，检查是否还在范围内且存活
-    if (registry.isValid(turret.currentTarget)) {
+    // 如果有当前目标，检查是否还在范围内且存活（被回收或已复用为另一只僵尸时代数不同）
+    if (turret.currentTarget != entt::null && !registry.isValid(turret.currentTarget, turret.targetGeneration)) {
+        turret.currentTarget = entt::null;
+    } else if (turret.currentTarget != entt::null) {
         auto* targetHealth = registry.tryGetComponent<Health>(turret.currentTarget);
         auto* targetTransform = registry.tryGetComponent<Transform>(turret.currentTarget);
         
@@ -61,6 +65,7 @@ void TurretSystem::updateTurret(entt::entity turretEntity, float deltaTime, Regi
     // 如果没有目标，寻找新目标
     if (turret.currentTarget == entt::null) {
         turret.currentTarget = findNearestEnemy(transform.position, turret.range, registry);
+        turret.targetGeneration = registry.getGeneration(turret.currentTarget);
     }
     
     // 如果有目标且冷却完成，攻击
@@ -69,7 +74,7 @@ void TurretSystem::updateTurret(entt::entity turretEntity, float deltaTime, Regi
         turret.attackCooldown = 1.f / turret.attackSpeed; // 重置冷却
         
         // 攻击后检查目标是否仍然有效（可能已被击杀）
-        if (!registry.isValid(turret.currentTarget)) {
+        if (!registry.isValid(turret.currentTarget, turret.targetGeneration)) {
             turret.currentTarget = entt::null;
         } else {
             auto* targetHealth = registry.tryGetComponent<Health>(turret.currentTarget);
@@ -81,25 +86,13 @@ void TurretSystem::updateTurret(entt::entity turretEntity, float deltaTime, Regi
 }
 
 entt::entity TurretSystem::findNearestEnemy(const sf::Vector2f& position, float range, Registry& registry) {
-    entt::entity nearest = entt::null;
-    float nearestDistSq = range * range;
+    if (!m_spatialQuery) return entt::null;
     
-    // 搜索所有敌对实体
-    auto view = registry.view<Transform, Health, Hostile>();
-    for (auto entity : view) {
-        const auto& transform = view.get<Transform>(entity);
-        const auto& health = view.get<Health>(entity);
-        
-        if (health.isDead()) continue;
-        
-        float distSq = getDistanceSquared(position, transform.position);
-        if (distSq < nearestDistSq) {
-            nearestDistSq = distSq;
-            nearest = entity;
-        }
-    }
-    
-    return nearest;
+    // 只搜索射程内格子中的敌对实体
+    return m_spatialQuery->nearest(SpatialCategory::Hostile, position, range, [&](entt::entity entity) {
+        const auto* health = registry.tryGetComponent<Health>(entity);
+        return health && !health->isDead();
+    });
 }
 
 void TurretSystem::attackTarget(entt::entity turret, entt::entity target, Registry& registry) {
@@ -111,24 +104,26 @@ void TurretSystem::attackTarget(entt::entity turret, entt::entity target, Regist
     
     if (!targetTransform) return;
     
-    // 创建视觉效果
+    // 创建攻击线条(即时反馈)
     if (m_visualEffects) {
-        // 创建攻击线条(即时反馈)
         m_visualEffects->createAttackLine(turretTransform.position, targetTransform->position);
-        
-        // 创建子弹(视觉效果)
-        m_visualEffects->createBullet(turretTransform.position, targetTransform->position, registry);
     }
     
-    // 使用 CombatSystem 应用伤害
-    m_combatSystem->applyDamage(turret, target, turretComp.damage, registry);
+    if (m_projectileSystem) {
+        // 发射真实子弹，命中时由 ProjectileSystem 结算伤害（飞行距离留出余量以追上移动的目标）
+        m_projectileSystem->spawn(turret, turretTransform.position,
+                                  targetTransform->position - turretTransform.position,
+                                  turretComp.projectileSpeed, turretComp.damage, turretComp.range * 1.5f);
+    } else {
+        // 没有弹道系统时即时结算伤害
+        m_combatSystem->applyDamage(turret, target, turretComp.damage, registry);
+    }
     
-    NF_DEBUG("Turret {} attacked enemy {} for {} damage", 
+    NF_DEBUG("Turret {} fired at enemy {} ({} damage)", 
              static_cast<uint32_t>(turret),
              static_cast<uint32_t>(target),
              turretComp.damage);
     
-    // TODO: 创建子弹实体
     // TODO: 播放攻击音效
 }
 
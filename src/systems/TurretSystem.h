@@ -7,6 +7,8 @@ namespace Nightfall {
 
 class CombatSystem;
 class VisualEffectsSystem;
+class SpatialQuery;
+class ProjectileSystem;
 
 /// 炮塔系统 - 处理炮塔自动瞄准和攻击
 class TurretSystem {
@@ -19,6 +21,8 @@ public:
     
     void setCombatSystem(CombatSystem* combatSystem) { m_combatSystem = combatSystem; }
     void setVisualEffectsSystem(VisualEffectsSystem* vfx) { m_visualEffects = vfx; }
+    void setSpatialQuery(SpatialQuery* spatialQuery) { m_spatialQuery = spatialQuery; }
+    void setProjectileSystem(ProjectileSystem* projectiles) { m_projectileSystem = projectiles; }
 
 private:
     /// 更新单个炮塔
@@ -35,6 +39,8 @@ private:
 private:
     CombatSystem* m_combatSystem{nullptr};
     VisualEffectsSystem* m_visualEffects{nullptr};
+    SpatialQuery* m_spatialQuery{nullptr};
+    ProjectileSystem* m_projectileSystem{nullptr};
 };
 
 } // namespace Nightfall
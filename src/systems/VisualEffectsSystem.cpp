@@ -1,7 +1,6 @@
 ﻿#include "VisualEffectsSystem.h"
 #include "../ecs/Components.h"
 #include "../core/Logger.h"
-#include "../core/ResourceManager.h"
 #include <cmath>
 #include <sstream>
 #include <iomanip>
@@ -16,18 +15,11 @@ VisualEffectsSystem::~VisualEffectsSystem() {
 }
 
 void VisualEffectsSystem::init() {
-    m_font = ResourceManager::getInstance().getFont("default");
+    m_random = Random::createStream(RandomStreamId::Effects);
     NF_INFO("Visual effects system initialized");
 }
 
 void VisualEffectsSystem::update(float deltaTime, Registry& registry) {
-    // 更新子弹实体(使用ECS的Temporary组件自动销毁)
-    auto bulletView = registry.view<Transform, Velocity, Bullet>();
-    for (auto entity : bulletView) {
-        // 子弹由MovementSystem移动,这里只需检查碰撞
-        // TODO: 可以添加子弹碰撞检测
-    }
-    
     // 更新伤害数字
     for (auto it = m_damageTexts.begin(); it != m_damageTexts.end();) {
         it->elapsed += deltaTime;
@@ -120,33 +112,6 @@ void VisualEffectsSystem::render(sf::RenderWindow& window, Registry& registry) {
     }
 }
 
-void VisualEffectsSystem::createBullet(const sf::Vector2f& from, const sf::Vector2f& to, Registry& registry) {
-    // 计算方向
-    sf::Vector2f direction = to - from;
-    float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
-    if (length > 0.f) {
-        direction /= length;
-    }
-    
-    // 创建子弹实体
-    auto bullet = registry.createEntity();
-    registry.addComponent<Transform>(bullet, from);
-    registry.addComponent<Velocity>(bullet, direction.x * 500.f, direction.y * 500.f, 500.f);
-    
-    // 添加Sprite组件(黄色小圆点)
-    auto& sprite = registry.addComponent<Sprite>(bullet, "", 10);
-    sprite.color = sf::Color::Yellow;
-    sprite.scale = sf::Vector2f(0.3f, 0.3f);
-    
-    // 添加Bullet标记
-    registry.addComponent<Bullet>(bullet);
-    
-    // 添加Temporary组件(0.5秒后自动销毁)
-    registry.addComponent<Temporary>(bullet).lifetime = 0.5f;
-    
-    NF_DEBUG("Created bullet from ({}, {}) to ({}, {})", from.x, from.y, to.x, to.y);
-}
-
 void VisualEffectsSystem::createDamageNumber(const sf::Vector2f& position, float damage, bool isCritical) {
     DamageText dmgText;
     dmgText.position = position + sf::Vector2f(0.f, -20.f); // 稍微偏上
@@ -169,19 +134,27 @@ void VisualEffectsSystem::createAttackLine(const sf::Vector2f& from, const sf::V
 }
 
 void VisualEffectsSystem::createDeathEffect(const sf::Vector2f& position, const sf::Color& color) {
-    // 创建多个粒子
-    for (int i = 0; i < 10; ++i) {
+    // 一次生成整批粒子的随机参数
+    constexpr size_t particleCount = 10;
+    float angles[particleCount];
+    float speeds[particleCount];
+    float lifetimes[particleCount];
+    int sizes[particleCount];
+    m_random.fillAngles(angles, particleCount);
+    m_random.fillRange(speeds, particleCount, 100.f, 200.f);
+    m_random.fillRange(lifetimes, particleCount, 0.8f, 1.2f);
+    m_random.fillRangeInt(sizes, particleCount, 2, 5);
+    
+    for (size_t i = 0; i < particleCount; ++i) {
         DeathParticle particle;
         particle.position = position;
         
         // 随机方向
-        float angle = static_cast<float>(rand() % 360) * 3.14159f / 180.f;
-        float speed = 100.f + static_cast<float>(rand() % 100);
-        particle.velocity = sf::Vector2f(std::cos(angle) * speed, std::sin(angle) * speed - 100.f);
+        particle.velocity = sf::Vector2f(std::cos(angles[i]) * speeds[i], std::sin(angles[i]) * speeds[i] - 100.f);
         
         particle.color = color;
-        particle.lifetime = 0.8f + static_cast<float>(rand() % 400) / 1000.f;
-        particle.size = 2.f + static_cast<float>(rand() % 4);
+        particle.lifetime = lifetimes[i];
+        particle.size = static_cast<float>(sizes[i]);
         
         m_deathParticles.push_back(particle);
     }
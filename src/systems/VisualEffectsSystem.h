@@ -1,13 +1,14 @@
 ﻿#pragma once
 
 #include "../ecs/Registry.h"
+#include "../utils/Random.h"
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <string>
 
 namespace Nightfall {
 
-/// 视觉效果系统 - 处理子弹、伤害数字、粒子效果
+/// 视觉效果系统 - 处理攻击线条、伤害数字、粒子效果
 class VisualEffectsSystem {
 public:
     VisualEffectsSystem();
@@ -17,9 +18,9 @@ public:
     void update(float deltaTime, Registry& registry);
     void render(sf::RenderWindow& window, Registry& registry);
 
-    /// 创建子弹实体(从炮塔到目标)
-    void createBullet(const sf::Vector2f& from, const sf::Vector2f& to, Registry& registry);
-    
+    /// 伤害数字字体（字体随窗口一起加载，为空时不绘制伤害数字）
+    void setFont(sf::Font* font) { m_font = font; }
+
     /// 创建伤害数字
     void createDamageNumber(const sf::Vector2f& position, float damage, bool isCritical = false);
     
@@ -64,6 +65,7 @@ private:
     std::vector<DeathParticle> m_deathParticles;
     
     sf::Font* m_font{nullptr};
+    RandomStream m_random;
 };
 
 } // namespace Nightfall
@@ -1,8 +1,8 @@
 ﻿#include "WaveSystem.h"
 #include "../ecs/Components.h"
 #include "../core/Logger.h"
+#include <algorithm>
 #include <cmath>
-#include <cstdlib>
 
 namespace Nightfall {
 
@@ -15,6 +15,7 @@ WaveSystem::~WaveSystem() {
 
 void WaveSystem::init(const sf::FloatRect& spawnArea) {
     m_spawnArea = spawnArea;
+    m_random = Random::createStream(RandomStreamId::Waves);
     NF_INFO("Wave system initialized. Spawn area: ({}, {}) - {}x{}", 
             spawnArea.position.x, spawnArea.position.y, 
             spawnArea.size.x, spawnArea.size.y);
@@ -35,9 +36,7 @@ void WaveSystem::update(float deltaTime, Registry& registry) {
             m_spawnTimer += deltaTime;
             
             if (m_spawnTimer >= m_spawnDelay) {
-                auto entry = m_spawnQueue.back();
-                m_spawnQueue.pop_back();
-                spawnZombie(registry, entry.position, entry.type);
+                spawnQueued(registry);
                 m_spawnTimer = 0.f;
             }
         }
@@ -98,36 +97,55 @@ void WaveSystem::startNextWave(Registry& registry) {
             m_currentWave, normalCount, fastCount, tankCount);
 }
 
-void WaveSystem::spawnZombie(Registry& registry, const sf::Vector2f& position, ZombieType type) {
-    auto zombie = registry.createZombie(position, type);
-    NF_INFO("Spawned zombie type {} at ({}, {})", 
-            static_cast<int>(type), position.x, position.y);
+void WaveSystem::spawnQueued(Registry& registry) {
+    // 从队尾取出一批，按类型排序后每种类型一次批量生成
+    size_t count = m_spawnQueue.size();
+    if (m_spawnBatchSize > 0) {
+        count = std::min(count, static_cast<size_t>(m_spawnBatchSize));
+    }
+    const auto batchBegin = m_spawnQueue.end() - static_cast<std::ptrdiff_t>(count);
+    std::stable_sort(batchBegin, m_spawnQueue.end(), [](const SpawnEntry& a, const SpawnEntry& b) {
+        return a.type < b.type;
+    });
+
+    for (auto it = batchBegin; it != m_spawnQueue.end();) {
+        const ZombieType type = it->type;
+        m_batchPositions.clear();
+        for (; it != m_spawnQueue.end() && it->type == type; ++it) {
+            m_batchPositions.push_back(it->position);
+        }
+
+        registry.spawnBatch(registry.getArchetypes().getZombie(type), m_batchPositions.data(), m_batchPositions.size());
+        NF_INFO("Spawned {} zombies of type {}", m_batchPositions.size(), static_cast<int>(type));
+    }
+
+    m_spawnQueue.erase(batchBegin, m_spawnQueue.end());
 }
 
 sf::Vector2f WaveSystem::getRandomSpawnPosition() {
     // 在地图边缘随机选择一个位置
-    int edge = rand() % 4; // 0=上, 1=右, 2=下, 3=左
+    int edge = m_random.rangeInt(0, 3); // 0=上, 1=右, 2=下, 3=左
     
     float x, y;
     const float margin = 50.f; // 离边界的距离
     
     switch (edge) {
         case 0: // 上边缘
-            x = m_spawnArea.position.x + (rand() % static_cast<int>(m_spawnArea.size.x));
+            x = m_spawnArea.position.x + m_random.range(0.f, m_spawnArea.size.x);
             y = m_spawnArea.position.y - margin;
             break;
         case 1: // 右边缘
             x = m_spawnArea.position.x + m_spawnArea.size.x + margin;
-            y = m_spawnArea.position.y + (rand() % static_cast<int>(m_spawnArea.size.y));
+            y = m_spawnArea.position.y + m_random.range(0.f, m_spawnArea.size.y);
             break;
         case 2: // 下边缘
-            x = m_spawnArea.position.x + (rand() % static_cast<int>(m_spawnArea.size.x));
+            x = m_spawnArea.position.x + m_random.range(0.f, m_spawnArea.size.x);
             y = m_spawnArea.position.y + m_spawnArea.size.y + margin;
             break;
         case 3: // 左边缘
         default:
             x = m_spawnArea.position.x - margin;
-            y = m_spawnArea.position.y + (rand() % static_cast<int>(m_spawnArea.size.y));
+            y = m_spawnArea.position.y + m_random.range(0.f, m_spawnArea.size.y);
             break;
     }
     
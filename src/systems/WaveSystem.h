@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "../ecs/Registry.h"
+#include "../utils/Random.h"
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <vector>
 
@@ -13,6 +14,7 @@ namespace Nightfall {
  * - 定时生成僵尸波次
  * - 每波难度递增
  * - 在地图边缘随机位置生成敌人
+ * - 每次生成一批，同类型的僵尸通过 Registry::spawnBatch 一次生成
  */
 class WaveSystem {
 public:
@@ -31,9 +33,13 @@ public:
     bool isWaveActive() const { return m_waveActive; }
     float getTimeUntilNextWave() const { return m_timeBetweenWaves - m_waveTimer; }
 
+    // 配置
+    void setSpawnInterval(float interval) { m_spawnDelay = interval; }
+    void setSpawnBatchSize(int size) { m_spawnBatchSize = size; }
+
 private:
     void spawnWave(Registry& registry);
-    void spawnZombie(Registry& registry, const sf::Vector2f& position, ZombieType type);
+    void spawnQueued(Registry& registry);
     sf::Vector2f getRandomSpawnPosition();
     
 private:
@@ -43,7 +49,8 @@ private:
     bool m_waveActive{false};        // 当前波次是否激活
     float m_waveTimer{0.f};          // 波次计时器
     float m_timeBetweenWaves{30.f}; // 波次间隔时间（秒）
-    float m_spawnDelay{1.f};         // 每个敌人生成间隔
+    float m_spawnDelay{1.f};         // 每批敌人生成间隔
+    int m_spawnBatchSize{0};         // 每批生成的敌人数（0 表示整波一次生成）
     float m_spawnTimer{0.f};         // 生成计时器
     
     // 当前波次的生成队列
@@ -52,6 +59,9 @@ private:
         sf::Vector2f position;
     };
     std::vector<SpawnEntry> m_spawnQueue;
+    std::vector<sf::Vector2f> m_batchPositions;   // 同类型一批的生成位置（复用）
+    
+    RandomStream m_random;
 };
 
 } // namespace Nightfall
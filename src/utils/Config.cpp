@@ -69,6 +69,84 @@ void Config::loadDefaults() {
             {"lighting_enabled", true},
             {"particle_quality", "high"}
         }},
+        {"physics", {
+            {"broadphase", "spatial_hash"},  // spatial_hash | brute_force
+            {"cell_size", 64},
+            {"sleep_enabled", true},         // 静止的动态物体休眠，跳过积分与碰撞
+            {"sleep_ticks", 30},             // 连续低速多少个逻辑帧后休眠
+            {"sleep_velocity", 1.0},         // 低速阈值（像素/秒）
+            // 互不碰撞的层对（层名: default/player/hostile/npc/building/resource/item/trap）
+            {"ignore_layer_pairs", nlohmann::json::array({
+                nlohmann::json::array({"item", "default"}), nlohmann::json::array({"item", "hostile"}),
+                nlohmann::json::array({"item", "npc"}), nlohmann::json::array({"item", "building"}),
+                nlohmann::json::array({"item", "resource"}), nlohmann::json::array({"item", "item"})
+            })}
+        }},
+        {"pathfinding", {
+            {"cell_size", 32},           // 导航网格的格子边长（像素）
+            {"cluster_size", 16},        // 分层寻路（HPA*）的簇边长（格子数）
+            {"worker_threads", 2},       // 寻路工作线程数（0 表示在同步点按时间预算计算）
+            {"max_jobs_per_frame", 8},   // 每帧最多派发的寻路任务，超出的排到下一帧
+            {"inline_budget_ms", 2.0},   // 无工作线程时每帧同步计算的时间上限
+            {"path_cache_size", 256}     // 路径缓存条目数（按起点、目标、导航版本）
+        }},
+        {"ai", {
+            {"lod_near_distance", 600},  // 近档半径：玩家附近（及相机内）每个逻辑帧更新
+            {"lod_mid_distance", 1200},  // 中档半径，之外为远档
+            {"lod_mid_interval", 2},     // 中档更新间隔（逻辑帧）
+            {"lod_far_interval", 8},     // 远档更新间隔（逻辑帧）
+            {"behavior_trees", "assets/data/behaviors.json"}   // NPC 行为树与原型映射
+        }},
+        {"waves", {
+            {"spawn_interval", 1.0},     // 每批敌人的生成间隔（秒）
+            {"spawn_batch_size", 0}      // 每批生成的敌人数（0 表示整波一次生成）
+        }},
+        {"archetypes", {
+            {"enemies", "assets/data/enemies.json"},     // 敌人原型（覆盖内置默认属性）
+            {"buildings", "assets/data/buildings.json"}  // 建筑原型
+        }},
+        {"pooling", {
+            {"enabled", true},           // 死亡的僵尸停放到对象池，生成时复用
+            {"zombie_capacity", 2048}    // 每种僵尸最多停放的实体数（超出的直接销毁）
+        }},
+        {"npc", {
+            {"job_search_radius", 800},  // NPC 寻找工作的最大半径
+            {"job_candidates", 4},       // 每个 NPC 在每种工作中参与匹配的最近目标数
+            {"work_range", 40},          // 开始工作的距离
+            {"repair_rate", 10},         // 每秒修复的建筑耐久
+            {"refill_time", 3.0},        // 给生产建筑补料的时间（秒）
+            {"repair_threshold", 0.8}    // 耐久低于此比例的建筑进入修理任务
+        }},
+        {"formation", {
+            {"squad_size", 16},          // 全员迁移时每个小队的最大人数（每队只有领队寻路）
+            {"spacing", 40},             // 行军阵型相邻两圈的间距
+            {"arrive_distance", 150},    // 领队离玩家小于此距离时小队解散
+            {"repath_distance", 256}     // 玩家移动超过此距离时领队重新寻路
+        }},
+        {"survival", {
+            {"enabled", true},           // 饱食度下降、耐力与生命恢复
+            {"starvation_damage", false} // 饥饿时扣血（玩家还没有进食途径，默认关闭）
+        }},
+        {"crowd", {
+            {"enabled", true},
+            {"neighbor_radius", 48},     // 邻居半径（同时是邻居网格的格子边长）
+            {"max_neighbors", 8},        // 每个单位最多参考的邻居数
+            {"separation_weight", 1.5},
+            {"alignment_weight", 0.3},
+            {"cohesion_weight", 0.1}
+        }},
+        {"projectiles", {
+            {"max_count", 4096},     // 子弹池容量
+            {"cell_size", 64}        // 敌对单位网格的格子边长
+        }},
+        {"simulation", {
+            {"tick_rate", 60},       // 固定逻辑帧率（Hz），渲染帧率不受限制
+            {"max_substeps", 5},     // 单帧最多追赶的逻辑帧数
+            {"headless_ticks", 0},   // >0 时不渲染，尽快推进指定逻辑帧数后退出
+            {"random_seed", 1},      // 随机数种子（默认固定，同一配置每局可复现；0 表示每次运行取当前时间）
+            {"stats_log_interval", 5.0},   // 每隔多少秒（逻辑时间）以 debug 级别输出性能统计（0 表示不输出）
+            {"worker_threads", 2}    // 任务系统的工作线程数（系统调度与并行遍历共用；0 表示全部在主线程执行）
+        }},
         {"controls", {
             {"move_up", "W"},
             {"move_down", "S"},
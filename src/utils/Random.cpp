@@ -1 +1,91 @@
-﻿
\ No newline at end of file
+﻿#include "Random.h"
+#include "../core/Logger.h"
+#include <chrono>
+
+namespace Nightfall {
+
+namespace {
+
+/// 默认构造的流（尚未由 Random::createStream 赋值）使用的种子
+constexpr std::uint64_t kStreamDefaultSeed = 0x6E6967687466616CULL;
+
+/// SplitMix64：把任意 64 位种子展开成互不相关的状态字
+std::uint64_t splitMix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+std::uint64_t Random::s_seed = kDefaultRandomSeed;   // 未调用 init 时与默认配置相同
+
+// ========== RandomStream ==========
+
+RandomStream::RandomStream() {
+    seed(kStreamDefaultSeed);
+}
+
+RandomStream::RandomStream(std::uint64_t seedValue) {
+    seed(seedValue);
+}
+
+void RandomStream::seed(std::uint64_t seedValue) {
+    std::uint64_t state = seedValue;
+    const std::uint64_t a = splitMix64(state);
+    const std::uint64_t b = splitMix64(state);
+    m_state[0] = static_cast<std::uint32_t>(a);
+    m_state[1] = static_cast<std::uint32_t>(a >> 32);
+    m_state[2] = static_cast<std::uint32_t>(b);
+    m_state[3] = static_cast<std::uint32_t>(b >> 32);
+
+    // xoshiro 的状态不能全为 0
+    if ((m_state[0] | m_state[1] | m_state[2] | m_state[3]) == 0) {
+        m_state[0] = 1;
+    }
+}
+
+int RandomStream::rangeInt(int min, int max) {
+    if (max <= min) return min;
+
+    // Lemire 乘法映射：无除法，偏差小于 2^-32，对游戏用途可以忽略
+    const std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(max) - min) + 1;
+    return min + static_cast<int>((static_cast<std::uint64_t>(next()) * span) >> 32);
+}
+
+void RandomStream::fillRange(float* out, size_t count, float min, float max) {
+    const float scale = (max - min) * (1.f / 16777216.f);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = min + static_cast<float>(next() >> 8) * scale;
+    }
+}
+
+void RandomStream::fillAngles(float* out, size_t count) {
+    fillRange(out, count, 0.f, 6.28318531f);
+}
+
+void RandomStream::fillRangeInt(int* out, size_t count, int min, int max) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = rangeInt(min, max);
+    }
+}
+
+// ========== Random ==========
+
+void Random::init(std::uint64_t seed) {
+    if (seed == 0) {
+        seed = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+    s_seed = seed;
+    NF_CORE_INFO("随机数种子: {}", s_seed);
+}
+
+RandomStream Random::createStream(RandomStreamId id, std::uint32_t index) {
+    // 用途和编号混入种子，再经 SplitMix64 展开，不同流的状态互不相关
+    const std::uint64_t key = (static_cast<std::uint64_t>(id) << 32) | index;
+    std::uint64_t state = s_seed ^ (key * 0xD1B54A32D192ED03ULL);
+    return RandomStream(splitMix64(state));
+}
+
+} // namespace Nightfall
@@ -1 +1,107 @@
-﻿
\ No newline at end of file
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Nightfall {
+
+/// 随机数流的用途（同一个全局种子下，每种用途派生出独立的序列）
+enum class RandomStreamId : std::uint32_t {
+    AI,         // AI 游荡方向等
+    Waves,      // 波次刷怪位置
+    Combat,     // 掉落
+    Effects     // 粒子效果
+};
+
+/// 默认种子：不配置时每次运行的随机序列相同（回放、无渲染模拟和调试都依赖这一点）
+constexpr std::uint64_t kDefaultRandomSeed = 1;
+
+/**
+ * @brief 随机数流 - xoshiro128** 生成器
+ *
+ * - 状态只有 16 字节，没有全局状态；每个系统各持有一个，互不干扰，也不需要加锁
+ * - 相同的种子和流编号总是产生相同的序列，运行可复现
+ * - 批量接口一次填满缓冲区（粒子爆发、批量刷怪），比逐个调用省去函数调用和分支
+ */
+class RandomStream {
+public:
+    RandomStream();
+    explicit RandomStream(std::uint64_t seed);
+
+    /// 用 64 位种子重置状态（经 SplitMix64 展开，种子为 0 也可用）
+    void seed(std::uint64_t seed);
+
+    /// 下一个 32 位随机数
+    std::uint32_t next() {
+        const std::uint32_t result = rotl(m_state[1] * 5u, 7) * 9u;
+        const std::uint32_t t = m_state[1] << 9;
+
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 11);
+        return result;
+    }
+
+    /// [0, 1) 均匀分布
+    float nextFloat() {
+        // 取高 24 位作为尾数，保证结果严格小于 1
+        return static_cast<float>(next() >> 8) * (1.f / 16777216.f);
+    }
+
+    /// [min, max) 均匀分布
+    float range(float min, float max) { return min + (max - min) * nextFloat(); }
+
+    /// [min, max] 均匀分布的整数
+    int rangeInt(int min, int max);
+
+    /// [0, 2π) 的角度（弧度）
+    float angle() { return nextFloat() * 6.28318531f; }
+
+    /// 以概率 probability 返回 true
+    bool chance(float probability) { return nextFloat() < probability; }
+
+    /// 批量生成 [min, max) 的浮点数
+    void fillRange(float* out, size_t count, float min, float max);
+
+    /// 批量生成 [0, 2π) 的角度
+    void fillAngles(float* out, size_t count);
+
+    /// 批量生成 [min, max] 的整数
+    void fillRangeInt(int* out, size_t count, int min, int max);
+
+private:
+    static std::uint32_t rotl(std::uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    std::uint32_t m_state[4];
+};
+
+/**
+ * @brief 随机数服务 - 全局种子与按用途派生的独立流
+ *
+ * 启动时由 init 设置一次种子（配置 simulation.random_seed，默认 kDefaultRandomSeed；
+ * 只有显式配置为 0 时才取当前时间），
+ * 之后各系统在自己的 init 里调用 createStream 取得专用的流。
+ * 流之间互相独立：某个系统多用或少用随机数不会改变其他系统的序列。
+ */
+class Random {
+public:
+    /// 设置全局种子（0 表示由当前时间生成，每次运行不同）
+    static void init(std::uint64_t seed);
+
+    static std::uint64_t getSeed() { return s_seed; }
+
+    /**
+     * @brief 创建独立的随机数流
+     * @param id 用途
+     * @param index 同一用途下的编号（同一用途需要多条独立的流时区分）
+     */
+    static RandomStream createStream(RandomStreamId id, std::uint32_t index = 0);
+
+private:
+    static std::uint64_t s_seed;
+};
+
+} // namespace Nightfall
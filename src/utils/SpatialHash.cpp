@@ -0,0 +1,31 @@
+﻿#include "SpatialHash.h"
+
+namespace Nightfall {
+
+void SpatialHash::insert(std::uint32_t id, const sf::FloatRect& bounds) {
+    Entry entry;
+    entry.id = id;
+    entry.bounds = bounds;
+    entry.minX = toCell(bounds.position.x);
+    entry.minY = toCell(bounds.position.y);
+    entry.maxX = toCell(bounds.position.x + bounds.size.x);
+    entry.maxY = toCell(bounds.position.y + bounds.size.y);
+
+    const auto entryIndex = static_cast<std::uint32_t>(m_entries.size());
+    m_entries.push_back(entry);
+
+    for (int cy = entry.minY; cy <= entry.maxY; ++cy) {
+        for (int cx = entry.minX; cx <= entry.maxX; ++cx) {
+            m_cellRefs.push_back({makeKey(cx, cy), cx, cy, entryIndex});
+        }
+    }
+}
+
+void SpatialHash::build() {
+    // 按格子排序，同一格子内保持插入顺序，保证候选对的生成顺序稳定
+    std::sort(m_cellRefs.begin(), m_cellRefs.end(), [](const CellRef& a, const CellRef& b) {
+        return a.key != b.key ? a.key < b.key : a.entry < b.entry;
+    });
+}
+
+} // namespace Nightfall
@@ -0,0 +1,121 @@
+﻿#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Nightfall {
+
+/// 均匀网格空间哈希（每帧重建）
+/// 宽相位碰撞检测用：条目按所覆盖的格子分桶，只为共享格子的条目生成候选对。
+/// 条目 id 由调用方定义（通常是调用方数组的下标）。
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize = 64.f) : m_cellSize(cellSize) {}
+
+    /// 设置格子边长（像素），下次 build() 生效
+    void setCellSize(float cellSize) { m_cellSize = cellSize > 1.f ? cellSize : 1.f; }
+    float getCellSize() const { return m_cellSize; }
+
+    /// 清空所有条目（保留已分配的内存，供下一帧复用）
+    void clear() {
+        m_entries.clear();
+        m_cellRefs.clear();
+    }
+
+    /// 插入一个包围盒
+    void insert(std::uint32_t id, const sf::FloatRect& bounds);
+
+    /// 完成插入并排序格子索引（插入之后、查询之前调用）
+    void build();
+
+    /// 条目数量
+    size_t size() const { return m_entries.size(); }
+
+    /// 遍历所有候选对，每对只报告一次
+    /// @param func void(std::uint32_t idA, std::uint32_t idB)，idA 的插入顺序先于 idB
+    template<typename Func>
+    void forEachPair(Func&& func) const {
+        size_t runBegin = 0;
+        while (runBegin < m_cellRefs.size()) {
+            size_t runEnd = runBegin + 1;
+            while (runEnd < m_cellRefs.size() && m_cellRefs[runEnd].key == m_cellRefs[runBegin].key) {
+                ++runEnd;
+            }
+
+            const int cellX = m_cellRefs[runBegin].cellX;
+            const int cellY = m_cellRefs[runBegin].cellY;
+            for (size_t i = runBegin; i < runEnd; ++i) {
+                const Entry& a = m_entries[m_cellRefs[i].entry];
+                for (size_t j = i + 1; j < runEnd; ++j) {
+                    const Entry& b = m_entries[m_cellRefs[j].entry];
+                    // 两个条目可能共享多个格子：只在共享区域的左上角格子里报告
+                    if (std::max(a.minX, b.minX) != cellX || std::max(a.minY, b.minY) != cellY) {
+                        continue;
+                    }
+                    func(a.id, b.id);
+                }
+            }
+
+            runBegin = runEnd;
+        }
+    }
+
+    /// 遍历与区域所在格子重叠的条目，每个条目只报告一次
+    /// @param func void(std::uint32_t id, const sf::FloatRect& bounds)
+    template<typename Func>
+    void query(const sf::FloatRect& area, Func&& func) const {
+        const int minX = toCell(area.position.x);
+        const int minY = toCell(area.position.y);
+        const int maxX = toCell(area.position.x + area.size.x);
+        const int maxY = toCell(area.position.y + area.size.y);
+
+        for (int cy = minY; cy <= maxY; ++cy) {
+            for (int cx = minX; cx <= maxX; ++cx) {
+                const std::uint64_t key = makeKey(cx, cy);
+                auto it = std::lower_bound(m_cellRefs.begin(), m_cellRefs.end(), key,
+                    [](const CellRef& ref, std::uint64_t k) { return ref.key < k; });
+
+                for (; it != m_cellRefs.end() && it->key == key; ++it) {
+                    const Entry& entry = m_entries[it->entry];
+                    // 条目跨越多个格子时，只在与查询区域重叠部分的左上角格子里报告
+                    if (std::max(entry.minX, minX) != cx || std::max(entry.minY, minY) != cy) {
+                        continue;
+                    }
+                    func(entry.id, entry.bounds);
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        std::uint32_t id;
+        sf::FloatRect bounds;
+        int minX, minY, maxX, maxY;  // 覆盖的格子范围（闭区间）
+    };
+
+    struct CellRef {
+        std::uint64_t key;
+        int cellX;
+        int cellY;
+        std::uint32_t entry;  // m_entries 下标
+    };
+
+    int toCell(float coord) const {
+        return static_cast<int>(std::floor(coord / m_cellSize));
+    }
+
+    static std::uint64_t makeKey(int cellX, int cellY) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellY)) << 32) |
+               static_cast<std::uint32_t>(cellX);
+    }
+
+    float m_cellSize;
+    std::vector<Entry> m_entries;
+    std::vector<CellRef> m_cellRefs;  // build() 后按 (key, entry) 排序
+};
+
+} // namespace Nightfall
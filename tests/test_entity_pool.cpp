@@ -0,0 +1,68 @@
+﻿// 对象池测试：回收停放、复用，以及复用后旧句柄通过代数识别为失效
+#include "core/Logger.h"
+#include "ecs/Registry.h"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Nightfall;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::printf("  FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+            ++g_failures;                                                       \
+        }                                                                       \
+    } while (0)
+
+void testRecycleAndRevive() {
+    std::printf("recycle and revive\n");
+    Registry registry;
+    const Archetype& archetype = registry.getArchetypes().getZombie(ZombieType::Normal);
+    registry.enablePooling(archetype, 4);
+
+    entt::entity zombie = registry.createZombie(sf::Vector2f(10.f, 20.f), ZombieType::Normal);
+    CHECK(registry.isValid(zombie));
+    CHECK(registry.hasComponent<Pooled>(zombie));
+
+    // 炮塔之类的持有方锁定目标时记下代数
+    const std::uint32_t generation = registry.getGeneration(zombie);
+    CHECK(registry.isValid(zombie, generation));
+
+    registry.recycle(zombie);
+    CHECK(!registry.isValid(zombie));
+    CHECK(!registry.isValid(zombie, generation));
+    CHECK(registry.getPoolStats().front().parked == 1);
+
+    // 复用得到同一个实体编号，但旧句柄已经失效
+    entt::entity revived = registry.createZombie(sf::Vector2f(300.f, 400.f), ZombieType::Normal);
+    CHECK(revived == zombie);
+    CHECK(registry.isValid(revived));
+    CHECK(!registry.isValid(zombie, generation));
+    CHECK(registry.isValid(revived, registry.getGeneration(revived)));
+    CHECK(registry.getComponent<Transform>(revived).position == sf::Vector2f(300.f, 400.f));
+    CHECK(registry.getPoolStats().front().revived == 1);
+
+    // 不属于对象池的实体代数恒为 0
+    entt::entity player = registry.createPlayer(sf::Vector2f(0.f, 0.f));
+    CHECK(registry.getGeneration(player) == 0);
+    CHECK(registry.isValid(player, 0));
+    CHECK(registry.getGeneration(entt::null) == 0);
+}
+
+} // namespace
+
+int main() {
+    Logger::init("logs/test_entity_pool.log");
+    testRecycleAndRevive();
+
+    if (g_failures > 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all entity pool tests passed\n");
+    return EXIT_SUCCESS;
+}
@@ -1 +1,270 @@
-﻿
\ No newline at end of file
+﻿// 寻路正确性测试：跳点搜索（JPS）与普通 A* 的路径长度一致、通行位与网格同步、路径缓存的 LRU 行为、HPA* 的连通性随重建更新
+#include "ai/Pathfinding.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace Nightfall;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::printf("  FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+            ++g_failures;                                                       \
+        }                                                                       \
+    } while (0)
+
+NavGrid makeGrid(int width, int height) {
+    NavGrid grid;
+    grid.resize(sf::FloatRect({0.f, 0.f}, {static_cast<float>(width), static_cast<float>(height)}), 1.f);
+    return grid;
+}
+
+/// 随机阻挡格子（density 为阻挡比例）
+void scatterWalls(NavGrid& grid, float density, std::mt19937& rng) {
+    std::uniform_real_distribution<float> chance(0.f, 1.f);
+    for (int y = 0; y < grid.getHeight(); ++y) {
+        for (int x = 0; x < grid.getWidth(); ++x) {
+            grid.setBlocked(x, y, chance(rng) < density);
+        }
+    }
+}
+
+/// 路径首尾正确、每一步都是合法的 8 邻接移动（不斜穿墙角），并返回路径长度
+bool validatePath(const NavGrid& grid, const std::vector<int>& path, int start, int goal, float& length) {
+    length = 0.f;
+    if (path.empty() || path.front() != start || path.back() != goal) return false;
+
+    const int width = grid.getWidth();
+    for (size_t i = 1; i < path.size(); ++i) {
+        const int x0 = path[i - 1] % width;
+        const int y0 = path[i - 1] / width;
+        const int x1 = path[i] % width;
+        const int y1 = path[i] / width;
+        const int dx = x1 - x0;
+        const int dy = y1 - y0;
+        if (std::abs(dx) > 1 || std::abs(dy) > 1 || (dx == 0 && dy == 0)) return false;
+        if (!grid.isWalkable(x1, y1)) return false;
+        if (dx != 0 && dy != 0 && (!grid.isWalkable(x0 + dx, y0) || !grid.isWalkable(x0, y0 + dy))) return false;
+        length += (dx != 0 && dy != 0) ? 1.41421356f : 1.f;
+    }
+    return true;
+}
+
+void testPackedBits() {
+    std::printf("packed walkability bits\n");
+    std::mt19937 rng(7);
+
+    // 宽高不是 64 的整数倍，覆盖行尾 / 列尾的填充位
+    NavGrid grid = makeGrid(130, 70);
+    scatterWalls(grid, 0.3f, rng);
+    std::uniform_int_distribution<int> coordX(0, grid.getWidth() - 1);
+    std::uniform_int_distribution<int> coordY(0, grid.getHeight() - 1);
+    for (int i = 0; i < 2000; ++i) {
+        grid.setBlocked(coordX(rng), coordY(rng), (rng() & 1) != 0);
+    }
+
+    bool consistent = true;
+    for (int y = 0; y < grid.getHeight(); ++y) {
+        for (int x = 0; x < grid.getWidth(); ++x) {
+            const bool rowBit = (grid.getRowBits(y)[x >> 6] >> (x & 63)) & 1;
+            const bool columnBit = (grid.getColumnBits(x)[y >> 6] >> (y & 63)) & 1;
+            consistent = consistent && rowBit == grid.isWalkable(x, y) && columnBit == grid.isWalkable(x, y);
+        }
+    }
+    CHECK(consistent);
+
+    // 填充位必须为 0（跳点扫描依赖它把网格边缘当作阻挡）
+    CHECK((grid.getRowBits(0)[grid.getRowWords() - 1] >> (grid.getWidth() & 63)) == 0);
+    CHECK((grid.getColumnBits(0)[grid.getColumnWords() - 1] >> (grid.getHeight() & 63)) == 0);
+}
+
+void testTrivialQueries() {
+    std::printf("trivial queries\n");
+    NavGrid grid = makeGrid(16, 16);
+    JumpPointSearch jps;
+    std::vector<int> path;
+    float cost = -1.f;
+
+    // 起点即终点
+    CHECK(jps.findPath(grid, grid.toIndex(3, 3), grid.toIndex(3, 3), path, cost));
+    CHECK(path.size() == 1 && cost == 0.f);
+
+    // 空地上的纯直线和纯对角线
+    CHECK(jps.findPath(grid, grid.toIndex(0, 5), grid.toIndex(15, 5), path, cost));
+    CHECK(path.size() == 16 && std::fabs(cost - 15.f) < 1e-4f);
+    CHECK(jps.findPath(grid, grid.toIndex(0, 0), grid.toIndex(15, 15), path, cost));
+    CHECK(path.size() == 16 && std::fabs(cost - 15.f * 1.41421356f) < 1e-3f);
+
+    // 起点或终点被阻挡
+    grid.setBlocked(8, 8, true);
+    CHECK(!jps.findPath(grid, grid.toIndex(8, 8), grid.toIndex(0, 0), path, cost));
+    CHECK(!jps.findPath(grid, grid.toIndex(0, 0), grid.toIndex(8, 8), path, cost));
+    CHECK(path.empty());
+
+    // 终点被墙完全围住
+    for (int i = 4; i <= 12; ++i) {
+        grid.setBlocked(i, 4, true);
+        grid.setBlocked(i, 12, true);
+        grid.setBlocked(4, i, true);
+        grid.setBlocked(12, i, true);
+    }
+    CHECK(!jps.findPath(grid, grid.toIndex(0, 0), grid.toIndex(6, 6), path, cost));
+
+    // 对角缝隙不能斜穿：两个阻挡格子只在角上相接
+    NavGrid corner = makeGrid(3, 3);
+    corner.setBlocked(1, 0, true);
+    corner.setBlocked(0, 1, true);
+    CHECK(!jps.findPath(corner, corner.toIndex(0, 0), corner.toIndex(2, 2), path, cost));
+}
+
+void testMatchesAStar() {
+    std::printf("JPS vs A* on random grids\n");
+    std::mt19937 rng(2024);
+
+    const int sizes[][2] = {{20, 20}, {64, 64}, {65, 33}, {130, 70}, {200, 128}};
+    const float densities[] = {0.f, 0.1f, 0.25f, 0.4f};
+
+    JumpPointSearch jps;
+    GridSearch search;
+    std::vector<int> jpsPath;
+    std::vector<int> aStarPath;
+    int queries = 0;
+    int mismatches = 0;
+    int invalid = 0;
+
+    for (const auto& size : sizes) {
+        for (float density : densities) {
+            NavGrid grid = makeGrid(size[0], size[1]);
+            scatterWalls(grid, density, rng);
+            const CellRect whole{0, 0, grid.getWidth() - 1, grid.getHeight() - 1};
+            std::uniform_int_distribution<int> cell(0, static_cast<int>(grid.getCellCount()) - 1);
+
+            for (int i = 0; i < 200; ++i) {
+                const int start = cell(rng);
+                const int goal = cell(rng);
+                float jpsCost = 0.f;
+                float aStarCost = 0.f;
+                const bool jpsFound = jps.findPath(grid, start, goal, jpsPath, jpsCost);
+                const bool aStarFound = search.findPath(grid, start, goal, whole, aStarPath, aStarCost);
+                ++queries;
+
+                if (jpsFound != aStarFound) {
+                    ++mismatches;
+                    continue;
+                }
+                if (!jpsFound) continue;
+
+                float length = 0.f;
+                if (!validatePath(grid, jpsPath, start, goal, length) || std::fabs(length - jpsCost) > 1e-2f) {
+                    ++invalid;
+                } else if (std::fabs(jpsCost - aStarCost) > 1e-2f) {
+                    ++mismatches;
+                }
+            }
+        }
+    }
+
+    std::printf("  %d queries, %d mismatches, %d invalid paths\n", queries, mismatches, invalid);
+    CHECK(mismatches == 0);
+    CHECK(invalid == 0);
+}
+
+void testPathCache() {
+    std::printf("path cache\n");
+    PathCache cache(2);
+    const std::vector<int> first{1, 2, 3};
+    const std::vector<int> second{4, 5};
+    const std::vector<int> unreachable;
+
+    CHECK(cache.find(1, 3, 0) == nullptr);
+    cache.store(1, 3, 0, first);
+    cache.store(4, 5, 0, second);
+    CHECK(cache.find(1, 3, 0) && *cache.find(1, 3, 0) == first);
+
+    // 版本不同不命中
+    CHECK(cache.find(1, 3, 1) == nullptr);
+
+    // (1, 3) 刚被使用，淘汰的是 (4, 5)
+    cache.store(7, 8, 0, unreachable);
+    CHECK(cache.size() == 2);
+    CHECK(cache.find(4, 5, 0) == nullptr);
+    CHECK(cache.find(1, 3, 0) != nullptr);
+
+    // 不可达的结果也会命中（空路径）
+    const std::vector<int>* cached = cache.find(7, 8, 0);
+    CHECK(cached && cached->empty());
+
+    // 覆盖已有条目
+    cache.store(7, 8, 0, second);
+    CHECK(cache.find(7, 8, 0) && *cache.find(7, 8, 0) == second);
+
+    cache.setCapacity(1);
+    CHECK(cache.size() == 1);
+    CHECK(cache.find(7, 8, 0) != nullptr);
+
+    cache.clear();
+    CHECK(cache.size() == 0 && cache.find(7, 8, 0) == nullptr);
+}
+
+void testHierarchyConnectivity() {
+    std::printf("hierarchy connectivity\n");
+    constexpr int kSize = 64;
+    NavGrid grid = makeGrid(kSize, kSize);
+
+    // 一堵竖墙把地图切成左右两半
+    const int wallX = kSize / 2 + 3;
+    for (int y = 0; y < kSize; ++y) {
+        grid.setBlocked(wallX, y, true);
+    }
+
+    HierarchicalPathfinder hierarchy;
+    HierarchicalPathfinder::QueryContext context;
+    GridSearch search;
+    hierarchy.build(grid, 8, search);
+
+    const int start = grid.toIndex(2, 5);
+    const int goal = grid.toIndex(kSize - 3, kSize - 5);
+    std::vector<int> route;
+    CHECK(!hierarchy.findRoute(grid, start, goal, route, context));
+
+    // 在墙上开一个口：只重建附近的簇，连通分量随之合并
+    const int gap = grid.toIndex(wallX, 40);
+    grid.setBlocked(wallX, 40, false);
+    hierarchy.invalidateCells(grid, {gap});
+    hierarchy.refresh(grid, search);
+    CHECK(hierarchy.findRoute(grid, start, goal, route, context));
+
+    std::vector<int> path;
+    float length;
+    CHECK(hierarchy.findPath(grid, start, goal, path, context));
+    CHECK(validatePath(grid, path, start, goal, length));
+
+    // 再堵上：重新不连通
+    grid.setBlocked(wallX, 40, true);
+    hierarchy.invalidateCells(grid, {gap});
+    hierarchy.refresh(grid, search);
+    CHECK(!hierarchy.findRoute(grid, start, goal, route, context));
+}
+
+} // namespace
+
+int main() {
+    testPackedBits();
+    testTrivialQueries();
+    testMatchesAStar();
+    testPathCache();
+    testHierarchyConnectivity();
+
+    if (g_failures > 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all pathfinding tests passed\n");
+    return EXIT_SUCCESS;
+}
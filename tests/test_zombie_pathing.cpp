@@ -0,0 +1,86 @@
+﻿// 僵尸寻路集成测试：新生成的僵尸挂上巡逻路线，经由 PathService 取得绕过墙体的路径
+#include "ai/PathService.h"
+#include "ai/Pathfinding.h"
+#include "core/Logger.h"
+#include "ecs/Registry.h"
+#include "systems/AISystem.h"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Nightfall;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::printf("  FAILED: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+            ++g_failures;                                                       \
+        }                                                                       \
+    } while (0)
+
+void testZombieGetsPath() {
+    std::printf("zombie path through PathService\n");
+    Registry registry;
+
+    // 玩家在营地，僵尸在检测范围外；中间一堵竖墙挡住直线
+    const sf::Vector2f camp(1000.f, 500.f);
+    const sf::Vector2f spawn(500.f, 500.f);
+    entt::entity player = registry.createPlayer(camp);
+    for (int i = -3; i <= 3; ++i) {
+        registry.createBuilding(sf::Vector2f(750.f, 500.f + i * 64.f), Building::Type::Wall);
+    }
+    entt::entity zombie = registry.createZombie(spawn, ZombieType::Normal);
+
+    Pathfinder pathfinder;
+    pathfinder.init(registry, sf::FloatRect({0.f, 0.f}, {1600.f, 1000.f}), 32.f, 8);
+
+    PathService pathService;
+    pathService.init(&pathfinder, 0);   // 无工作线程：sync() 里同步计算
+
+    AISystem aiSystem;
+    aiSystem.init(registry);
+    aiSystem.setPathfinder(&pathfinder);
+    aiSystem.setPathService(&pathService);
+
+    // 第一帧挂上巡逻路线并发出请求，同步点计算，下一帧取回结果
+    for (int frame = 0; frame < 3; ++frame) {
+        aiSystem.update(1.f / 60.f, registry, player);
+        pathService.sync();
+    }
+
+    const auto* patrol = registry.tryGetComponent<Patrol>(zombie);
+    CHECK(patrol != nullptr);
+    CHECK(patrol && !patrol->waypoints.empty() && patrol->waypoints.front() == camp);
+
+    const auto* follow = registry.tryGetComponent<PathFollow>(zombie);
+    CHECK(follow != nullptr);
+    if (!follow) return;
+    CHECK(follow->requested);
+    CHECK(follow->destination == camp);
+    CHECK(follow->handle == InvalidPathHandle);   // 结果已取回
+    CHECK(!follow->waypoints.empty());
+
+    // 路径绕过墙体：至少有一个路点不在墙所在的高度范围内
+    bool detours = false;
+    for (const auto& waypoint : follow->waypoints) {
+        if (waypoint.y < 500.f - 3.5f * 64.f || waypoint.y > 500.f + 3.5f * 64.f) detours = true;
+    }
+    CHECK(detours);
+}
+
+} // namespace
+
+int main() {
+    Logger::init("logs/test_zombie_pathing.log");
+    testZombieGetsPath();
+
+    if (g_failures > 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all zombie pathing tests passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+﻿// 行为树基准 - 1000 个 NPC 按 behaviors.json 的职业原型运行 600 帧，统计每帧 tick 耗时
+// 构建：cmake -DNIGHTFALL_BUILD_TOOLS=ON，目标 behavior_tree_bench（在构建目录运行，或把 behaviors.json 路径作为参数）
+#include "ai/NPCController.h"
+#include "core/Logger.h"
+#include "systems/AISystem.h"
+#include "systems/ResourceSystem.h"
+#include "utils/Config.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace Nightfall;
+
+int main(int argc, char** argv) {
+    constexpr int kNPCs = 1000;
+    constexpr int kFrames = 600;
+    constexpr float kDeltaTime = 1.f / 60.f;
+    constexpr float kWorldSize = 2000.f;
+
+    Logger::init("logs/behavior_tree_bench.log");
+    Logger::getAppLogger()->set_level(spdlog::level::warn);
+    Config::set("ai.behavior_trees", std::string(argc > 1 ? argv[1] : "assets/data/behaviors.json"));
+
+    Registry registry;
+    entt::entity player = registry.createPlayer(sf::Vector2f(kWorldSize / 2.f, kWorldSize / 2.f));
+
+    // NPC 散布在整张地图上，职业随机，饱食度随机（一部分一开始就饿）
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> coord(0.f, kWorldSize);
+    std::uniform_real_distribution<float> fullness(0.1f, 1.f);
+    std::uniform_int_distribution<int> profession(0, static_cast<int>(NPC::Profession::Engineer));
+    for (int i = 0; i < kNPCs; ++i) {
+        entt::entity npc = registry.createNPC(sf::Vector2f(coord(rng), coord(rng)), "npc",
+                                              static_cast<NPC::Profession>(profession(rng)));
+        auto& hunger = registry.getComponent<Hunger>(npc);
+        hunger.current = hunger.maximum * fullness(rng);
+    }
+
+    // 受损的墙给工作者提供修理工作
+    for (int i = 0; i < 50; ++i) {
+        entt::entity wall = registry.createBuilding(sf::Vector2f(coord(rng), coord(rng)), Building::Type::Wall);
+        auto& building = registry.getComponent<Building>(wall);
+        building.durability = building.maxDurability * 0.3f;
+    }
+
+    ResourceSystem resourceSystem;
+    resourceSystem.init();
+    resourceSystem.addResource("food", kNPCs * 10);
+    const int initialFood = resourceSystem.getResourceAmount("food");
+
+    NPCController npcController;
+    npcController.init(registry);
+    npcController.setResourceSystem(&resourceSystem);
+
+    AISystem aiSystem;
+    aiSystem.init(registry);
+    aiSystem.setNPCController(&npcController);
+
+    double totalMs = 0.0;
+    float maxMs = 0.f;
+    size_t totalBatches = 0;
+    size_t totalLeafRuns = 0;
+    for (int frame = 0; frame < kFrames; ++frame) {
+        npcController.update(kDeltaTime, registry);
+        aiSystem.update(kDeltaTime, registry, player);
+
+        const BehaviorTreeStats& stats = aiSystem.getBehaviorStats();
+        totalMs += stats.tickMs;
+        maxMs = std::max(maxMs, stats.tickMs);
+        totalBatches += stats.batches;
+        totalLeafRuns += stats.leafRuns;
+
+        // 代替移动和生存系统：按速度移动，饱食度按速率下降
+        auto view = registry.view<NPC, Transform, Velocity, Hunger>();
+        for (auto entity : view) {
+            view.get<Transform>(entity).position += view.get<Velocity>(entity).velocity * kDeltaTime;
+            auto& hunger = view.get<Hunger>(entity);
+            hunger.current = std::max(0.f, hunger.current - hunger.drainRate * kDeltaTime);
+        }
+    }
+
+    std::printf("%d 个 NPC, %d 帧: 行为树 tick 平均 %.3f ms, 最大 %.3f ms (每帧平均 %zu 批, %zu 次叶子)\n",
+                kNPCs, kFrames, totalMs / kFrames, maxMs, totalBatches / kFrames, totalLeafRuns / kFrames);
+    std::printf("吃掉的食物: %d 份\n", initialFood - resourceSystem.getResourceAmount("food"));
+    return 0;
+}
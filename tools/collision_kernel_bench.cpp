@@ -0,0 +1,68 @@
+﻿// 碰撞批处理内核微基准（标量 vs SIMD）
+// 构建：cmake -DNIGHTFALL_BUILD_TOOLS=ON [-DNIGHTFALL_ENABLE_AVX2=ON]，目标 collision_kernel_bench
+#include "systems/CollisionKernel.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace Nightfall;
+
+template<typename Func>
+double measureMs(int iterations, Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        func();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main() {
+    const size_t pairCounts[] = {256, 4096, 65536};
+    const int iterations = 200;
+
+    std::printf("生效路径: %s\n", CollisionKernel::getActivePathName());
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> position(0.f, 256.f);
+    std::uniform_real_distribution<float> size(8.f, 48.f);
+
+    for (size_t pairCount : pairCounts) {
+        AABBPairBatch batch;
+        batch.reserve(pairCount);
+        for (size_t i = 0; i < pairCount; ++i) {
+            sf::FloatRect a({position(rng), position(rng)}, {size(rng), size(rng)});
+            sf::FloatRect b({position(rng), position(rng)}, {size(rng), size(rng)});
+            batch.push(a, b);
+        }
+
+        std::vector<std::uint32_t> scalarHits, simdHits;
+        std::vector<float> scalarX, scalarY, simdX, simdY;
+
+        double scalarOverlapMs = measureMs(iterations, [&] {
+            scalarHits.clear();
+            CollisionKernel::findOverlapsScalar(batch, scalarHits);
+        });
+        double simdOverlapMs = measureMs(iterations, [&] {
+            simdHits.clear();
+            CollisionKernel::findOverlaps(batch, simdHits);
+        });
+        double scalarPushMs = measureMs(iterations, [&] {
+            CollisionKernel::computePushOutScalar(batch, scalarX, scalarY);
+        });
+        double simdPushMs = measureMs(iterations, [&] {
+            CollisionKernel::computePushOut(batch, simdX, simdY);
+        });
+
+        bool match = scalarHits == simdHits && scalarX == simdX && scalarY == simdY;
+
+        std::printf("%6zu 对  相交 %5zu | 重叠测试 %.4f ms -> %.4f ms (x%.2f) | 推出向量 %.4f ms -> %.4f ms (x%.2f) | %s\n",
+                    pairCount, scalarHits.size(),
+                    scalarOverlapMs, simdOverlapMs, scalarOverlapMs / simdOverlapMs,
+                    scalarPushMs, simdPushMs, scalarPushMs / simdPushMs,
+                    match ? "结果一致" : "结果不一致!");
+        if (!match) return 1;
+    }
+
+    return 0;
+}
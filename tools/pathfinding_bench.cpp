@@ -0,0 +1,189 @@
+﻿// 寻路基准 - 1024×1024 网格上 50 条跨地图路径（整图 A* / HPA* / JPS）与重复差事路线的缓存
+// 构建：cmake -DNIGHTFALL_BUILD_TOOLS=ON，目标 pathfinding_bench
+#include "ai/Pathfinding.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace Nightfall;
+
+template<typename Func>
+double measureMs(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main() {
+    constexpr int kSize = 1024;
+    constexpr int kRequests = 50;
+    constexpr int kClusterSize = 16;
+
+    NavGrid grid;
+    grid.resize(sf::FloatRect({0.f, 0.f}, {static_cast<float>(kSize), static_cast<float>(kSize)}), 1.f);
+
+    // 随机墙段（约 12% 的格子被阻挡）
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> coord(0, kSize - 1);
+    std::uniform_int_distribution<int> length(4, 40);
+    for (int i = 0; i < 6000; ++i) {
+        const int x = coord(rng);
+        const int y = coord(rng);
+        const int len = length(rng);
+        const bool horizontal = (rng() & 1) != 0;
+        for (int k = 0; k < len; ++k) {
+            const int cx = horizontal ? x + k : x;
+            const int cy = horizontal ? y : y + k;
+            if (grid.inBounds(cx, cy)) grid.setBlocked(cx, cy, true);
+        }
+    }
+
+    // 起点在最左侧的 1/8，终点在最右侧的 1/8
+    std::vector<std::pair<int, int>> requests;
+    std::uniform_int_distribution<int> left(0, kSize / 8);
+    std::uniform_int_distribution<int> right(kSize - kSize / 8, kSize - 1);
+    while (static_cast<int>(requests.size()) < kRequests) {
+        int start = grid.toIndex(left(rng), coord(rng));
+        int goal = grid.toIndex(right(rng), coord(rng));
+        if (!grid.isBlocked(start) && !grid.isBlocked(goal)) {
+            requests.emplace_back(start, goal);
+        }
+    }
+
+    HierarchicalPathfinder hierarchy;
+    HierarchicalPathfinder::QueryContext context;
+    GridSearch buildSearch;
+    double buildMs = measureMs([&] { hierarchy.build(grid, kClusterSize, buildSearch); });
+    std::printf("抽象图构建: %.1f ms (%zu 个簇, %zu 个入口)\n",
+                buildMs, hierarchy.getClusterCount(), hierarchy.getPortalCount());
+
+    // 基准：整张网格上的 A*
+    GridSearch search;
+    const CellRect whole{0, 0, kSize - 1, kSize - 1};
+    std::vector<int> path;
+    float flatCost = 0.f;
+    int flatFound = 0;
+    double flatMs = measureMs([&] {
+        for (const auto& request : requests) {
+            float cost;
+            if (search.findPath(grid, request.first, request.second, whole, path, cost)) {
+                ++flatFound;
+                flatCost += cost;
+            }
+        }
+    });
+
+    // HPA*：只查询抽象路线（代理只细化身边的一段）
+    std::vector<int> route;
+    int routeFound = 0;
+    double routeMs = measureMs([&] {
+        for (const auto& request : requests) {
+            if (hierarchy.findRoute(grid, request.first, request.second, route, context)) ++routeFound;
+        }
+    });
+
+    // HPA*：抽象路线 + 全部细化
+    float hpaCost = 0.f;
+    double fullMs = measureMs([&] {
+        for (const auto& request : requests) {
+            if (hierarchy.findPath(grid, request.first, request.second, path, context)) {
+                for (size_t i = 1; i < path.size(); ++i) {
+                    const int dx = path[i] % kSize - path[i - 1] % kSize;
+                    const int dy = path[i] / kSize - path[i - 1] / kSize;
+                    hpaCost += (dx != 0 && dy != 0) ? 1.41421356f : 1.f;
+                }
+            }
+        }
+    });
+
+    std::printf("整图 A*:            %8.2f ms  (找到 %d/%d)\n", flatMs, flatFound, kRequests);
+    std::printf("HPA* 抽象路线:      %8.2f ms  (找到 %d/%d)\n", routeMs, routeFound, kRequests);
+    std::printf("HPA* 路线+全部细化: %8.2f ms  (路径长度为最优的 %.1f%%)\n",
+                fullMs, flatCost > 0.f ? hpaCost / flatCost * 100.f : 0.f);
+
+    // 跳点搜索：与整图 A* 同为最优路径
+    JumpPointSearch jumpSearch;
+    float jpsCost = 0.f;
+    int jpsFound = 0;
+    size_t jpsExpanded = 0;
+    double jpsMs = measureMs([&] {
+        for (const auto& request : requests) {
+            float cost;
+            if (jumpSearch.findPath(grid, request.first, request.second, path, cost)) {
+                ++jpsFound;
+                jpsCost += cost;
+            }
+            jpsExpanded += jumpSearch.getLastExpandedCount();
+        }
+    });
+    std::printf("跳点搜索 (JPS):     %8.2f ms  (找到 %d/%d, 路径长度为 A* 的 %.2f%%, 平均展开 %zu 个跳点)\n",
+                jpsMs, jpsFound, kRequests, flatCost > 0.f ? jpsCost / flatCost * 100.f : 0.f,
+                jpsExpanded / kRequests);
+
+    // NPC 差事：少量固定路线反复查询（去工作台、回床位），走 LRU 缓存
+    constexpr int kErrandRoutes = 16;
+    constexpr int kErrands = 2000;
+    std::vector<std::pair<int, int>> routes;
+    std::uniform_int_distribution<int> nearby(-48, 48);
+    while (static_cast<int>(routes.size()) < kErrandRoutes) {
+        const int x = coord(rng);
+        const int y = coord(rng);
+        const int tx = x + nearby(rng);
+        const int ty = y + nearby(rng);
+        if (!grid.inBounds(tx, ty)) continue;
+        const int start = grid.toIndex(x, y);
+        const int goal = grid.toIndex(tx, ty);
+        float cost;
+        if (jumpSearch.findPath(grid, start, goal, path, cost)) routes.emplace_back(start, goal);   // 只取可达的路线
+    }
+
+    std::uniform_int_distribution<int> pick(0, kErrandRoutes - 1);
+    std::vector<int> errands(kErrands);
+    for (auto& errand : errands) errand = pick(rng);
+
+    double aStarErrandMs = measureMs([&] {
+        for (int errand : errands) {
+            float cost;
+            search.findPath(grid, routes[errand].first, routes[errand].second, whole, path, cost);
+        }
+    });
+    double jpsErrandMs = measureMs([&] {
+        for (int errand : errands) {
+            float cost;
+            jumpSearch.findPath(grid, routes[errand].first, routes[errand].second, path, cost);
+        }
+    });
+
+    PathCache cache(64);
+    double cachedErrandMs = measureMs([&] {
+        for (int errand : errands) {
+            const auto& route = routes[errand];
+            if (cache.find(route.first, route.second, 0)) continue;
+            float cost;
+            jumpSearch.findPath(grid, route.first, route.second, path, cost);
+            cache.store(route.first, route.second, 0, path);
+        }
+    });
+    std::printf("%d 次差事寻路 (%d 条路线): A* %.2f ms, JPS %.2f ms, JPS+缓存 %.2f ms (命中率 %.1f%%)\n",
+                kErrands, kErrandRoutes, aStarErrandMs, jpsErrandMs, cachedErrandMs,
+                100.f * cache.getHits() / static_cast<float>(cache.getHits() + cache.getMisses()));
+
+    // 放置一堵墙：只重建它接触的簇
+    std::vector<int> changed;
+    for (int k = 0; k < 8; ++k) {
+        const int x = kSize / 2 + k;
+        const int y = kSize / 2;
+        if (!grid.isBlocked(grid.toIndex(x, y))) {
+            grid.setBlocked(x, y, true);
+            changed.push_back(grid.toIndex(x, y));
+        }
+    }
+    size_t rebuilt = 0;
+    double refreshMs = measureMs([&] {
+        hierarchy.invalidateCells(grid, changed);
+        rebuilt = hierarchy.refresh(grid, buildSearch);
+    });
+    std::printf("放置墙体后重建: %.3f ms (%zu 个簇)\n", refreshMs, rebuilt);
+    return 0;
+}